@@ -3,27 +3,18 @@
 #include <cstring>
 #include <vector>
 #include <utility>
+#include <thread>
 
 #include "./utils.h"
 #include "./dataprocessing.h"
 #include "./filectrl.h"
+#include "./profiler.h"
+#include "./bench.h"
+#include "./cohort.h"
 
 
 using std::string; using std::vector; using std::ifstream;
 
-namespace util {
-	std::string ABR_INPUT_DIR = "./";
-	std::string ABR_TYPEFACE_DIR = "./";
-	std::string ABR_TYPEFACE_NAME = "Consolas";
-	std::string ABR_OUTPUT_DIR = "./";
-	std::string ABR_OUTPUT_EXT = "PNG";
-	bool ABR_RUN_DEBUG = false;
-
-	bool batch = false;
-	bool raw = false;
-	bool flagsUsed = false;
-}
-
 
 int main(int argc, char** argv) {
 	std::string source = "";
@@ -31,11 +22,19 @@ int main(int argc, char** argv) {
 	try {
 		//Store the command line arguments, ensuring that they were properly parsed
 		int res = util::AbrPrint_HandleCLO(
-			argc, argv, &source, &util::batch, &util::raw, &util::flagsUsed
+			argc, argv, &source, &util::batch, &util::raw, &util::flagsUsed, &util::stream
 			);
 
 		if (res == 1) return 0;
 		else if (res != 0) throw "AbrPrint: Error handling command-line arguments";
+
+		//STDOUT belongs to the image while streaming, so send all console text to STDERR
+		if (util::stream) std::cout.rdbuf(std::cerr.rdbuf());
+
+		//Only pay for the stage timers when a report or trace was asked for
+		prof::enabled = util::statsPath != "" || util::tracePath != "";
+		prof::memory = util::memStats;
+		prof::tracing = util::tracePath != "";
 	}
 	catch (std::string err) {
 		std::cout << err << std::endl;
@@ -51,6 +50,42 @@ int main(int argc, char** argv) {
 	}
 
 
+	//Writing a synthetic summary needs neither the configuration nor the graphics libraries
+	if (util::generatePath != "") {
+		ABR_DEBUG(1, "Generating synthetic summary");
+		try {
+			bench::summarySpec_t spec = {
+				util::generateRows, util::generateColumns, util::generateDensity,
+				util::generateMultiHit, util::generateSeed
+			};
+
+			if (util::generatePath == "-") bench::writeSummary(spec, &std::cout);
+			else {
+				std::ofstream out(util::generatePath, std::ios::out | std::ios::trunc | std::ios::binary);
+				if (!out.is_open())
+					throw "main(): Error opening summary file " + util::generatePath;
+				bench::writeSummary(spec, &out);
+				out.close();
+			}
+		}
+		catch (const char* err) {
+			std::cerr << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cerr << err << std::endl;
+			return 1;
+		}
+		catch (...) {
+			std::cerr << "Unknown error occurred" << std::endl;
+			return 1;
+		}
+
+		ABR_DEBUG(1, "Making clean exit");
+		return 0;
+	}
+
+
 	//Initialize SDL first. If SDL is going to fail on this run, you don't want it to happen
 	// after the cycles have already been spent processing data
 	try {
@@ -58,7 +93,7 @@ int main(int argc, char** argv) {
 		util::AbrPrint_Init();
 
 		//Initialize the graphics and text library
-		util::debug(1, "Initializing graphics libraries");
+		ABR_DEBUG(1, "Initializing graphics libraries");
 		if (SDL_Init(SDL_INIT_VIDEO) < 0) throw "main(): " + (string)SDL_GetError();
 		if (TTF_Init() < 0) throw "main(): " + (string)TTF_GetError();
 	}
@@ -79,7 +114,10 @@ int main(int argc, char** argv) {
 	//Gather the filename list from the input directory information
 	std::string directory;
 	std::vector<std::string> filenameList;
-	util::debug(1, "Beginning to gather list of filenames");
+	filectrl::outputGroups_t outputGroups;
+	const filectrl::outputGroups_t* outputs = util::abricateOutputs ? &outputGroups : nullptr;
+	int outputThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	ABR_DEBUG(1, "Beginning to gather list of filenames");
 	try {
 		if (source == "" && !util::flagsUsed) util::batch = true;
 
@@ -106,10 +144,28 @@ int main(int argc, char** argv) {
 			return 1;
 		}
 
-		util::debug(1, "File names gathered:");
-		for (std::string name : filenameList)
-			util::debug(1, "- " + name);
-		util::debug(1, "");
+		ABR_DEBUG(1, "File names gathered:");
+		for (const std::string& name : filenameList)
+			ABR_DEBUG(1, "- " + name);
+		ABR_DEBUG(1, "");
+
+		//Raw Abricate outputs are graphed by sample, so the list becomes the samples
+		// they were grouped under
+		if (util::abricateOutputs) {
+			filectrl::groupOutputs(filenameList, &outputGroups);
+			if (outputGroups.empty()) {
+				std::cout << "main(): No Abricate outputs (SAMPLE_database_out.tab) found in " << directory << std::endl;
+				return 1;
+			}
+
+			filenameList.clear();
+			ABR_DEBUG(1, "Samples gathered:");
+			for (const auto& group : outputGroups) {
+				ABR_DEBUG(1, "- " + group.first + " (" + std::to_string(group.second.size()) + " outputs)");
+				filenameList.push_back(group.first);
+			}
+			ABR_DEBUG(1, "");
+		}
 	}
 	catch (...) {
 		std::cout << "Unknown error occurred" << std::endl;
@@ -117,18 +173,82 @@ int main(int argc, char** argv) {
 	}
 
 
+	//Ingesting and reporting parse the whole directory and draw nothing, so they're
+	// done before any of the graphics elements are made
+	if (util::ingestPath != "" || util::reportPath != "") {
+		ABR_DEBUG(1, "Beginning cohort run");
+		try {
+			unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+			if (util::ingestPath != "") {
+				ABR_DEBUG(1, "Ingesting summaries into a cohort store");
+				cohort::store_t store = cohort::ingest(directory, filenameList, outputs, threads);
+
+				ABR_DEBUG(1, "Writing cohort store to " + util::ingestPath);
+				cohort::writeStore(store, util::ingestPath);
+				std::cout << "Ingested " << store.identity.size() << " hits from "
+					<< store.samples.size() << " samples into " << util::ingestPath << std::endl;
+			}
+			if (util::reportPath != "") {
+				ABR_DEBUG(1, "Totalling database statistics");
+				cohort::statsReport_t report = cohort::reduceStats(directory, filenameList, outputs, threads);
+
+				ABR_DEBUG(1, "Writing statistics report to " + util::reportPath);
+				cohort::writeStatsReport(report, util::reportPath);
+				std::cout << "Reported on " << report.databases.size() << " databases from "
+					<< report.samples << " samples into " << util::reportPath << std::endl;
+			}
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (...) {
+			std::cout << "Unknown error occurred" << std::endl;
+			return 1;
+		}
+		ABR_DEBUG(1, "Cohort run complete\n");
+
+		//Write out the stage timings and trace if they were requested
+		try {
+			if (util::statsPath != "") {
+				ABR_DEBUG(1, "Writing stage timing report");
+				prof::writeReport(util::statsPath);
+			}
+			if (util::tracePath != "") {
+				ABR_DEBUG(1, "Writing timeline trace");
+				prof::writeTrace(util::tracePath);
+			}
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+
+		ABR_DEBUG(1, "Closing down graphics libraries");
+		TTF_Quit();
+		SDL_Quit();
+
+		ABR_DEBUG(1, "Making clean exit");
+		return 0;
+	}
+
+
 	//Generate some of the things necessary for creating graphs
 	SDL_Surface* surf; SDL_Renderer* renderer; SDL_Texture* visualizer; TTF_Font* font;
-	util::debug(1, "Creating necessary SDL2 graphics elements");
+	ABR_DEBUG(1, "Creating necessary SDL2 graphics elements");
 	try {
-		util::debug(1, "  Generating the renderer");
+		ABR_DEBUG(1, "  Generating the renderer");
 		renderer = util::generateRenderer(&surf);
 
-		util::debug(1, "  Generating the visualizer");
+		ABR_DEBUG(1, "  Generating the visualizer");
 		visualizer = util::generateTexture(renderer);
 
-		util::debug(1, "  Generating the typeface");
-		font = util::getFont("Consolas", 24);
+		ABR_DEBUG(1, "  Generating the typeface");
+		font = util::getFont("Consolas", util::scaled(24));
 	}
 	catch (const char* err) {
 		std::cout << err << std::endl;
@@ -142,34 +262,431 @@ int main(int argc, char** argv) {
 		std::cout << "Unknown error occurred" << std::endl;
 		return 1;
 	}
-	util::debug(1, "  All elements successfully created\n");
+	ABR_DEBUG(1, "  All elements successfully created\n");
+
+	//Every graph is saved once for each output target, or just once in the configured
+	// file type when no targets were given
+	vector<util::outputTarget_t> targets = util::outputTargets;
+	if (targets.empty()) targets.push_back({ util::ABR_OUTPUT_EXT, 0, 0, DEFAULT_JPEG_QUALITY });
+	vector<vector<unsigned char>> encodedTargets;
+
+	//The targets of each graph are encoded, and large graphs drawn in bands, on workers
+	// that stay up for the whole run
+	util::workerPool_t workers;
+	util::startPool(&workers, std::max(1u, std::thread::hardware_concurrency()));
+
+	//A benchmark run times every stage against the source files and exits without saving
+	if (util::benchIterations > 0) {
+		ABR_DEBUG(1, "Beginning benchmark run");
+		try {
+			bench::runBenchmarks(
+				renderer, visualizer, font, directory, filenameList,
+				util::benchIterations, &std::cout
+			);
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (...) {
+			std::cout << "Unknown error occurred" << std::endl;
+			return 1;
+		}
+		ABR_DEBUG(1, "Benchmark run complete\n");
+
+		//Clean up the dynamically allocated objects and exit
+		ABR_DEBUG(1, "Cleaning current texture");
+		SDL_DestroyTexture(visualizer);
+		ABR_DEBUG(1, "Releasing the cached text and font");
+		util::releaseTextCache(renderer);
+		TTF_CloseFont(font);
+		ABR_DEBUG(1, "Freeing renderer's generated surface");
+		SDL_FreeSurface(surf);
+
+		ABR_DEBUG(1, "Closing down graphics libraries");
+		TTF_Quit();
+		SDL_Quit();
+
+		ABR_DEBUG(1, "Making clean exit");
+		return 0;
+	}
+
+	//A verification run checks every graph against its golden image, failing the run
+	// if any of them differ or if graphing has slowed down
+	if (util::verifyDir != "") {
+		ABR_DEBUG(1, "Beginning verification run");
+		int failures = 0;
+		try {
+			failures = bench::verifyGraphs(
+				renderer, visualizer, font, &workers, directory, filenameList, targets,
+				util::verifyDir, util::verifyTolerance, util::verifyMaxSlowdown, util::verifyBless,
+				&std::cout
+			);
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (...) {
+			std::cout << "Unknown error occurred" << std::endl;
+			return 1;
+		}
+		ABR_DEBUG(1, "Verification run complete, " + std::to_string(failures) + " failures\n");
+
+		//Clean up the dynamically allocated objects and exit
+		ABR_DEBUG(1, "Cleaning current texture");
+		SDL_DestroyTexture(visualizer);
+		ABR_DEBUG(1, "Releasing the cached text and font");
+		util::releaseTextCache(renderer);
+		TTF_CloseFont(font);
+		ABR_DEBUG(1, "Freeing renderer's generated surface");
+		SDL_FreeSurface(surf);
+
+		ABR_DEBUG(1, "Closing down graphics libraries");
+		TTF_Quit();
+		SDL_Quit();
+
+		ABR_DEBUG(1, "Making clean exit");
+		return failures == 0 ? 0 : 1;
+	}
+
+	//A mosaic parses every file up front, then draws all of the graphs at once
+	if (util::mosaic) {
+		ABR_DEBUG(1, "Beginning mosaic generation");
+		vector<TTF_Font*> workerFonts = { font };
+		try {
+			//Parse each of the files into a tile for the mosaic
+			vector<proc::mosaicTile_t> tiles;
+			proc::workspace_t workspace;
+			filectrl::reader_t reader;
+			for (const std::string& filename : filenameList) {
+				ABR_DEBUG(1, "Parsing data from file " + filename);
+				prof::fileScope_t fileScope(filename);
+				proc::mosaicTile_t tile;
+				tile.title = filename;
+
+				//A cache that still matches its summary stands in for parsing it, and a
+				// sample's raw outputs are summarised in place of reading one
+				string sourcePath = directory + filename, cachePath = sourcePath + ".abrc";
+				if (util::abricateOutputs)
+					proc::makeSummary(directory, outputGroups[filename], &workspace, outputThreads);
+				else if (!util::tableCache || !proc::loadCache(cachePath, sourcePath, &workspace)) {
+					filectrl::loadFile(directory, filename, &reader);
+					proc::makeLabels(filename, &reader.in, &workspace);
+					proc::makeTable(filename, workspace.labels, &reader.in, &workspace);
+					filectrl::closeFile(&reader);
+
+					if (util::tableCache && !proc::saveCache(cachePath, sourcePath, workspace))
+						ABR_DEBUG(1, "Unable to write cache file " + cachePath);
+				}
+				tile.labels = workspace.labels;
+				tile.table = workspace.table;
+
+				tiles.push_back(std::move(tile));
+			}
+
+			//Every worker thread needs a typeface of its own
+			ABR_DEBUG(1, "Opening typefaces for worker threads");
+			size_t workerCount = std::thread::hardware_concurrency();
+			if (workerCount == 0) workerCount = 1;
+			if (workerCount > tiles.size()) workerCount = tiles.size();
+			while (workerFonts.size() < workerCount)
+				workerFonts.push_back(util::getFont("Consolas", util::scaled(24)));
+
+			//Draw the tiles, then encode and save the finished canvas
+			ABR_DEBUG(1, "Rendering mosaic");
+			SDL_Surface* canvas = proc::renderMosaic(
+				tiles, workerFonts, util::IMG_W, util::IMG_H, util::mosaicTileW, util::mosaicTileH,
+				util::mosaicColumns
+			);
+
+			ABR_DEBUG(1, "Saving finished mosaic to file");
+			try {
+				filectrl::encodeTargets(canvas, targets, &encodedTargets, &workers);
+			}
+			catch (...) {
+				SDL_FreeSurface(canvas);
+				throw;
+			}
+			SDL_FreeSurface(canvas);
+			for (size_t t = 0; t < targets.size(); t++)
+				filectrl::saveEncodedToFile(
+					encodedTargets[t], "mosaic", targets[t].type, util::ABR_OUTPUT_DIR,
+					filectrl::targetGraphType(targets[t], "bargraph")
+				);
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (...) {
+			std::cout << "Unknown error occurred" << std::endl;
+			return 1;
+		}
+		ABR_DEBUG(1, "Mosaic saved to file\n");
+
+		//Write out the stage timings and trace if they were requested
+		try {
+			if (util::statsPath != "") {
+				ABR_DEBUG(1, "Writing stage timing report");
+				prof::writeReport(util::statsPath);
+			}
+			if (util::tracePath != "") {
+				ABR_DEBUG(1, "Writing timeline trace");
+				prof::writeTrace(util::tracePath);
+			}
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+
+		//Clean up the dynamically allocated objects and exit
+		ABR_DEBUG(1, "Cleaning current texture");
+		SDL_DestroyTexture(visualizer);
+		ABR_DEBUG(1, "Releasing the fonts");
+		for (TTF_Font* workerFont : workerFonts) TTF_CloseFont(workerFont);
+		ABR_DEBUG(1, "Freeing renderer's generated surface");
+		SDL_FreeSurface(surf);
+
+		ABR_DEBUG(1, "Closing down graphics libraries");
+		TTF_Quit();
+		SDL_Quit();
+
+		ABR_DEBUG(1, "Making clean exit");
+		return 0;
+	}
+
+	//A heatmap gathers every file into one grid. A single file gets a row per FILE entry,
+	// while a batch collapses each file down to a single row for the whole cohort
+	if (util::heatmap) {
+		ABR_DEBUG(1, "Beginning heatmap generation");
+		try {
+			//A cohort store already holds every sample, so it's read in place of the
+			// summaries it was made from
+			bool fromStore = filenameList.size() == 1 && filenameList[0].length() > 5 &&
+				filenameList[0].compare(filenameList[0].length() - 5, 5, ".abrs") == 0;
+			bool cohort = filenameList.size() > 1 || fromStore;
+			size_t samples = filenameList.size();
+			proc::heatmap_t heatmap;
+			proc::workspace_t workspace;
+			filectrl::reader_t reader;
+			if (fromStore) {
+				ABR_DEBUG(1, "Reading cohort store " + filenameList[0]);
+				cohort::store_t store = cohort::readStore(directory + filenameList[0]);
+				cohort::addStoreRows(&heatmap, store);
+				samples = store.samples.size();
+			}
+			else for (const std::string& filename : filenameList) {
+				ABR_DEBUG(1, "Parsing data from file " + filename);
+				prof::fileScope_t fileScope(filename);
+
+				//A cache that still matches its summary stands in for parsing it, and a
+				// sample's raw outputs are summarised in place of reading one
+				string sourcePath = directory + filename, cachePath = sourcePath + ".abrc";
+				if (util::abricateOutputs)
+					proc::makeSummary(directory, outputGroups[filename], &workspace, outputThreads);
+				else if (!util::tableCache || !proc::loadCache(cachePath, sourcePath, &workspace)) {
+					std::istream* src = &std::cin;
+					if (!util::stream) {
+						filectrl::loadFile(directory, filename, &reader);
+						src = &reader.in;
+					}
+					proc::makeLabels(filename, src, &workspace);
+					proc::makeTable(filename, workspace.labels, src, &workspace);
+					if (!util::stream) filectrl::closeFile(&reader);
+
+					if (util::tableCache && !proc::saveCache(cachePath, sourcePath, workspace))
+						ABR_DEBUG(1, "Unable to write cache file " + cachePath);
+				}
+
+				proc::addHeatmapRows(&heatmap, workspace.labels, workspace.table, cohort, filename);
+			}
+
+			//Draw the heatmap and send it to its destination
+			ABR_DEBUG(1, "Rendering heatmap");
+			std::string title = cohort ?
+				"Cohort heatmap (" + std::to_string(samples) + " samples)" :
+				filenameList[0];
+			proc::renderHeatmap(
+				renderer, visualizer, font, title, heatmap, util::IMG_W, util::IMG_H
+			);
+
+			ABR_DEBUG(1, "Saving finished heatmap");
+			if (util::stream)
+				filectrl::writeGraphToStdout(renderer, util::ABR_OUTPUT_EXT, visualizer);
+			else {
+				filectrl::encodeTargets(
+					filectrl::readGraph(renderer, visualizer), targets, &encodedTargets, &workers
+				);
+				for (size_t t = 0; t < targets.size(); t++)
+					filectrl::saveEncodedToFile(
+						encodedTargets[t], cohort ? "cohort" : filenameList[0], targets[t].type,
+						util::ABR_OUTPUT_DIR, filectrl::targetGraphType(targets[t], "heatmap")
+					);
+			}
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (...) {
+			std::cout << "Unknown error occurred" << std::endl;
+			return 1;
+		}
+		ABR_DEBUG(1, "Heatmap saved\n");
+
+		//Write out the stage timings and trace if they were requested
+		try {
+			if (util::statsPath != "") {
+				ABR_DEBUG(1, "Writing stage timing report");
+				prof::writeReport(util::statsPath);
+			}
+			if (util::tracePath != "") {
+				ABR_DEBUG(1, "Writing timeline trace");
+				prof::writeTrace(util::tracePath);
+			}
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+
+		//Clean up the dynamically allocated objects and exit
+		ABR_DEBUG(1, "Cleaning current texture");
+		SDL_DestroyTexture(visualizer);
+		ABR_DEBUG(1, "Releasing the cached text and font");
+		util::releaseTextCache(renderer);
+		TTF_CloseFont(font);
+		ABR_DEBUG(1, "Freeing renderer's generated surface");
+		SDL_FreeSurface(surf);
+
+		ABR_DEBUG(1, "Closing down graphics libraries");
+		TTF_Quit();
+		SDL_Quit();
+
+		ABR_DEBUG(1, "Making clean exit");
+		return 0;
+	}
+
+	//When bundling, every graph from the batch goes into the one archive file
+	filectrl::archive_t archive;
+	if (util::archivePath != "") {
+		ABR_DEBUG(1, "Opening output archive " + util::archivePath);
+		try {
+			filectrl::openArchive(&archive, util::archivePath);
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+	}
+
+	//The parsed tables, graph metadata, input stream and encoded images are reused from
+	// file to file, so once the largest file has gone through the loop stops allocating
+	proc::workspace_t workspace;
+	filectrl::reader_t reader;
+	std::string sourcePath, cachePath;
+
+	//Graphs of 4K and up are recorded rather than drawn, then drawn onto a canvas in
+	// bands on every core. Each worker keeps its own typeface, band and cached text for
+	// the whole batch
+	bool banded = (long long)util::IMG_W * util::IMG_H >= BANDED_MIN_PIXELS;
+	util::displayList_t displayList;
+	SDL_Surface* canvas = nullptr;
+	proc::bandCanvas_t bands;
+	bands.fonts = { font };
+	if (banded) {
+		ABR_DEBUG(1, "Opening typefaces for banded drawing");
+		try {
+			while (bands.fonts.size() < workers.threads.size() + 1)
+				bands.fonts.push_back(util::getFont("Consolas", util::scaled(24)));
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+	}
+
+	//Each target's graph type is built once, so naming the graphs doesn't allocate
+	vector<std::string> graphTypes;
+	for (const util::outputTarget_t& target : targets)
+		graphTypes.push_back(filectrl::targetGraphType(target, "bargraph"));
 
 	//Iterate through the list of filenames from the list
-	util::debug(1, "Beginning graph generation");
-	for (std::string filename : filenameList) {
-		util::debug(1, "Processing file " + filename);
+	ABR_DEBUG(1, "Beginning graph generation");
+	for (const std::string& filename : filenameList) {
+		ABR_DEBUG(1, "Processing file " + filename);
+		prof::scopedTimer_t fileTimer("graph");
+		prof::fileScope_t fileScope(filename);
 
 		//Gather the file's labels and populate a table for the data
-		vector<string> labels;
-		vector<vector<string>> table;
-		util::debug(1, "Parsing data from file");
+		ABR_DEBUG(1, "Parsing data from file");
 		try {
-			//Use the filename to open the source file
-			util::debug(1, "Opening input stream");
-			ifstream src = filectrl::loadFile(directory, filename);
-
-			//Read in the entire header from the file being processed
-			util::debug(1, "Gathering data labels from the file");
-			labels = proc::makeLabels(filename, &src);
-
-			//Create a 2D vector table. The outer vector will be the columns, each identified
-			// with the index of their title in the labels vector. The inner vector will be
-			// the data itself
-			util::debug(1, "Gathering data from the file");
-			table = proc::makeTable(filename, labels, &src);
-			
-			util::debug(1, "Closing file input stream");
-			src.close();
+			//A cache that still matches its summary stands in for parsing it
+			bool cached = false;
+			if (util::tableCache) {
+				ABR_DEBUG(1, "Checking for a cached copy of the file");
+				sourcePath.assign(directory).append(filename);
+				cachePath.assign(sourcePath).append(".abrc");
+				cached = proc::loadCache(cachePath, sourcePath, &workspace);
+			}
+
+			if (util::abricateOutputs) {
+				ABR_DEBUG(1, "Summarising the sample's Abricate outputs");
+				proc::makeSummary(directory, outputGroups[filename], &workspace, outputThreads);
+			}
+			else if (!cached) {
+				//Use the filename to open the source file, or read from STDIN when streaming
+				ABR_DEBUG(1, "Opening input stream");
+				std::istream* src = &std::cin;
+				if (!util::stream) {
+					filectrl::loadFile(directory, filename, &reader);
+					src = &reader.in;
+				}
+
+				//Read in the entire header from the file being processed
+				ABR_DEBUG(1, "Gathering data labels from the file");
+				proc::makeLabels(filename, src, &workspace);
+
+				//Create a 2D vector table. The outer vector will be the columns, each identified
+				// with the index of their title in the labels vector. The inner vector will be
+				// the data itself
+				ABR_DEBUG(1, "Gathering data from the file");
+				proc::makeTable(filename, workspace.labels, src, &workspace);
+
+				ABR_DEBUG(1, "Closing file input stream");
+				if (!util::stream) filectrl::closeFile(&reader);
+
+				//The cache only saves time, so a summary in a read-only directory is
+				// still graphed without one
+				if (util::tableCache && !proc::saveCache(cachePath, sourcePath, workspace))
+					ABR_DEBUG(1, "Unable to write cache file " + cachePath);
+			}
 		}
 		catch (const char* err) {
 			std::cout << err << std::endl;
@@ -183,61 +700,25 @@ int main(int argc, char** argv) {
 			std::cout << "Unknown error occurred" << std::endl;
 			return 1;
 		}
-		util::debug(1, "Data successfully parsed");
+		ABR_DEBUG(1, "Data successfully parsed");
 
 
-		util::debug(1, "Generating graph from parsed data");
+		ABR_DEBUG(1, "Generating graph from parsed data");
 		try {
-			//Fill the background and print the header of the graph
-			util::debug(1, "Filling background and print graph header");
-			util::fill(renderer, visualizer, util::ABR_BKGD_COLOR);
-			util::printText(
-				renderer, visualizer, filename, 75, 10, 24, 0,
-				util::ABR_GRAPH_COLOR1, font, nullptr
+			if (banded) {
+				displayList.ops.clear();
+				util::recording = &displayList;
+			}
+			proc::renderBarGraph(
+				renderer, visualizer, font, filename, workspace.labels, workspace.table,
+				util::IMG_W, util::IMG_H, &workspace
 			);
+			util::recording = nullptr;
 
-			//Discover the filename index
-			util::debug(1, "Scanning for filename index");
-			size_t fileindex = 0;
-			for (size_t x = 0; x < labels.size(); x++)
-				if (labels[x] == "FILE") fileindex = x;
-
-			//Store the position of the graph on the screen
-			util::debug(1, "Establishing graph frame position");
-			SDL_Rect framepos = { 75, 110, util::IMG_W - 125, util::IMG_H - 300 };
-
-			//Initialize some graph information
-			util::debug(1, "Initializing graph metadata");
-			proc::graphData_t graphInfo;
-			graphInfo.framepos = framepos;
-			//graphInfo.fileList = { table[fileindex], 0 };
-			graphInfo.fileList = std::vector<std::pair<std::string, int>>();
-			for (std::string file : table[fileindex])
-				graphInfo.fileList.push_back(std::pair<std::string, int>(file, 0));
-			graphInfo.vertDivisions = 10;
-			//Calculate the range of markers on the graph data
-			proc::getDataRange(table, &graphInfo);
-
-			//Print the graph frame that will show behind the data
-			util::debug(1, "Rendering graph frame to visualizer");
-			proc::printGraphFrame(renderer, visualizer, &graphInfo, font);
-
-			util::debug(1, "Generating graph bars from parsed data");
-			std::vector<proc::graphBar_t> barsList =
-				proc::generateBars(graphInfo, labels, table);
-			proc::focusShortBars(&barsList);
-
-			//Print the color keys at the top of the graph frame
-			util::debug(1, "Rendering graph key to visualizer");
-			proc::printKeys(renderer, visualizer, labels, graphInfo, font);
-
-			//Draw each of the bars on under the graph
-			util::debug(1, "Rendering graph bars to visualizer");
-			proc::printBars(renderer, visualizer, barsList, font, false);
-
-			//Render the graph onto the window
-			util::debug(1, "Rendering texture to visual surface");
-			util::renderTexture(renderer, visualizer);
+			if (banded) {
+				ABR_DEBUG(1, "Drawing recorded graph in bands");
+				canvas = proc::rasterizeBands(displayList, &workers, &bands, util::IMG_W, util::IMG_H);
+			}
 		}
 		catch (const char* err) {
 			std::cout << err << std::endl;
@@ -251,16 +732,35 @@ int main(int argc, char** argv) {
 			std::cout << "Unknown error occurred" << std::endl;
 			return 1;
 		}
-		util::debug(1, "Graph generation complete");
+		ABR_DEBUG(1, "Graph generation complete");
 
 
-		//Save the graph to a file
-		util::debug(1, "Saving finished graph to file");
+		//Save the graph as each output target, or send it down the pipeline when streaming.
+		// A banded graph is on its canvas rather than the visualizer
+		ABR_DEBUG(1, "Saving finished graph to file");
 		try {
-			filectrl::saveGraphToFile(
-				renderer, filename, util::ABR_OUTPUT_EXT,
-				util::ABR_OUTPUT_DIR, "bargraph", visualizer
-			);
+			prof::scopedTimer_t saveTimer("saveGraphToFile");
+			if (util::stream && !banded)
+				filectrl::writeGraphToStdout(renderer, util::ABR_OUTPUT_EXT, visualizer);
+			else {
+				SDL_Surface* frame = banded ? canvas : filectrl::readGraph(renderer, visualizer);
+				filectrl::encodeTargets(frame, targets, &encodedTargets, &workers);
+
+				//The encodes all run at once, but the archive takes its members in order
+				for (size_t t = 0; t < targets.size(); t++) {
+					const std::string& graphType = graphTypes[t];
+					if (util::stream) filectrl::writeEncodedToStdout(encodedTargets[t]);
+					else if (util::archivePath != "")
+						filectrl::appendToArchive(
+							&archive, filectrl::graphFileName(filename, targets[t].type, graphType),
+							encodedTargets[t]
+						);
+					else
+						filectrl::saveEncodedToFile(
+							encodedTargets[t], filename, targets[t].type, util::ABR_OUTPUT_DIR, graphType
+						);
+				}
+			}
 		}
 		catch (const char* err) {
 			std::cout << err << std::endl;
@@ -274,26 +774,61 @@ int main(int argc, char** argv) {
 			std::cout << "Unknown error occurred" << std::endl;
 			return 1;
 		}
-		util::debug(1, "Graph saved to file\n");
+		ABR_DEBUG(1, "Graph saved to file\n");
+
+	}
 
+	//Finish off the archive with its index
+	if (util::archivePath != "") {
+		ABR_DEBUG(1, "Closing output archive");
+		try {
+			filectrl::closeArchive(&archive);
+		}
+		catch (const char* err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
+		catch (string err) {
+			std::cout << err << std::endl;
+			return 1;
+		}
 	}
 
 
+	//Write out the stage timings and trace if they were requested
+	try {
+		if (util::statsPath != "") {
+			ABR_DEBUG(1, "Writing stage timing report");
+			prof::writeReport(util::statsPath);
+		}
+		if (util::tracePath != "") {
+			ABR_DEBUG(1, "Writing timeline trace");
+			prof::writeTrace(util::tracePath);
+		}
+	}
+	catch (string err) {
+		std::cout << err << std::endl;
+		return 1;
+	}
+
 	//Clean up the dynamically allocated objects
-	util::debug(1, "Cleaning current texture");
+	ABR_DEBUG(1, "Cleaning current texture");
 	SDL_DestroyTexture(visualizer);
 	//SDL_DestroyWindow(window);
-	util::debug(1, "Releasing the font");
-	TTF_CloseFont(font);
+	ABR_DEBUG(1, "Releasing the cached text and fonts");
+	util::releaseTextCache(renderer);
+	proc::releaseBands(&workers, &bands);
+	util::stopPool(&workers);
+	for (TTF_Font* bandFont : bands.fonts) TTF_CloseFont(bandFont);
 
 	//Safely exit the graphics and text libraries.
-	util::debug(1, "Freeing renderer's generated surface");
+	ABR_DEBUG(1, "Freeing renderer's generated surface");
 	SDL_FreeSurface(surf);
 
-	util::debug(1, "Closing down graphics libraries");
+	ABR_DEBUG(1, "Closing down graphics libraries");
 	TTF_Quit();
 	SDL_Quit();
 
-	util::debug(1, "Making clean exit");
+	ABR_DEBUG(1, "Making clean exit");
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef ABRPRINT_H
+#define ABRPRINT_H
+
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+
+/*In-memory rendering interface for embedding AbrPrint in other programs. Nothing
+*  in this interface reads the configuration file or touches the filesystem; the
+*  table, font and encoded image are all passed around as buffers. Errors are thrown
+*  as std::string messages, the same as the rest of AbrPrint
+*
+* The libabrprint library is built from src/abrprint.cpp, src/dataprocessing.cpp,
+*  src/filectrl.cpp, src/utils.cpp, src/configuration.cpp, src/cohort.cpp and
+*  src/profiler.cpp, linked against SDL2, SDL2_image and SDL2_ttf (plus zlib and zstd
+*  when they are found). AbrPrint.cpp, src/bench.cpp and src/allochook.cpp belong to
+*  the AbrPrint program alone. The last of those replaces the global operator new,
+*  which a library must never do to the program that loads it
+*/
+namespace abr {
+
+	//This struct contains a parsed Abricate combined summary
+	struct table_t {
+		std::vector<std::string> labels;
+		std::vector<std::vector<std::string>> columns;
+	};
+
+	//This struct contains the rendering options for a single graph. The 1200x800 layout
+	// is scaled to fit width and height, and fontSize is the text size at 1200x800
+	struct style_t {
+		int width = 1200;
+		int height = 800;
+		std::string fileType = "PNG";
+		std::string title = "";
+		const unsigned char* fontData = nullptr;
+		size_t fontDataSize = 0;
+		int fontSize = 24;
+	};
+
+
+	/*Initializes the graphics and text libraries used for rendering. This must be
+	*  called once before any graphs are rendered
+	*/
+	void init();
+
+
+	/*Shuts down the graphics and text libraries started by init()*/
+	void quit();
+
+
+	/*Parses the text of an Abricate combined summary into a table
+	*
+	* Param buffer is the full text of the summary, header line included
+	* Returns the parsed table, with one column per label
+	*/
+	table_t parseTable(const std::string& buffer);
+
+
+	/*Renders a bar graph from a parsed table and encodes it as an image
+	*
+	* Precondition: init() has been called AND style.fontData != nullptr
+	*
+	* Param table is the parsed summary being graphed
+	* Param style is the set of rendering options for the graph
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> renderGraph(const table_t& table, const style_t& style);
+
+
+	/*Parses the text of an Abricate combined summary and renders it as an encoded image
+	*
+	* Precondition: init() has been called AND style.fontData != nullptr
+	*
+	* Param buffer is the full text of the summary, header line included
+	* Param style is the set of rendering options for the graph
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> renderGraph(const std::string& buffer, const style_t& style);
+
+}
+
+#endif
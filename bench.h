@@ -0,0 +1,107 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "./utils.h"
+
+
+namespace bench {
+
+	//This struct describes the shape of a synthetic Abricate summary
+	struct summarySpec_t {
+		long rows;
+		int genes;
+		double density;
+		double multiHit;
+		unsigned int seed;
+	};
+
+
+	/*Streams a synthetic Abricate summary, laid out exactly like the output of
+	*  abricate --summary with rows cycling through the usual databases. The same spec
+	*  always produces the same summary, byte for byte, on every platform
+	*
+	* Precondition: out != nullptr AND spec.rows >= 0 AND spec.genes > 0 AND
+	*		density and multiHit are between 0 and 1
+	*
+	* Param spec is the shape of the summary: its row and gene column counts, the share
+	*  of cells with a hit, the share of hits that list a second identity, and the seed
+	* Param out is the stream the summary is written to
+	*/
+	void writeSummary(const summarySpec_t& spec, std::ostream* out);
+
+
+	/*Builds a synthetic Abricate summary in memory
+	*
+	* Param spec is the shape of the summary (see writeSummary)
+	* Returns the full text of the summary, header included
+	*/
+	std::string syntheticSummary(const summarySpec_t& spec);
+
+
+	/*Times each of the hot stages of graph generation against the given summaries plus
+	*  a set of scaled-up synthetic ones, and writes one tab-separated line per stage and
+	*  input. Inputs are run in a fixed order and the columns never change, so two runs
+	*  can be compared with a plain diff or join
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer, texture and font are
+	*		not nullptr AND texture is util::IMG_W x util::IMG_H AND iterations > 0
+	* Postcondition: texture holds whatever was drawn last
+	*
+	* Param renderer is the SDL_Renderer used by the drawing stages
+	* Param texture is the SDL_Texture the drawing stages draw onto
+	* Param font is the TTF_Font used by the text stages
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to benchmark
+	* Param iterations is the number of timed runs of each stage on each input
+	* Param out is the stream the results are written to
+	*/
+	void runBenchmarks(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font,
+		std::string directory, std::vector<std::string> filenames, int iterations,
+		std::ostream* out
+	);
+
+
+
+	/*Renders every given summary as a bar graph and compares it against a golden image,
+	*  then times a few passes over the whole set to check that throughput hasn't dropped.
+	*  Goldens are PNGs named like normal output (e.g. test123_bargraph.png), and the
+	*  throughput baseline is kept in throughput.tsv beside them. Blessing writes the
+	*  current output and throughput as the new goldens and baseline instead. Graphs of
+	*  4K and up are drawn in bands on every core, the way the batch loop draws them
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer, texture and font are
+	*		not nullptr AND texture is util::IMG_W x util::IMG_H
+	* Postcondition: texture holds the last graph rendered, unless it was drawn in bands
+	*
+	* Param renderer is the SDL_Renderer used to draw the graphs
+	* Param texture is the SDL_Texture the graphs are drawn onto
+	* Param font is the TTF_Font used for the graphs' text
+	* Param workers is the worker pool that encodes the targets and draws banded graphs
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to verify
+	* Param targets is the list of images each graph is saved as, the way the batch
+	*  loop saves it, while checking for allocations
+	* Param goldenDir is the directory holding the golden images and throughput baseline
+	* Param tolerance is the largest difference allowed in any color channel of a pixel,
+	*  0 for an exact match
+	* Param maxSlowdown is the largest drop in graphs per second allowed, in percent
+	* Param bless is whether to write new goldens rather than compare against them
+	* Param out is the stream the results are written to
+	* Returns the number of checks that failed
+	*/
+	int verifyGraphs(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font,
+		util::workerPool_t* workers, std::string directory, std::vector<std::string> filenames,
+		const std::vector<util::outputTarget_t>& targets, std::string goldenDir, int tolerance,
+		double maxSlowdown, bool bless, std::ostream* out
+	);
+
+}
+
+#endif
@@ -0,0 +1,143 @@
+#ifndef COHORT_H
+#define COHORT_H
+
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "./utils.h"
+#include "./dataprocessing.h"
+#include "./filectrl.h"
+
+
+//Identity values are counted into this many bins in a stats report
+#define STATS_IDENTITY_BINS 5
+//The number of most-hit genes listed for each database in a stats report
+#define STATS_TOP_GENES 5
+
+
+namespace cohort {
+	using std::vector; using std::string;
+
+	//This struct holds every hit from a whole directory of summaries as one table, kept
+	// column by column. Each record is a single non-empty cell: the sample (summary file)
+	// it came from, the Abricate output file named on its row, the database column it
+	// sits in, and its identity. Strings are stored once in the dictionary and the
+	// columns hold their indices. A record's hits run from hitOffsets[r] up to
+	// hitOffsets[r + 1], so multi-hit cells keep every identity they listed
+	struct store_t {
+		vector<string> dictionary;
+		vector<uint32_t> samples;
+
+		vector<uint32_t> sample;
+		vector<uint32_t> source;
+		vector<uint32_t> database;
+		vector<double> identity;
+		vector<uint32_t> hitOffsets;
+		vector<double> hits;
+	};
+
+
+	//This struct holds the running totals for one Abricate database across a cohort.
+	// Each worker builds its own, and they are merged by adding them together
+	struct databaseStats_t {
+		size_t samples = 0;
+		size_t rows = 0, hitRows = 0;
+		size_t hits = 0;
+		size_t identities = 0;
+		double identitySum = 0, identityMin = 0, identityMax = 0;
+		size_t identityBins[STATS_IDENTITY_BINS] = {};
+		std::unordered_map<util::textId_t, size_t> geneHits;
+	};
+
+	//This struct holds the totals of every database seen across a cohort
+	struct statsReport_t {
+		size_t samples = 0;
+		std::unordered_map<util::textId_t, databaseStats_t> databases;
+	};
+
+
+	/*Parses a directory of summaries on several threads and gathers every hit into a
+	*  single columnar store. Records come out in the order of the sorted file names, so
+	*  the same directory always gives the same store no matter how the work was split
+	*
+	* Precondition: threads > 0
+	*
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to ingest
+	* Param outputs maps each sample to its raw Abricate outputs, or is nullptr when the
+	*  files are summaries
+	* Param threads is the most worker threads used to parse the summaries
+	* Returns the store holding every sample and hit
+	*/
+	store_t ingest(
+		const string& directory, vector<string> filenames, const filectrl::outputGroups_t* outputs,
+		int threads
+	);
+
+
+	/*Parses a directory of summaries on several threads and totals up, for each Abricate
+	*  database, how many rows had hits, how their identities were spread and which genes
+	*  were hit most. The database of a row is read from its FILE entry, where Abricate
+	*  names each output like SAMPLE_database_out.tab. Each worker folds the summaries it
+	*  parses into its own totals, which are merged once every summary has been read
+	*
+	* Precondition: threads > 0
+	*
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to report on
+	* Param outputs maps each sample to its raw Abricate outputs, or is nullptr when the
+	*  files are summaries
+	* Param threads is the most worker threads used to parse the summaries
+	* Returns the totals for every database
+	*/
+	statsReport_t reduceStats(
+		const string& directory, const vector<string>& filenames,
+		const filectrl::outputGroups_t* outputs, int threads
+	);
+
+
+	/*Writes a stats report as one line per database, sorted by name. Paths ending in
+	*  .csv are written comma-separated, and anything else tab-separated
+	*
+	* Param report is the report being written
+	* Param path is the path of the report file, which is replaced if it exists
+	*/
+	void writeStatsReport(const statsReport_t& report, const string& path);
+
+
+	/*Writes a store to a binary file: a header giving the counts, then the dictionary's
+	*  offsets, the sample list, each record column and the hits, then the dictionary's
+	*  text. The file is written beside its destination and moved into place once whole
+	*
+	* Param store is the store being written
+	* Param path is the path of the store file, which is replaced if it exists
+	*/
+	void writeStore(const store_t& store, const string& path);
+
+
+	/*Reads a store back from the file writeStore made, mapping it into memory and
+	*  checking that every index and span lies inside it
+	*
+	* Param path is the path of the store file
+	* Returns the store held in the file
+	*/
+	store_t readStore(const string& path);
+
+
+	/*Adds one row per sample of a store to a heatmap, holding the best hit the sample
+	*  had in each database. This gives the same heatmap as collapsing each summary with
+	*  proc::addHeatmapRows, without reading any of them
+	*
+	* Precondition: heatmap != nullptr
+	*
+	* Param heatmap is the heatmap being added to
+	* Param store is the store the rows are taken from
+	*/
+	void addStoreRows(proc::heatmap_t* heatmap, const store_t& store);
+
+}
+
+#endif
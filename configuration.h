@@ -7,6 +7,14 @@
 #include <cstring>
 #include <stdint.h>
 #include <cctype>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+//The JPEG quality used unless an output target gives its own
+#define DEFAULT_JPEG_QUALITY 50
 
 
 namespace util {
@@ -16,19 +24,55 @@ namespace util {
 		uint16_t r, g, b, a;
 	};
 
+	//This struct describes one image written for every graph: its format, its size (0
+	// keeps the size the graph was drawn at) and, for JPEG, its quality
+	struct outputTarget_t {
+		std::string type;
+		int width, height;
+		int quality;
+	};
+
 	extern std::string ABR_INPUT_DIR;
 	extern std::string ABR_TYPEFACE_DIR;
 	extern std::string ABR_TYPEFACE_NAME;
 	extern std::string ABR_OUTPUT_DIR;
 	extern std::string ABR_OUTPUT_EXT;
-	extern bool ABR_RUN_DEBUG;
+	extern int ABR_RUN_DEBUG;
 
 	extern bool batch;
 	extern bool raw;
 	extern bool flagsUsed;
-
-	static int IMG_W = 1200;
-	static int IMG_H = 800;
+	extern bool stream;
+	extern bool mosaic;
+	extern int mosaicColumns;
+	extern int mosaicTileW;
+	extern int mosaicTileH;
+	extern bool heatmap;
+	extern std::string archivePath;
+	extern bool tableCache;
+	extern bool abricateOutputs;
+	extern std::string ingestPath;
+	extern std::vector<outputTarget_t> outputTargets;
+	extern std::string reportPath;
+	extern std::string statsPath;
+	extern bool memStats;
+	extern std::string tracePath;
+	extern int benchIterations;
+	extern std::string verifyDir;
+	extern int verifyTolerance;
+	extern double verifyMaxSlowdown;
+	extern bool verifyBless;
+	extern std::string generatePath;
+	extern long generateRows;
+	extern int generateColumns;
+	extern double generateDensity;
+	extern double generateMultiHit;
+	extern unsigned int generateSeed;
+
+	extern int IMG_W;
+	extern int IMG_H;
+	extern double scale;
+	extern thread_local double threadScale;
 
 	static color_t ABR_BKGD_COLOR = { 220, 235, 240, 255 };
 	static color_t ABR_GRAPH_COLOR1 = { 40, 50, 80, 255 };
@@ -63,11 +107,43 @@ namespace util {
 		{143,  20,  80, 255}
 	};
 
+	//Gives the bar color of a database column, starting the palette over once a graph has
+	// more columns than it has colors
+	static const color_t& barColor(size_t column) {
+		return ABR_BAR_COLORS[column % (sizeof(ABR_BAR_COLORS) / sizeof(*ABR_BAR_COLORS))];
+	}
+
 	static int ABR_GRAPH_PADDING = 150;
-	static int ABR_GRAPH_THICKNESS = 5;
+
+	//The layout is designed for a 1200x800 image, and every other size scales it
+	static const int BASE_IMG_W = 1200;
+	static const int BASE_IMG_H = 800;
+	static const int BASE_GRAPH_THICKNESS = 5;
+
+
+	/*Scales a length from the 1200x800 layout to the configured output size. A scale set
+	*  in threadScale stands in for the configured one on the calling thread, so that
+	*  graphs rendered through the abr interface follow their own style's size
+	*
+	* Param px is the length in pixels at 1200x800
+	* Returns the length in pixels at the configured scale
+	*/
+	static int scaled(int px) {
+		return (int)std::lround(px * (threadScale > 0 ? threadScale : scale));
+	}
+
+
+	/*Gives the thickness of the graph frame's lines at the configured scale, never less
+	*  than a single pixel
+	*
+	* Returns the line thickness in pixels
+	*/
+	static int graphThickness() {
+		return std::max(1, scaled(BASE_GRAPH_THICKNESS));
+	}
 
 	static const std::string supportedTypes[] = {
-		"PNG", "JPEG",
+		"PNG", "JPEG", "QOI",
 	};
 
 
@@ -208,16 +284,87 @@ namespace util {
 	}
 
 
+	/*Reads the numeric argument that follows a flag
+	*
+	* Param argc is the number of command line arguments
+	* Param argv is the list of command line arguments
+	* Param x is the index of the flag in argv
+	* Param flag is the name of the flag, used in the error message
+	* Returns the argument following the flag as a double
+	*/
+	static double numericArg(int argc, char** argv, int x, std::string flag) {
+		if (x + 1 >= argc)
+			throw "Numeric argument required for flag " + flag;
+
+		//Only plain decimal numbers are allowed, no signs or exponents
+		std::string arg(argv[x + 1]);
+		bool digits = false;
+		for (char c : arg) {
+			if (std::isdigit(c)) digits = true;
+			else if (c != '.') throw "Numeric argument required for flag " + flag;
+		}
+		if (!digits) throw "Numeric argument required for flag " + flag;
+
+		return std::stod(arg);
+	}
+
+
+	/*Reads one output target, given like TYPE[@WIDTHxHEIGHT][:QUALITY]. A width on its
+	*  own leaves the height at 0, to be worked out from the graphs' shape later
+	*
+	* Param item is the target as given on the command line
+	* Returns the target it describes
+	*/
+	static outputTarget_t parseTarget(const std::string& item) {
+		const char* usage = "Targets like PNG, JPEG:80 or PNG@600x400 required for flag --targets";
+		size_t at = item.find('@'), colon = item.find(':', at == std::string::npos ? 0 : at);
+		outputTarget_t target = { item.substr(0, std::min(at, colon)), 0, 0, DEFAULT_JPEG_QUALITY };
+		for (size_t c = 0; c < target.type.length(); c++) target.type[c] = std::toupper(target.type[c]);
+
+		bool supported = false;
+		for (const std::string& type : supportedTypes)
+			if (target.type == type) supported = true;
+		if (!supported) throw "Unrecognized file type " + target.type + " given for flag --targets";
+
+		//The size is a width, or a width and height split by an x
+		auto number = [&](const std::string& digits) {
+			if (digits.empty() || digits.length() > 5) throw usage;
+			for (char c : digits) if (!std::isdigit(c)) throw usage;
+			return std::stoi(digits);
+		};
+		if (at != std::string::npos) {
+			std::string size = item.substr(at + 1, colon == std::string::npos ? std::string::npos : colon - at - 1);
+			size_t split = size.find_first_of("xX");
+			target.width = number(size.substr(0, split));
+			if (split != std::string::npos) target.height = number(size.substr(split + 1));
+			if (target.width < 1 || (split != std::string::npos && target.height < 1))
+				throw "Flag --targets needs sizes of at least 1 pixel";
+		}
+		if (colon != std::string::npos) {
+			if (target.type != "JPEG") throw "Flag --targets only takes a quality for JPEG targets";
+			target.quality = number(item.substr(colon + 1));
+			if (target.quality < 1 || target.quality > 100)
+				throw "Flag --targets takes a JPEG quality from 1 to 100";
+		}
+
+		return target;
+	}
+
+
 	/*Handle command line options from a passed in set of flags. THIS MUST BE THE
 	*  VERY FIRST FUNCTION CALL OF THE SYSTEM. THIS COMES BEFORE AbrPrint_Init()
 	*/
 	static int AbrPrint_HandleCLO(
-		int argc, char** argv, std::string* source, bool* batch, bool* raw, bool* flagsUsed
+		int argc, char** argv, std::string* source, bool* batch, bool* raw, bool* flagsUsed,
+		bool* stream
 	) {
 		std::string sourcePath = "";
 		bool batchFlag = false;
 		bool rawFlag = false;
 		bool usedFlag = false;
+		bool streamFlag = false;
+		bool resolutionGiven = false;
+		bool scaleGiven = false;
 
 		//Run through the argument list and handle the help tab first
 		for (int x = 1; x < argc; x++) {
@@ -249,14 +396,45 @@ namespace util {
 				std::cout << "AbrPrint.exe                      -> This will generate a graph for " << std::endl;
 				std::cout << "                                      each file in the stored source" << std::endl;
 				std::cout << "                                      directory." << std::endl;
+				std::cout << "AbrPrint.exe - [options]          -> This will read a single summary" << std::endl;
+				std::cout << "                                      from STDIN and write the graph" << std::endl;
+				std::cout << "                                      image to STDOUT." << std::endl;
+				std::cout << "AbrPrint.exe ingest [store]       -> This will read every summary in" << std::endl;
+				std::cout << "                                      the source directory into one" << std::endl;
+				std::cout << "                                      cohort store file (.abrs)." << std::endl;
 				std::cout << std::endl;
 				std::cout << "Available options:" << std::endl;
 				std::cout << " -i   --raw-input     Absolute path of an input file/directory" << std::endl;
 				std::cout << " -b   --batch         Generate graphs for each file in the source" << std::endl;
 				std::cout << " -h   --help [opt]    Makes this help menu. You can provide a flag" << std::endl;
 				std::cout << "                      to get more information on how it works" << std::endl;
+				std::cout << " -m   --mosaic [cols] Tile every graph into a single large image" << std::endl;
+				std::cout << "      --tile [width]  Shrink each mosaic graph to a thumbnail this wide" << std::endl;
+				std::cout << " -H   --heatmap       Draw a samples x databases heatmap instead of" << std::endl;
+				std::cout << "                      bar graphs" << std::endl;
+				std::cout << " -a   --archive [path] Bundle every graph into one indexed tar file" << std::endl;
+				std::cout << " -c   --cache         Keep a parsed copy of each summary (.abrc) to" << std::endl;
+				std::cout << "                      skip reading the text on later runs" << std::endl;
+				std::cout << " -A   --abricate-outputs Read each sample's raw per-database Abricate" << std::endl;
+				std::cout << "                      outputs instead of an abricate --summary" << std::endl;
+				std::cout << " -s   --stats [path]  Write per-stage timings to a JSON report" << std::endl;
+				std::cout << "      --stats-report [path] Write hit rates, identity spread and top" << std::endl;
+				std::cout << "                      genes of each database across every summary" << std::endl;
+				std::cout << " -M   --mem-stats     Add heap allocations and peak memory to the" << std::endl;
+				std::cout << "                      -s/--stats report" << std::endl;
+				std::cout << " -T   --trace [path]  Write a timeline of every file and stage for" << std::endl;
+				std::cout << "                      Perfetto or chrome://tracing" << std::endl;
+				std::cout << " -B   --bench [runs]  Time each graphing stage and print the results" << std::endl;
+				std::cout << " -g   --generate [path] Write a synthetic summary for scale testing" << std::endl;
+				std::cout << " -V   --verify [dir]  Check graphs and speed against golden images" << std::endl;
+				std::cout << " -r   --resolution [WxH] Draw the graphs at a different size, scaling" << std::endl;
+				std::cout << "                      the whole layout to match" << std::endl;
+				std::cout << "      --scale [x]     Scale the 1200x800 layout up or down, like a DPI" << std::endl;
+				std::cout << "                      setting (2 makes 2400x1600 graphs)" << std::endl;
+				std::cout << "      --targets [list] Save each graph in several formats and sizes at" << std::endl;
+				std::cout << "                      once, like PNG,JPEG:80,PNG@300x200" << std::endl;
 				std::cout << std::endl;
-				std::cout << " -v   --verbose OR --debug        Sends a debug log into the console" << std::endl;
+				std::cout << " -v   --verbose OR --debug [1-3]  Sends a debug log into the console" << std::endl;
 				std::cout << "                                  during execution" << std::endl;
 				std::cout << " -d   --set-source-dir [path]     Sets the directory for the source" << std::endl;
 				std::cout << "                                  files to the path provided" << std::endl;
@@ -291,6 +469,9 @@ namespace util {
 					std::cout << " Then AbrPrint will search to the absolute path that you provided" << std::endl;
 					std::cout << "  instead of in the directory set in the configuration file." << std::endl;
 					std::cout << std::endl;
+					std::cout << "Files compressed with gzip (.gz) or zstd (.zst) can be given just like" << std::endl;
+					std::cout << " any other, here or in a batch, and are decompressed as they are read." << std::endl;
+					std::cout << std::endl;
 				}
 
 				else if (arg == "-b" || arg == "--batch") {
@@ -414,7 +595,7 @@ namespace util {
 					std::cout << std::endl;
 					std::cout << "AbrPrint -e or --set-file-type flag" << std::endl;
 					std::cout << std::endl;
-					std::cout << "AbrPrint can save your graphs to either a PNG or a JPEG image. The " << std::endl;
+					std::cout << "AbrPrint can save your graphs as a PNG, JPEG or QOI image. The " << std::endl;
 					std::cout << " default file type is PNG, but can be changed. You can just run:" << std::endl;
 					std::cout << std::endl;
 					std::cout << "      AbrPrint -e JPEG" << std::endl;
@@ -424,6 +605,11 @@ namespace util {
 					std::cout << " and now the output of a file called test123.tab will be generated " << std::endl;
 					std::cout << " as test123_bargraph.jpeg rather than test123_bargraph.png." << std::endl;
 					std::cout << std::endl;
+					std::cout << " QOI is also supported. It is lossless like PNG but many times faster" << std::endl;
+					std::cout << " to save, at the cost of somewhat larger files, which suits large" << std::endl;
+					std::cout << " batches and archives that are converted later. It needs no extra" << std::endl;
+					std::cout << " libraries, though fewer image viewers can open it." << std::endl;
+					std::cout << std::endl;
 
 				}
 
@@ -437,6 +623,347 @@ namespace util {
 					std::cout << " flag shouldn't be too useful to you most of the time, but could be " << std::endl;
 					std::cout << " interesting if you're curious about AbrPrint's inner functions." << std::endl;
 					std::cout << std::endl;
+					std::cout << "The log can be trimmed down by giving it a level from 1 to 3:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint MyResultFile.tab -v 1" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Level 1 only follows the main steps, level 2 adds the steps inside" << std::endl;
+					std::cout << " each function, and level 3 (the default) adds every little detail." << std::endl;
+					std::cout << " Release builds of AbrPrint have the debug log compiled out of them " << std::endl;
+					std::cout << " entirely to keep them fast, so this flag only works in debug builds." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-m" || arg == "--mosaic" || arg == "--tile") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -m or --mosaic flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Opening hundreds of separate graphs to review a run gets old fast. " << std::endl;
+					std::cout << " With the mosaic flag, AbrPrint will lay every graph from a batch out" << std::endl;
+					std::cout << " in a grid on one big image instead. The graphs are drawn at the same" << std::endl;
+					std::cout << " time on several threads, so it's quicker than it sounds. Just run:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -m" << std::endl;
+					std::cout << std::endl;
+					std::cout << " and you'll get a single mosaic_bargraph.png in the output directory." << std::endl;
+					std::cout << " By default the grid is kept roughly square, but you can give the " << std::endl;
+					std::cout << " number of graphs per row if you'd like something wider:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -m 10" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Each graph keeps its full size in the grid, so a big batch makes a" << std::endl;
+					std::cout << " huge image. Give --tile a width to shrink every graph into a" << std::endl;
+					std::cout << " thumbnail that keeps its shape instead:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -m --tile 300" << std::endl;
+					std::cout << std::endl;
+					std::cout << " A mosaic that would still be over 2GB of pixels is refused before" << std::endl;
+					std::cout << " any graph is drawn." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-H" || arg == "--heatmap") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -H or --heatmap flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Bar graphs get crowded once there are more than a few dozen samples" << std::endl;
+					std::cout << " on them. The heatmap flag draws a grid instead, with a row for each" << std::endl;
+					std::cout << " sample and a column for each database. Each cell is colored by the " << std::endl;
+					std::cout << " identity of its hit, and cells without a hit are left empty." << std::endl;
+					std::cout << std::endl;
+					std::cout << "Given a single file, each FILE entry in it becomes a row:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint MyResultFile.tab -H" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Given a batch, each summary file becomes one row holding the best " << std::endl;
+					std::cout << " hit for each database, and the whole cohort is drawn on one image:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -H" << std::endl;
+					std::cout << std::endl;
+					std::cout << " This one will be saved as cohort_heatmap.png." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-a" || arg == "--archive") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -a or --archive flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "A big batch makes a lot of little image files, and some shared file" << std::endl;
+					std::cout << " systems really don't like that. The archive flag streams every graph" << std::endl;
+					std::cout << " from the batch into one tar file instead:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -a ~/graphs.tar" << std::endl;
+					std::cout << std::endl;
+					std::cout << " The graphs are named the same way they would be in the output " << std::endl;
+					std::cout << " directory. AbrPrint also writes an index of where each graph sits " << std::endl;
+					std::cout << " in the archive (name, byte offset and size), both as index.tsv at" << std::endl;
+					std::cout << " the end of the tar and as ~/graphs.tar.idx next to it, so a single" << std::endl;
+					std::cout << " graph can be read back without unpacking the rest. Any regular tar" << std::endl;
+					std::cout << " tool can still extract the whole thing." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-c" || arg == "--cache") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -c or --cache flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Reading a big summary means going through every bit of its text, and" << std::endl;
+					std::cout << " that adds up when the same cohort gets graphed over and over. With" << std::endl;
+					std::cout << " this flag, AbrPrint saves what it read from each summary next to it" << std::endl;
+					std::cout << " in a compact binary file:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -c" << std::endl;
+					std::cout << std::endl;
+					std::cout << " makes a MyResultFile.tab.abrc beside each MyResultFile.tab. The next" << std::endl;
+					std::cout << " run with -c reads the .abrc file instead of the summary, as long as" << std::endl;
+					std::cout << " the summary hasn't changed since. If it has, the summary is read " << std::endl;
+					std::cout << " again and its .abrc file is replaced. The .abrc files can be deleted" << std::endl;
+					std::cout << " at any time, and AbrPrint never graphs them as summaries." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-A" || arg == "--abricate-outputs") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -A or --abricate-outputs flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "AbrPrint normally graphs the table abricate --summary makes from a" << std::endl;
+					std::cout << " sample's outputs. With this flag, the outputs Abricate wrote for each" << std::endl;
+					std::cout << " database can be graphed straight away, skipping abricate --summary:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_outputs -A" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Every file in the source directory named like SAMPLE_database_out.tab" << std::endl;
+					std::cout << " is grouped by its SAMPLE, and each sample gets one graph named after" << std::endl;
+					std::cout << " it, just as if its outputs had been summarised first. The outputs of" << std::endl;
+					std::cout << " a sample are read at the same time on several threads. Other files" << std::endl;
+					std::cout << " in the directory are left alone. -A works with -m/--mosaic," << std::endl;
+					std::cout << " -H/--heatmap, -a/--archive, ingest and --stats-report." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "ingest") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint ingest (cohort store)" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Each summary only covers one sample, so looking across a whole cohort" << std::endl;
+					std::cout << " means reading every one of them again. Running:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ingest cohort.abrs -i ~/path/to/abricate_results" << std::endl;
+					std::cout << std::endl;
+					std::cout << " reads every summary in the directory on several threads at once and" << std::endl;
+					std::cout << " saves all of their hits to the one file cohort.abrs. Each hit keeps" << std::endl;
+					std::cout << " its sample, the Abricate output file it came from, its database and" << std::endl;
+					std::cout << " every identity it listed. Without -i, the stored source directory is" << std::endl;
+					std::cout << " read instead, and -c can be added to use and keep .abrc caches." << std::endl;
+					std::cout << std::endl;
+					std::cout << " The store can then stand in for the summaries when drawing a cohort" << std::endl;
+					std::cout << " heatmap, which reads just the one file:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint -i ~/path/to/cohort.abrs -H" << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "--stats-report") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint --stats-report flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Instead of drawing graphs, this reads every summary in the source" << std::endl;
+					std::cout << " directory on several threads at once and writes one line for each" << std::endl;
+					std::cout << " Abricate database found across all of them:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint --stats-report cohort_stats.tsv -i ~/path/to/results" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Each line gives the number of samples and rows for the database, the" << std::endl;
+					std::cout << " share of rows with any hit, the mean, lowest and highest identity," << std::endl;
+					std::cout << " how many identities fell below 80, 80-90, 90-95, 95-99 and 99-100," << std::endl;
+					std::cout << " and the most-hit genes with their counts. The database of each row" << std::endl;
+					std::cout << " is taken from its FILE entry (e.g. SAMPLE_card_out.tab is card). A" << std::endl;
+					std::cout << " path ending in .csv is written comma-separated, anything else with" << std::endl;
+					std::cout << " tabs. The summaries are read just like they are for graphing, and" << std::endl;
+					std::cout << " -c can be added to use and keep .abrc caches." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-s" || arg == "--stats") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -s or --stats flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "If you want to know where AbrPrint spends its time, this flag times " << std::endl;
+					std::cout << " each stage of making a graph (loading, parsing, laying out, drawing" << std::endl;
+					std::cout << " and saving) and writes a summary of them to a JSON file when it's  " << std::endl;
+					std::cout << " done. For example:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -s stats.json" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Each stage lists how many times it ran, along with the total, min," << std::endl;
+					std::cout << " max, median (p50) and 99th percentile times in milliseconds. The " << std::endl;
+					std::cout << " \"graph\" stage is the whole time spent on each file." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-M" || arg == "--mem-stats") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -M or --mem-stats flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "This adds memory use to the report made by -s/--stats, so it has to" << std::endl;
+					std::cout << " be used along with it:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -s stats.json -M" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Every stage and every file gets a count of the heap allocations it" << std::endl;
+					std::cout << " made and how many bytes they asked for, and the report notes the " << std::endl;
+					std::cout << " most memory AbrPrint held at any one time (its peak RSS)." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-T" || arg == "--trace") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -T or --trace flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "The -s/--stats report sums everything up, which can hide the one file" << std::endl;
+					std::cout << " that took ten times longer than the rest. This flag writes a trace " << std::endl;
+					std::cout << " instead, with a span for every file and for every stage within it: " << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint ~/path/to/abricate_results -b -T trace.json" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Open the trace in https://ui.perfetto.dev or chrome://tracing to see" << std::endl;
+					std::cout << " it as a timeline. Each thread gets its own track, and the stages are" << std::endl;
+					std::cout << " grouped as parse, layout, frame, text, bars, encode and write. Gaps " << std::endl;
+					std::cout << " between the spans are time spent somewhere AbrPrint doesn't measure." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-B" || arg == "--bench") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -B or --bench flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "This one is mostly for people working on AbrPrint itself. Instead of" << std::endl;
+					std::cout << " saving any graphs, it times each of the stages that go into a graph" << std::endl;
+					std::cout << " over and over against your source files, along with some large made" << std::endl;
+					std::cout << " up summaries, and prints the results to the console. For example:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint -i ~/path/to/abr_files -b -B 50 > bench.tsv" << std::endl;
+					std::cout << std::endl;
+					std::cout << " runs every stage 50 times per input (20 if you leave the number off)" << std::endl;
+					std::cout << " and writes a tab-separated line for each with the fastest, median " << std::endl;
+					std::cout << " and mean times in microseconds. The lines always come out in the  " << std::endl;
+					std::cout << " same order, so two runs can be compared line by line to spot a " << std::endl;
+					std::cout << " stage that got slower." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-V" || arg == "--verify") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -V or --verify flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Another one for people working on AbrPrint. It draws a graph for each" << std::endl;
+					std::cout << " source file and checks it against a known-good (golden) image in the" << std::endl;
+					std::cout << " given directory, then times a few runs through all of the files and" << std::endl;
+					std::cout << " checks the graphs per second against the last recorded speed:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint -i ~/path/to/abr_files -b -V ~/goldens" << std::endl;
+					std::cout << std::endl;
+					std::cout << " A last run through the files checks that, once warmed up, no graph" << std::endl;
+					std::cout << " allocates any memory on its way from summary to encoded image." << std::endl;
+					std::cout << " AbrPrint exits with an error if any graph or the speed check fails." << std::endl;
+					std::cout << " These flags change how it checks:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      --tolerance [0-255]  How far any color in a pixel can be off" << std::endl;
+					std::cout << "                           before it counts as different (default" << std::endl;
+					std::cout << "                           0, an exact match). A few points helps" << std::endl;
+					std::cout << "                           with the smoothed edges of text" << std::endl;
+					std::cout << "      --max-slowdown [%]   How much slower than the recorded speed" << std::endl;
+					std::cout << "                           is allowed (default 10)" << std::endl;
+					std::cout << "      --bless              Save the current graphs and speed as the" << std::endl;
+					std::cout << "                           new goldens instead of checking them" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Goldens depend on the exact font and SDL2 build they were drawn with," << std::endl;
+					std::cout << " so bless them once on the build you treat as the reference and keep" << std::endl;
+					std::cout << " that directory. A directory holding no goldens for the files at all" << std::endl;
+					std::cout << " is an error, rather than a failure for every graph." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-g" || arg == "--generate") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -g or --generate flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Real Abricate summaries tend to be small, which makes it hard to see" << std::endl;
+					std::cout << " how AbrPrint holds up on big ones. This flag writes a made-up summary" << std::endl;
+					std::cout << " in the same layout as abricate --summary, then exits:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint -g big_summary.tab --rows 1000000 --columns 100" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Giving - as the path writes the summary to STDOUT instead. The shape" << std::endl;
+					std::cout << " of the summary can be changed with these flags:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      --rows [n]         Number of rows (default 1000)" << std::endl;
+					std::cout << "      --columns [n]      Number of gene columns, 1 to 100 (default 16)" << std::endl;
+					std::cout << "      --density [0-1]    Share of cells with a hit (default 0.3)" << std::endl;
+					std::cout << "      --multi-hit [0-1]  Share of hits listing a second identity" << std::endl;
+					std::cout << "                         separated by ';' (default 0.2)" << std::endl;
+					std::cout << "      --seed [n]         Seed for the random hits (default 1)" << std::endl;
+					std::cout << std::endl;
+					std::cout << " The same settings always give exactly the same file." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-r" || arg == "--resolution" || arg == "--scale") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint -r or --resolution and --scale flags" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Graphs are 1200x800 by default, which is fine on a screen but looks" << std::endl;
+					std::cout << " rough on a slide or a poster. These flags draw them bigger, scaling " << std::endl;
+					std::cout << " the text, lines and spacing along with the image so nothing ends up" << std::endl;
+					std::cout << " tiny or blurry. Either give the size you want in pixels:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint MyResultFile.tab -r 7680x4320" << std::endl;
+					std::cout << std::endl;
+					std::cout << " or how much to scale the usual layout by, like a DPI setting:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint MyResultFile.tab --scale 2" << std::endl;
+					std::cout << std::endl;
+					std::cout << " which makes a 2400x1600 graph. Given only a size, the layout scales" << std::endl;
+					std::cout << " by as much as fits it, and the graph frame stretches to fill the" << std::endl;
+					std::cout << " rest. Both can be given to set each one separately. Very large" << std::endl;
+					std::cout << " graphs (4K and up) are drawn in strips on several threads at once." << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "--targets") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint --targets flag" << std::endl;
+					std::cout << std::endl;
+					std::cout << "Each graph is normally saved once, in the type set with -e. To also" << std::endl;
+					std::cout << " get a JPEG preview or a thumbnail, list every image you want made:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      AbrPrint MyResultFile.tab --targets PNG,JPEG:80,PNG@300x200" << std::endl;
+					std::cout << std::endl;
+					std::cout << " Each target is a file type, then optionally @ and a size, then for" << std::endl;
+					std::cout << " JPEG optionally : and a quality from 1 to 100 (50 if left out). A" << std::endl;
+					std::cout << " size can be a width alone (PNG@300), which keeps the graph's shape." << std::endl;
+					std::cout << " The graph is only drawn once, at the size set with -r or --scale," << std::endl;
+					std::cout << " and smaller targets are shrunk from it by averaging the pixels each" << std::endl;
+					std::cout << " one covers. Every target is encoded at the same time on its own" << std::endl;
+					std::cout << " thread. Targets at the drawn size are named as usual, and the" << std::endl;
+					std::cout << " others get their size added, like MyResultFile_bargraph_300x200.png" << std::endl;
+					std::cout << std::endl;
+				}
+
+				else if (arg == "-") {
+					std::cout << std::endl;
+					std::cout << "AbrPrint - (streaming mode)" << std::endl;
+					std::cout << std::endl;
+					std::cout << "If you'd rather not write your Abricate summary to disk first, you " << std::endl;
+					std::cout << " can give AbrPrint a single dash in place of the source file. It'll" << std::endl;
+					std::cout << " read the summary from STDIN and write the finished graph to STDOUT" << std::endl;
+					std::cout << " so it can sit in the middle of a shell pipeline. For example:" << std::endl;
+					std::cout << std::endl;
+					std::cout << "      abricate --summary *_out.tab | AbrPrint - > graph.png" << std::endl;
+					std::cout << std::endl;
+					std::cout << " The image is encoded using the stored file type (see -e), and any " << std::endl;
+					std::cout << " messages or debug logging get sent to STDERR instead of STDOUT." << std::endl;
+					std::cout << std::endl;
 				}
 			}
 
@@ -452,8 +979,25 @@ namespace util {
 			//Store a deep-copy of the current entry in argv to prevent aliasing issues
 			std::string currItem(argv[x]);
 
+			//A lone dash as the source streams the summary in through STDIN and the
+			// graph out through STDOUT
+			if (x == 1 && currItem == "-") {
+				sourcePath = currItem;
+				streamFlag = true;
+			}
+
+			//Ingesting reads the whole source directory into the store named after it
+			else if (x == 1 && currItem == "ingest") {
+				if (x + 1 >= argc || argv[x + 1][0] == '-')
+					throw "Store path argument required for AbrPrint ingest";
+
+				ingestPath = std::string(argv[x + 1]);
+				batchFlag = true;
+				usedFlag = true;
+			}
+
 			//If a source path has been provided, store it
-			if (x == 1 && currItem[0] != '-') {
+			else if (x == 1 && currItem[0] != '-') {
 				sourcePath = currItem;
 			}
 
@@ -603,14 +1147,306 @@ namespace util {
 					usedFlag = true;
 				}
 
+				//Handle a user requesting every graph tiled onto one image
+				if (currItem == "-m" || currItem == "--mosaic") {
+					//The column count is optional, but has to be a positive number if given
+					if (x + 1 < argc && argv[x + 1][0] != '-') {
+						std::string cols(argv[x + 1]);
+						for (char c : cols)
+							if (!std::isdigit(c))
+								throw "Flag -m/--mosaic takes a positive number of columns";
+						mosaicColumns = std::stoi(cols);
+						if (mosaicColumns <= 0)
+							throw "Flag -m/--mosaic takes a positive number of columns";
+					}
+
+					mosaic = true;
+				}
+
+				//Handle a user shrinking each mosaic tile to a thumbnail of a given width
+				if (currItem == "--tile") {
+					double width = numericArg(argc, argv, x, currItem);
+					if (width != (int)width || width < 16 || width > 32768)
+						throw "Flag --tile takes a whole width from 16 to 32768";
+					mosaicTileW = (int)width;
+				}
+
+				//Handle a user bundling the batch's graphs into a single archive
+				if (currItem == "-a" || currItem == "--archive") {
+					//Check that a path argument was provided as expected
+					if (x + 1 >= argc)
+						throw "Path argument required for flag -a/--archive";
+					if (argv[x + 1][0] == '-')
+						throw "Path argument required for flag -a/--archive";
+
+					//Store the archive path, changing backslashes to foreslashes for consistency
+					archivePath = std::string(argv[x + 1]);
+					for (size_t c = 0; c < archivePath.length(); c++)
+						if (archivePath[c] == '\\') archivePath[c] = '/';
+				}
+
+				//Handle a user keeping parsed summaries in cache files
+				if (currItem == "-c" || currItem == "--cache") {
+					tableCache = true;
+				}
+
+				//Handle a user giving raw Abricate outputs, which are read from the whole
+				// source directory like a batch job
+				if (currItem == "-A" || currItem == "--abricate-outputs") {
+					abricateOutputs = true;
+					batchFlag = true;
+					usedFlag = true;
+				}
+
+				//Handle a user requesting a stage timing report
+				if (currItem == "-s" || currItem == "--stats") {
+					//Check that a path argument was provided as expected
+					if (x + 1 >= argc)
+						throw "Path argument required for flag -s/--stats";
+					if (argv[x + 1][0] == '-')
+						throw "Path argument required for flag -s/--stats";
+
+					statsPath = std::string(argv[x + 1]);
+				}
+
+				//Handle a user requesting a cohort statistics report, which reads the whole
+				// source directory like a batch job
+				if (currItem == "--stats-report") {
+					if (x + 1 >= argc)
+						throw "Path argument required for flag --stats-report";
+					if (argv[x + 1][0] == '-')
+						throw "Path argument required for flag --stats-report";
+
+					reportPath = std::string(argv[x + 1]);
+					batchFlag = true;
+					usedFlag = true;
+				}
+
+				//Handle a user requesting a timeline trace
+				if (currItem == "-T" || currItem == "--trace") {
+					//Check that a path argument was provided as expected
+					if (x + 1 >= argc)
+						throw "Path argument required for flag -T/--trace";
+					if (argv[x + 1][0] == '-')
+						throw "Path argument required for flag -T/--trace";
+
+					tracePath = std::string(argv[x + 1]);
+				}
+
+				//Handle a user adding memory use to the stage timing report
+				if (currItem == "-M" || currItem == "--mem-stats") {
+					memStats = true;
+				}
+
+				//Handle a user requesting a benchmark run
+				if (currItem == "-B" || currItem == "--bench") {
+					//Take an optional number of runs per stage
+					benchIterations = 20;
+					if (x + 1 < argc && argv[x + 1][0] != '-') {
+						std::string runs(argv[x + 1]);
+						for (char c : runs)
+							if (!std::isdigit(c))
+								throw "Flag -B/--bench takes a positive number of runs";
+						benchIterations = std::stoi(runs);
+						if (benchIterations <= 0)
+							throw "Flag -B/--bench takes a positive number of runs";
+					}
+				}
+
+				//Handle a user checking graphs against golden images
+				if (currItem == "-V" || currItem == "--verify") {
+					//Check that a path argument was provided as expected
+					if (x + 1 >= argc)
+						throw "Path argument required for flag -V/--verify";
+					if (argv[x + 1][0] == '-')
+						throw "Path argument required for flag -V/--verify";
+
+					verifyDir = std::string(argv[x + 1]);
+					for (size_t c = 0; c < verifyDir.length(); c++)
+						if (verifyDir[c] == '\\') verifyDir[c] = '/';
+				}
+
+				//Handle the options for checking against golden images
+				if (currItem == "--tolerance") {
+					double tolerance = numericArg(argc, argv, x, currItem);
+					if (tolerance != (int)tolerance || tolerance > 255)
+						throw "Flag --tolerance takes a whole number from 0 to 255";
+					verifyTolerance = (int)tolerance;
+				}
+				if (currItem == "--max-slowdown") {
+					verifyMaxSlowdown = numericArg(argc, argv, x, currItem);
+				}
+				if (currItem == "--bless") {
+					verifyBless = true;
+				}
+
+				//Handle a user generating a synthetic summary, where - writes it to STDOUT
+				if (currItem == "-g" || currItem == "--generate") {
+					if (x + 1 >= argc)
+						throw "Path argument required for flag -g/--generate";
+					if (argv[x + 1][0] == '-' && std::string(argv[x + 1]) != "-")
+						throw "Path argument required for flag -g/--generate";
+
+					generatePath = std::string(argv[x + 1]);
+				}
+
+				//Handle the options shaping a synthetic summary
+				if (currItem == "--rows") {
+					double rows = numericArg(argc, argv, x, currItem);
+					if (rows != (long)rows)
+						throw "Flag --rows takes a whole number of rows";
+					generateRows = (long)rows;
+				}
+				if (currItem == "--columns") {
+					double columns = numericArg(argc, argv, x, currItem);
+					if (columns != (int)columns || columns < 1 || columns > 100)
+						throw "Flag --columns takes a whole number of columns from 1 to 100";
+					generateColumns = (int)columns;
+				}
+				if (currItem == "--density") {
+					generateDensity = numericArg(argc, argv, x, currItem);
+					if (generateDensity > 1)
+						throw "Flag --density takes a value from 0 to 1";
+				}
+				if (currItem == "--multi-hit") {
+					generateMultiHit = numericArg(argc, argv, x, currItem);
+					if (generateMultiHit > 1)
+						throw "Flag --multi-hit takes a value from 0 to 1";
+				}
+				if (currItem == "--seed") {
+					double seed = numericArg(argc, argv, x, currItem);
+					if (seed != (unsigned int)seed)
+						throw "Flag --seed takes a whole number";
+					generateSeed = (unsigned int)seed;
+				}
+
+				//Handle a user changing the size of the graphs, given as WIDTHxHEIGHT
+				if (currItem == "-r" || currItem == "--resolution") {
+					if (x + 1 >= argc)
+						throw "Size argument like 3840x2160 required for flag -r/--resolution";
+
+					std::string size(argv[x + 1]);
+					size_t split = size.find_first_of("xX");
+					bool valid = split != std::string::npos && split > 0 && split + 1 < size.length();
+					for (size_t c = 0; valid && c < size.length(); c++)
+						if (c != split && !std::isdigit(size[c])) valid = false;
+					if (!valid || split > 5 || size.length() - split - 1 > 5)
+						throw "Size argument like 3840x2160 required for flag -r/--resolution";
+
+					IMG_W = std::stoi(size.substr(0, split));
+					IMG_H = std::stoi(size.substr(split + 1));
+					if (IMG_W < 100 || IMG_H < 100 || IMG_W > 32768 || IMG_H > 32768)
+						throw "Flag -r/--resolution takes a size from 100x100 to 32768x32768";
+					resolutionGiven = true;
+				}
+
+				//Handle a user asking for several images of each graph, given as a list of
+				// targets split by commas
+				if (currItem == "--targets") {
+					if (x + 1 >= argc || argv[x + 1][0] == '-')
+						throw "Targets like PNG, JPEG:80 or PNG@600x400 required for flag --targets";
+
+					std::string list(argv[x + 1]);
+					outputTargets.clear();
+					for (size_t start = 0, end = 0; end != std::string::npos; start = end + 1) {
+						end = list.find(',', start);
+						outputTargets.push_back(parseTarget(list.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+					}
+				}
+
+				//Handle a user scaling the layout up or down
+				if (currItem == "--scale") {
+					scale = numericArg(argc, argv, x, currItem);
+					if (scale < 0.1 || scale > 27)
+						throw "Flag --scale takes a value from 0.1 to 27";
+					scaleGiven = true;
+				}
+
+				//Handle a user requesting a heatmap rather than bar graphs
+				if (currItem == "-H" || currItem == "--heatmap") {
+					heatmap = true;
+				}
+
 				//Handle debug mode
 				if (currItem == "-v" || currItem == "--verbose" || currItem == "--debug") {
-					//Set the global debug boolean to true
-					ABR_RUN_DEBUG = true;
+					//Default to logging everything, unless a level from 1 to 3 was given
+					ABR_RUN_DEBUG = 3;
+					if (x + 1 < argc && argv[x + 1][0] != '-') {
+						std::string level(argv[x + 1]);
+						if (level != "1" && level != "2" && level != "3")
+							throw "Flag -v/--verbose/--debug takes a verbosity level from 1 to 3";
+						ABR_RUN_DEBUG = std::stoi(level);
+					}
 				}
 			}
 		}
 
+		//A size on its own scales the layout as far as it fits, and a scale on its own
+		// sizes the image to match
+		if (resolutionGiven && !scaleGiven)
+			scale = std::min((double)IMG_W / BASE_IMG_W, (double)IMG_H / BASE_IMG_H);
+		if (scaleGiven && !resolutionGiven) {
+			IMG_W = scaled(BASE_IMG_W);
+			IMG_H = scaled(BASE_IMG_H);
+		}
+
+		//Mosaic tiles are the size of the graphs unless a thumbnail width was given, which
+		// takes the height that keeps the graph's shape
+		if (mosaicTileW > IMG_W)
+			throw "Flag --tile can't be wider than the graphs (" + std::to_string(IMG_W) + ")";
+		if (mosaicTileW > 0 && !mosaic)
+			throw "Flag --tile only applies to -m/--mosaic";
+		if (mosaicTileW == 0) mosaicTileW = IMG_W;
+		mosaicTileH = std::max(1, (int)std::lround((double)mosaicTileW * IMG_H / IMG_W));
+
+		//Targets are shrunk from the drawn graph, so none can be bigger than it, and a
+		// width given alone takes the height that keeps the graph's shape
+		for (size_t t = 0; t < outputTargets.size(); t++) {
+			outputTarget_t& target = outputTargets[t];
+			if (target.width > 0 && target.height == 0)
+				target.height = std::max(1, (int)std::lround((double)target.width * IMG_H / IMG_W));
+			if (target.width > IMG_W || target.height > IMG_H)
+				throw "Flag --targets sizes can't be bigger than the graphs (" +
+					std::to_string(IMG_W) + "x" + std::to_string(IMG_H) + ")";
+			if (target.width == IMG_W && target.height == IMG_H) target.width = target.height = 0;
+
+			for (size_t u = 0; u < t; u++)
+				if (outputTargets[u].type == target.type && outputTargets[u].width == target.width &&
+					outputTargets[u].height == target.height)
+					throw "Flag --targets lists the same type and size more than once";
+		}
+
+		//Streaming only ever handles the one summary coming through STDIN
+		if (streamFlag && (batchFlag || rawFlag))
+			throw "Streaming input (-) cannot be combined with -b/--batch or -i/--raw-input";
+		if (streamFlag && mosaic)
+			throw "Streaming input (-) cannot be combined with -m/--mosaic";
+		if (streamFlag && tableCache)
+			throw "Streaming input (-) cannot be combined with -c/--cache";
+		if (!outputTargets.empty() && (streamFlag || benchIterations > 0 || verifyDir != ""))
+			throw "Flag --targets cannot be combined with streaming, -B/--bench or -V/--verify";
+		if (abricateOutputs && (streamFlag || tableCache || benchIterations > 0 || verifyDir != "" || generatePath != ""))
+			throw "Flag -A/--abricate-outputs cannot be combined with streaming, -c/--cache, -B/--bench, -V/--verify or -g/--generate";
+		if (mosaic && heatmap)
+			throw "Flags -m/--mosaic and -H/--heatmap cannot be used together";
+		if (archivePath != "" && (streamFlag || mosaic || heatmap))
+			throw "Flag -a/--archive cannot be combined with streaming, -m/--mosaic or -H/--heatmap";
+		if (memStats && statsPath == "")
+			throw "Flag -M/--mem-stats requires a report path from -s/--stats";
+		if (benchIterations > 0 && (streamFlag || mosaic || heatmap || archivePath != ""))
+			throw "Flag -B/--bench cannot be combined with streaming, -m/--mosaic, -H/--heatmap or -a/--archive";
+		if (verifyDir != "" && (streamFlag || mosaic || heatmap || archivePath != "" || benchIterations > 0))
+			throw "Flag -V/--verify cannot be combined with streaming, -m/--mosaic, -H/--heatmap, -a/--archive or -B/--bench";
+		if (verifyBless && verifyDir == "")
+			throw "Flag --bless requires a golden directory from -V/--verify";
+		if (generatePath != "" && (verifyDir != "" || streamFlag || mosaic || heatmap || archivePath != "" || benchIterations > 0))
+			throw "Flag -g/--generate only writes a summary and cannot be combined with graphing flags";
+
+		if (reportPath != "" && (verifyDir != "" || streamFlag || mosaic || heatmap || archivePath != "" || benchIterations > 0 || generatePath != ""))
+			throw "Flag --stats-report only writes a report and cannot be combined with graphing flags";
+		if (ingestPath != "" && (verifyDir != "" || streamFlag || mosaic || heatmap || archivePath != "" || benchIterations > 0 || generatePath != ""))
+			throw "AbrPrint ingest only writes a cohort store and cannot be combined with graphing flags";
+
 		//If there is a batch job provided, add a slash to the end of the location given
 		if (batchFlag && sourcePath != "") sourcePath += "/";
 
@@ -619,6 +1455,7 @@ namespace util {
 		*batch = batchFlag;
 		*raw = rawFlag;
 		*flagsUsed = usedFlag;
+		*stream = streamFlag;
 
 		return 0;
 	}
@@ -6,12 +6,18 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include <unordered_map>
 
 #include "./utils.h"
 
 
 #define HEADER_BUFFER_SIZE 4096
 
+//Graphs with at least this many pixels (4K) are drawn in bands on several threads
+#define BANDED_MIN_PIXELS (3840 * 2160)
+//The shortest band worth handing to a thread of its own
+#define BAND_MIN_ROWS 64
+
 
 namespace proc {
 	using std::vector; using std::string; using std::ifstream;
@@ -30,16 +36,97 @@ namespace proc {
 		util::color_t color;
 	};
 
+	struct heatCell_t {
+		int row, col;
+		float value;
+	};
+
+	struct heatmap_t {
+		vector<string> rowLabels;
+		vector<string> colLabels;
+		std::unordered_map<util::textId_t, int> colIndex;
+		vector<heatCell_t> cells;
+	};
+
+	struct mosaicTile_t {
+		string title;
+		vector<string> labels;
+		vector<vector<string>> table;
+	};
+
+	//This struct holds what banded drawing keeps from graph to graph. Each worker has
+	// its own typeface and a band it draws onto with a renderer of its own, so the text
+	// each worker caches for its renderer lasts the whole batch. Finished bands are
+	// copied onto the canvas
+	struct bandCanvas_t {
+		vector<TTF_Font*> fonts;
+		vector<SDL_Surface*> bands;
+		vector<SDL_Renderer*> renderers;
+		SDL_Surface* canvas = nullptr;
+	};
+
+	//This struct holds the hits read from one raw ABRicate output in the order they were
+	// listed, along with their order sorted by gene, and the line being read
+	struct outputHits_t {
+		vector<string> genes;
+		vector<string> identities;
+		vector<uint32_t> order;
+		string line;
+	};
+
+	//This struct holds everything built while turning a summary into a bar graph, so one
+	// worker can reuse the same storage from file to file. Entries a smaller file doesn't
+	// need are parked in the spare lists rather than freed, so once a workspace has seen
+	// the largest file of a batch the rest of the batch allocates nothing. Labels are
+	// also kept as interned IDs, so looking for a column is an integer compare.
+	// While makeTable reads a file it also converts each entry into rawdata, counts the
+	// hits in each column and tracks the data range, so nothing reads the table again
+	struct workspace_t {
+		vector<string> labels;
+		vector<util::textId_t> labelIds;
+		vector<vector<string>> table;
+		graphData_t graphInfo;
+		vector<vector<double>> rawdata;
+		vector<size_t> columnHits;
+		bool hasHits = false;
+		double dataMin = 0, dataMax = 0;
+		vector<graphBar_t> bars;
+		size_t longestLabel = 0;
+		string cell;
+		vector<outputHits_t> outputHits;
+		vector<string> outputGenes;
+
+		vector<vector<string>> spareColumns;
+		vector<string> spareCells;
+		vector<vector<double>> spareRaw;
+		vector<graphBar_t> spareBars;
+		vector<std::pair<string, int>> spareFiles;
+	};
+
 	/*Uses a file stream to access the file's headers, creating a list of
 	*  labels for use in graphing
 	*
 	* Precondition: src is not nullptr, file referenced by src is not empty
 	* Postcondition: The iterator of src is advanced to the file's data
 	*
-	* Param src is a pointer to an opened ifstream
+	* Param src is a pointer to an opened input stream (a file or STDIN)
 	* Returns a string vector containing the data's column labels
 	*/
-	vector<string> makeLabels(string filename, ifstream* src);
+	vector<string> makeLabels(const string& filename, std::istream* src);
+
+
+	/*Reads a file's header into a workspace's labels, reusing the storage left over
+	*  from the files before it
+	*
+	* Precondition: src is not nullptr AND ws is not nullptr
+	* Postcondition: ws->labels holds the file's labels AND the iterator of src is
+	*		advanced to the file's data
+	*
+	* Param filename is the name of the file, used in error messages
+	* Param src is a pointer to an opened input stream (a file or STDIN)
+	* Param ws is the workspace receiving the labels
+	*/
+	void makeLabels(const string& filename, std::istream* src, workspace_t* ws);
 
 
 	/*Uses a list of labels and a file stream to populate a 2d table of data
@@ -48,11 +135,86 @@ namespace proc {
 	* Postcondition: src has been entirely processed, labels = #labels
 	*
 	* Param labels is the list of labels for each of the columns on the table
-	* Param src is a pointer to an opened ifstream
+	* Param src is a pointer to an opened input stream (a file or STDIN)
 	* Returns a 2d vector, with the first index referencing the column (matching the index of
 	*   its respective label) and the second matching the row in the source file
 	*/
-	vector<vector<string>> makeTable(string filename, vector<string> labels, ifstream* src);
+	vector<vector<string>> makeTable(
+		const string& filename, const vector<string>& labels, std::istream* src
+	);
+
+
+	/*Populates a workspace's table from a file stream in a single pass, reusing the
+	*  storage left over from the files before it. Filenames lose their paths and data
+	*  entries are converted and ranged as they are read
+	*
+	* Precondition: labels.size() equals the columns in the data file AND src is not
+	*		nullptr AND ws is not nullptr
+	* Postcondition: ws->table holds the file's data, ws->rawdata its values and ws its
+	*		data range AND src has been entirely processed
+	*
+	* Param filename is the name of the file, used in error messages
+	* Param labels is the list of labels for each of the columns on the table
+	* Param src is a pointer to an opened input stream (a file or STDIN)
+	* Param ws is the workspace receiving the table
+	*/
+	void makeTable(
+		const string& filename, const vector<string>& labels, std::istream* src,
+		workspace_t* ws
+	);
+
+
+	/*Builds the summary abricate --summary would have made from a sample's raw ABRicate
+	*  outputs, straight into a workspace. Each output becomes a row, each gene found in
+	*  any of them a column (sorted by name), and each cell lists the identities of that
+	*  gene's hits separated by semicolons. The outputs are read on several threads, then
+	*  gathered into the table, which is converted and ranged just like makeTable's
+	*
+	* Precondition: outputs is not empty AND ws is not nullptr AND threads > 0
+	* Postcondition: ws holds what makeLabels and makeTable would have left in it for the
+	*		sample's summary
+	*
+	* Param directory is the directory that the outputs are found in
+	* Param outputs is the list of the sample's outputs, one per database
+	* Param ws is the workspace receiving the table
+	* Param threads is the most threads used to read the outputs
+	*/
+	void makeSummary(
+		const string& directory, const vector<string>& outputs, workspace_t* ws, int threads
+	);
+
+
+	/*Reads a table from its binary cache file into a workspace, in place of parsing the
+	*  summary it was made from. The cache is mapped into memory and copied straight into
+	*  the workspace, with no tokenizing or number conversion. A cache is only used when
+	*  its summary still has the modification time and size it had when it was written
+	*
+	* Precondition: ws is not nullptr
+	* Postcondition: If the cache was used, ws holds exactly what makeLabels and makeTable
+	*		would have left in it for the summary
+	*
+	* Param cachePath is the path of the cache file
+	* Param sourcePath is the path of the summary the cache was made from
+	* Param ws is the workspace receiving the table
+	* Returns true if the table was read from the cache, false if the cache is missing,
+	*  stale or damaged and the summary has to be parsed
+	*/
+	bool loadCache(const string& cachePath, const string& sourcePath, workspace_t* ws);
+
+
+	/*Writes the table held in a workspace to a binary cache file beside its summary.
+	*  The file holds a header recording the summary's modification time and size, the
+	*  labels, a directory of the columns, each data column's values and hit count, and
+	*  the offsets of every cell's text (multi-hit cells included) in one string block
+	*
+	* Precondition: ws holds a table read in by makeLabels and makeTable
+	*
+	* Param cachePath is the path of the cache file, which is replaced if it exists
+	* Param sourcePath is the path of the summary the table was read from
+	* Param ws is the workspace holding the table
+	* Returns false if the cache couldn't be written, true OW
+	*/
+	bool saveCache(const string& cachePath, const string& sourcePath, const workspace_t& ws);
 
 
 	/*Creates the bounds of a graph based on the size of a window
@@ -78,7 +240,19 @@ namespace proc {
 	* Param graphdata is the a data structure whose range values will be populated
 	* Returns an ordered pair with the min and max values of the range
 	*/
-	void getDataRange(vector<vector<string>> table, graphData_t* graphdata);
+	void getDataRange(const vector<vector<string>>& table, graphData_t* graphdata);
+
+
+	/*Sets a graph's range from the data range a workspace collected while its table
+	*  was read in, with no further pass over the table
+	*
+	* Precondition: graphdata != nullptr AND ws holds a scanned table
+	* Postcondition: graphdata.rangeMax and graphdata.rangeMin will be populated with appropriate values
+	*
+	* Param ws is the workspace holding the scanned table
+	* Param graphdata is the a data structure whose range values will be populated
+	*/
+	void getDataRange(const workspace_t& ws, graphData_t* graphdata);
 
 
 	/*Generates a list of renderable bars to place on the graph from data and labels
@@ -93,10 +267,28 @@ namespace proc {
 	* Returns a vector of graph bars reflecting the confidence of hits from the database
 	*/
 	vector<graphBar_t> generateBars(
-		graphData_t graphdata, vector<string> labels, vector<vector<string>> table
+		const graphData_t& graphdata, const vector<string>& labels,
+		const vector<vector<string>>& table
 		);
 
 
+	/*Generates the list of bars for a graph into a workspace from the numeric matrix
+	*  collected when its table was read in, reusing the storage left over from the
+	*  graphs before it
+	*
+	* Precondition: ws is not nullptr AND ws holds the scanned table that labels belong
+	*		to AND graphdata range values are already populated
+	* Postcondition: ws->bars holds the graph's bars
+	*
+	* Param graphdata is a struct containing graph positioning and range data
+	* Param labels is the list of database labels matching the table's columns
+	* Param ws is the workspace holding the scanned table and receiving the bars
+	*/
+	void generateBars(
+		const graphData_t& graphdata, const vector<string>& labels, workspace_t* ws
+	);
+
+
 	/*Sorts a graphBar_t list by bar height in descending order
 	*
 	* Precondition: Each element in barsList has fully populated fields
@@ -123,8 +315,8 @@ namespace proc {
 	* Param font is the TTL_Font that the labels will be printed in
 	*/
 	void printKeys(
-		SDL_Renderer* renderer, SDL_Texture* texture, vector<string> labels,
-		graphData_t graphinfo, TTF_Font* font
+		SDL_Renderer* renderer, SDL_Texture* texture, const vector<string>& labels,
+		const graphData_t& graphinfo, TTF_Font* font
 	);
 
 
@@ -141,10 +333,165 @@ namespace proc {
 	* Param printVals is a bool representing whether the bar values will be printed
 	*/
 	void printBars(
-		SDL_Renderer* renderer, SDL_Texture* texture, vector<graphBar_t> barsList,
+		SDL_Renderer* renderer, SDL_Texture* texture, const vector<graphBar_t>& barsList,
 		TTF_Font* font, bool printVals
 	);
 
+
+	/*Renders a complete bar graph (header, frame, keys and bars) from a parsed table
+	*
+	* Precondition: renderer != nullptr AND texture != nullptr AND font != nullptr AND
+	*		labels and table were produced by makeLabels/makeTable AND texture is img_w x img_h
+	* Postcondition: texture and the renderer's target surface hold the finished graph
+	*
+	* Param renderer is the SDL_Renderer that will draw the graph
+	* Param texture is the SDL_Texture that the graph is drawn onto
+	* Param font is the TTF_Font used for all of the graph's text
+	* Param title is the heading printed above the graph
+	* Param labels is the list of column labels from the parsed table
+	* Param table is the 2D list of string data from the parsed table
+	* Param img_w is the width of the texture in pixels
+	* Param img_h is the height of the texture in pixels
+	*/
+	void renderBarGraph(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font, const string& title,
+		const vector<string>& labels, const vector<vector<string>>& table, int img_w, int img_h
+	);
+
+
+	/*Renders a complete bar graph using a workspace for the graph's metadata and bars,
+	*  so that rendering a batch doesn't allocate once the workspace has warmed up
+	*
+	* Precondition: as renderBarGraph above AND ws is not nullptr
+	* Postcondition: texture and the renderer's target surface hold the finished graph
+	*
+	* Param renderer is the SDL_Renderer that will draw the graph
+	* Param texture is the SDL_Texture that the graph is drawn onto
+	* Param font is the TTF_Font used for all of the graph's text
+	* Param title is the heading printed above the graph
+	* Param labels is the list of column labels from the parsed table
+	* Param table is the 2D list of string data from the parsed table
+	* Param img_w is the width of the texture in pixels
+	* Param img_h is the height of the texture in pixels
+	* Param ws is the workspace used for the graph's intermediate data
+	*/
+	void renderBarGraph(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font, const string& title,
+		const vector<string>& labels, const vector<vector<string>>& table, int img_w, int img_h,
+		workspace_t* ws
+	);
+
+
+	/*Renders a list of parsed tables as bar graphs tiled in a grid on one large canvas.
+	*  Tiles are drawn concurrently, one worker thread per provided font. Full-size tiles
+	*  are rendered straight into their region of the shared canvas, while thumbnails are
+	*  drawn on the worker's own full-size frame and shrunk into place. A canvas too big
+	*  for one SDL surface is refused before any tile is drawn
+	*
+	* Precondition: tiles is not empty AND fonts is not empty AND no two fonts are the
+	*		same TTF_Font AND 0 < tile_w <= img_w AND 0 < tile_h <= img_h
+	* Postcondition: tiles = #tiles
+	*
+	* Param tiles is the list of parsed tables to graph, in grid order
+	* Param fonts is one TTF_Font per worker thread
+	* Param img_w is the width each graph is drawn at in pixels
+	* Param img_h is the height each graph is drawn at in pixels
+	* Param tile_w is the width of a single tile in pixels
+	* Param tile_h is the height of a single tile in pixels
+	* Param columns is the number of tiles in each row of the grid (0 picks a square-ish grid)
+	* Returns a newly allocated SDL_Surface containing the mosaic, to be freed by the caller
+	*/
+	SDL_Surface* renderMosaic(
+		const vector<mosaicTile_t>& tiles, const vector<TTF_Font*>& fonts,
+		int img_w, int img_h, int tile_w, int tile_h, int columns
+	);
+
+
+	/*Draws a recorded graph onto the band canvas in horizontal bands. Bands are drawn
+	*  concurrently on the pool's workers, and each band only replays the recorded calls
+	*  that reach into it. Every worker keeps its band and renderer for the next graph,
+	*  so once the first graph of a size is drawn the text is drawn from each worker's
+	*  cache. Always call this from the same thread with the same pool, since worker 0's
+	*  text is cached on the calling thread
+	*
+	* Precondition: pool != nullptr AND bands != nullptr AND bands->fonts is not empty
+	*		AND no two of bands->fonts are the same TTF_Font AND img_w > 0 AND img_h > 0
+	* Postcondition: list = #list
+	*
+	* Param list is the display list of the graph, recorded at img_w x img_h
+	* Param pool is the worker pool drawing the bands, one worker per font at most
+	* Param bands holds one TTF_Font per worker, and is where the canvas is kept
+	* Param img_w is the width of the graph in pixels
+	* Param img_h is the height of the graph in pixels
+	* Returns the canvas containing the graph, owned by bands and overwritten by the next
+	*  graph
+	*/
+	SDL_Surface* rasterizeBands(
+		const util::displayList_t& list, util::workerPool_t* pool, bandCanvas_t* bands,
+		int img_w, int img_h
+	);
+
+
+	/*Releases the bands, renderers, cached text and canvas held for banded drawing. The
+	*  fonts are left to the caller
+	*
+	* Precondition: pool is the pool bands was drawn with, and is still running
+	* Postcondition: bands holds nothing but its fonts
+	*
+	* Param pool is the worker pool that drew the bands
+	* Param bands is the band canvas being released
+	*/
+	void releaseBands(util::workerPool_t* pool, bandCanvas_t* bands);
+
+
+	/*Converts a single table entry into an identity value, taking the first hit when
+	*  several are listed
+	*
+	* Param entry is the string entry from the parsed table
+	* Returns the identity percentage of the entry's first hit, 0 if there were no hits
+	*/
+	double parseIdentity(const string& entry);
+
+
+	/*Adds the rows of a parsed table to a heatmap. Columns are matched up by label, so
+	*  tables with different databases can share a heatmap
+	*
+	* Precondition: heatmap != nullptr AND labels and table were produced by
+	*		makeLabels/makeTable
+	* Postcondition: heatmap holds a new row for every FILE entry of the table, or a single
+	*		row named sampleName if collapse is set
+	*
+	* Param heatmap is the heatmap being added to
+	* Param labels is the list of column labels from the parsed table
+	* Param table is the 2D list of string data from the parsed table
+	* Param collapse is whether the whole table becomes one row (the best hit per column)
+	* Param sampleName is the row label used when collapse is set
+	*/
+	void addHeatmapRows(
+		heatmap_t* heatmap, const vector<string>& labels, const vector<vector<string>>& table,
+		bool collapse, const string& sampleName
+	);
+
+
+	/*Renders a heatmap of identity values, with samples as rows and databases as columns
+	*
+	* Precondition: renderer != nullptr AND texture != nullptr AND font != nullptr AND
+	*		texture is img_w x img_h
+	* Postcondition: texture and the renderer's target surface hold the finished heatmap
+	*
+	* Param renderer is the SDL_Renderer that will draw the heatmap
+	* Param texture is the SDL_Texture that the heatmap is drawn onto
+	* Param font is the TTF_Font used for all of the heatmap's text
+	* Param title is the heading printed above the heatmap
+	* Param heatmap is the populated heatmap data
+	* Param img_w is the width of the texture in pixels
+	* Param img_h is the height of the texture in pixels
+	*/
+	void renderHeatmap(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font, const string& title,
+		const heatmap_t& heatmap, int img_w, int img_h
+	);
+
 }
 
 #endif
\ No newline at end of file
@@ -4,22 +4,119 @@
 
 #include <fstream>
 #include <vector>
+#include <map>
 #include <iostream>
+#include <streambuf>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+#include "./configuration.h"
+#include "./utils.h"
+
+
+//Compressed inputs are recognised by their extension: .gz for gzip, .zst for zstd.
+// Reading them needs zlib or libzstd, which are built in whenever their headers are found
+#define COMPRESSION_NONE 0
+#define COMPRESSION_GZIP 1
+#define COMPRESSION_ZSTD 2
+//Compressed inputs at least this big are decompressed on a helper thread
+#define INFLATE_THREAD_MIN_BYTES (1 << 20)
+//The size of each block of decompressed text, and how many blocks a helper thread
+// can decompress ahead of the parser
+#define INFLATE_BLOCK_SIZE (1 << 16)
+#define INFLATE_BLOCKS 4
 
 
 namespace filectrl {
 	using std::ifstream; using std::string;
 
-	/*Takes in a directory and filename, and opens an input stream to read data
-	*  from the file.
+	struct archiveEntry_t {
+		std::string name;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	struct archive_t {
+		std::ofstream out;
+		std::string path;
+		uint64_t offset;
+		std::vector<archiveEntry_t> index;
+		std::vector<char> writeBuffer;
+	};
+
+	//This stream buffer hands out the decompressed text of a gzip or zstd file as it's
+	// read, so a compressed summary goes straight into the parser. Small files are
+	// decompressed a block at a time whenever the parser runs out of text. Large ones
+	// are decompressed on a helper thread, which fills the next blocks while the
+	// parser works through the current one
+	struct inflateBuf_t : public std::streambuf {
+		std::streambuf* src = nullptr;
+		int format = COMPRESSION_NONE;
+		void* gzipState = nullptr;
+		void* zstdState = nullptr;
+		std::vector<char> input;
+		size_t inputPos = 0, inputEnd = 0;
+		bool sourceDone = false, frameOpen = false;
+
+		std::vector<char> blocks[INFLATE_BLOCKS];
+		size_t blockSizes[INFLATE_BLOCKS] = {};
+		size_t produced = 0, consumed = 0;
+		bool threaded = false, holding = false, finished = false, stopping = false;
+		std::string error;
+		std::thread helper;
+		std::mutex lock;
+		std::condition_variable changed;
+
+		~inflateBuf_t();
+		int_type underflow() override;
+		void discard() { setg(nullptr, nullptr, nullptr); }
+	};
+
+	//This struct reads input files, and is reused from file to file. Its stream reads
+	// the file directly, or through the inflater when the file is compressed
+	struct reader_t {
+		std::istream in{ nullptr };
+		std::filebuf file;
+		inflateBuf_t inflater;
+		std::string path;
+		std::vector<char> readBuffer;
+	};
+
+	struct mappedFile_t {
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+	};
+
+	//Raw ABRicate outputs grouped by the sample they were run on, sorted by sample name
+	typedef std::map<std::string, std::vector<std::string>> outputGroups_t;
+
+	/*Opens a file for reading through a reader that is reused from file to file. The
+	*  reader keeps its path and read buffer between files, so reopening it doesn't
+	*  allocate once it has seen the longest path of a batch. Files ending in .gz or
+	*  .zst are decompressed as they're read, on a helper thread when they're large.
+	*  A file that turns out to be corrupt throws from the read that reaches the damage
+	*
+	* Precondition: reader != nullptr
+	* Postcondition: reader->in is open on the file, any file it had open is closed
 	*
 	* Param directory is the directory that the file is found in. Can be absolute
 	*  or relative to the executable
 	* Param filename is the name of the file within the directory to open
+	* Param reader is the reader being pointed at the file
+	*/
+	void loadFile(const string& directory, const string& filename, reader_t* reader);
+
+
+	/*Closes the file a reader has open, stopping its helper thread if it has one
 	*
-	* Return a filestream object that allows the system to read data from the file
+	* Precondition: reader != nullptr
+	* Postcondition: reader has no file open
+	*
+	* Param reader is the reader being closed
 	*/
-	ifstream loadFile(string directory, string filename);
+	void closeFile(reader_t* reader);
 
 
 	/*Takes in a location (file path, absolute/relative directory) and finds a
@@ -36,17 +133,265 @@ namespace filectrl {
 	* Returns a vector of strings containing the filenames present in the
 	*  provided location
 	*/
-	std::vector<std::string> gatherFilenames(std::string loc, std::string* directory);
+	std::vector<std::string> gatherFilenames(const std::string& loc, std::string* directory);
+
+
+	/*Maps a whole file into memory read-only, so it can be read in place without
+	*  copying it into a buffer first
+	*
+	* Precondition: map != nullptr AND map is not already mapped
+	* Postcondition: map->data points at the file's contents until unmapFile is called
+	*
+	* Param path is the path of the file being mapped
+	* Param map is populated with the location and size of the mapping
+	* Returns false if the file doesn't exist, can't be read or is empty, true OW
+	*/
+	bool mapFile(const std::string& path, mappedFile_t* map);
+
+
+	/*Releases a file mapped by mapFile
+	*
+	* Postcondition: map->data == nullptr AND map->size == 0
+	*
+	* Param map is the mapping being released
+	*/
+	void unmapFile(mappedFile_t* map);
+
+
+	/*Splits the name of a raw ABRicate output into the sample and the database it was
+	*  run against, from a name like SAMPLE_database_out.tab (or .tab.gz/.tab.zst).
+	*  Names without an _out or .tab ending are split the same way at their last underscore
+	*
+	* Param filename is the name of the output, without its path
+	* Param sample is populated with the name of the sample
+	* Param database is populated with the name of the database
+	* Returns true IFF the name ends in _out.tab, like ABRicate outputs usually do
+	*/
+	bool splitOutputName(const string& filename, string* sample, string* database);
+
+
+	/*Groups a list of raw ABRicate outputs by the sample each was run on, so all of a
+	*  sample's outputs can be read into one summary. Files not named like an output
+	*  (SAMPLE_database_out.tab) are left out
+	*
+	* Param filenames is the list of file names, without their paths
+	* Param groups is populated with each sample's outputs, replacing whatever it held
+	*/
+	void groupOutputs(const std::vector<string>& filenames, outputGroups_t* groups);
+
 
+	/*Checks whether a file is one of AbrPrint's parsed summary caches or cohort stores,
+	*  which can sit beside the summaries but are never graphed as summaries themselves
+	*
+	* Param filename is the name of the file
+	* Returns true IFF the file is a cache or store file, or a partly written one
+	*/
+	bool isCacheFile(const std::string& filename);
 
-	/*
+
+	/*Encodes a surface into an in-memory image buffer
+	*
+	* Param surface is the SDL_Surface holding the finished image
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	*
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> encodeSurface(SDL_Surface* surface, const std::string& fileType);
+
+
+	/*Encodes a surface into a caller-owned image buffer, replacing its contents but
+	*  keeping its capacity so a buffer reused across a batch stops allocating
+	*
+	* Param surface is the SDL_Surface holding the finished image
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param encoded is the buffer receiving the complete encoded image file
+	*/
+	void encodeSurface(
+		SDL_Surface* surface, const std::string& fileType, std::vector<unsigned char>* encoded
+	);
+
+
+	/*Encodes a surface into a caller-owned image buffer at a given JPEG quality
+	*
+	* Param surface is the SDL_Surface holding the finished image
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param quality is the JPEG quality from 1 to 100, which other formats ignore
+	* Param encoded is the buffer receiving the complete encoded image file
+	*/
+	void encodeSurface(
+		SDL_Surface* surface, const std::string& fileType, int quality,
+		std::vector<unsigned char>* encoded
+	);
+
+
+	/*Encodes a generated graph into an in-memory image buffer
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param graph is the graph texture being encoded
+	*
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> encodeGraph(
+		SDL_Renderer* renderer, const std::string& fileType, SDL_Texture* graph
+	);
+
+
+	/*Reads a generated graph back into a surface kept by the calling thread, so only
+	*  the first graph of each size pays for creating it
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param graph is the graph texture being read
+	* Returns the surface holding the graph, which stays valid until the calling thread
+	*  reads another graph back or finishes
+	*/
+	SDL_Surface* readGraph(SDL_Renderer* renderer, SDL_Texture* graph);
+
+
+	/*Encodes a generated graph into a caller-owned image buffer. The pixels are read
+	*  back into a surface kept by the calling thread, so only the first graph of each
+	*  size pays for creating it
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param graph is the graph texture being encoded
+	* Param encoded is the buffer receiving the complete encoded image file
+	*/
+	void encodeGraph(
+		SDL_Renderer* renderer, const std::string& fileType, SDL_Texture* graph,
+		std::vector<unsigned char>* encoded
+	);
+
+
+	/*Encodes one finished graph into every output target. Targets smaller than the
+	*  graph are shrunk from it first, and each target is shrunk and encoded on a worker
+	*  of its own, the calling thread included. The workers are the pool's, which stay
+	*  up from graph to graph, so no threads are started per graph
+	*
+	* Precondition: frame is a 32 bit surface AND every target fits inside it
+	* Postcondition: encoded holds one encoded image per target, in the same order
+	*
+	* Param frame is the finished graph, which is only read
+	* Param targets is the list of images being made
+	* Param encoded is resized to one buffer per target, keeping their capacity
+	* Param workers is the worker pool the targets are encoded on
+	*/
+	void encodeTargets(
+		SDL_Surface* frame, const std::vector<util::outputTarget_t>& targets,
+		std::vector<std::vector<unsigned char>>* encoded, util::workerPool_t* workers
+	);
+
+
+	/*Builds the graph type an output target is named with, which gains the target's
+	*  size when it's shrunk from the graph
+	*
+	* Param target is the output target
+	* Param graphType is the kind of graph being made
+	* Returns the graph type to name the target's image with, e.g. bargraph_300x200
+	*/
+	std::string targetGraphType(const util::outputTarget_t& target, const std::string& graphType);
+
+
+	/*Builds the name of an output image from the file that produced it
+	*
+	* Param sourceName is the name of the file that produced the graph
+	* Param fileType is the extension of the file
+	* Param graphType is the kind of graph being made
+	*
+	* Returns the output name, e.g. test123_bargraph.png for test123.tab
+	*/
+	std::string graphFileName(
+		const std::string& sourceName, const std::string& fileType, const std::string& graphType
+	);
+
+
+	/*Writes an already encoded image into the output directory, naming it after
+	*  the file that produced it
+	*
+	* Param encoded is the encoded image file being written
+	* Param sourceName is the name of the file that produced the image
+	* Param fileType is the extension of the file
+	* Param directory is the directory that the file is being written to
+	* Param graphType is the kind of graph being made
+	*/
+	void saveEncodedToFile(
+		const std::vector<unsigned char>& encoded, const std::string& sourceName,
+		const std::string& fileType, const std::string& directory, const std::string& graphType
+	);
+
+
+	/*Saves a generated graph to a file
+	*
+	* Param renderer is the SDL_Renderer that will render the graph onto it
+	* Param sourceName is the name of the file that produced the graph
+	* Param fileType is the extension of the file
+	* Param directory is the directory that the file is being written to
+	* Param graphType is the kind of graph being made (currently only supports
+	*   bargraph)
+	* Param graph is the actual graph being written to the file
 	*/
 	void saveGraphToFile(
 		SDL_Renderer* renderer,
-		std::string sourceName, std::string fileType, std::string directory,
-		std::string graphType, SDL_Texture* graph
+		const std::string& sourceName, const std::string& fileType, const std::string& directory,
+		const std::string& graphType, SDL_Texture* graph
+	);
+
+
+	/*Writes a generated graph to STDOUT as an encoded image, for use at the end
+	*  of a shell pipeline
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param graph is the graph texture being written
+	*/
+	void writeGraphToStdout(
+		SDL_Renderer* renderer, const std::string& fileType, SDL_Texture* graph
+	);
+
+
+	/*Writes an already encoded image to STDOUT, for use at the end of a shell pipeline
+	*
+	* Param encoded is the encoded image file being written
+	*/
+	void writeEncodedToStdout(const std::vector<unsigned char>& encoded);
+
+
+	/*Opens a tar archive that a batch of encoded graphs will be streamed into
+	*
+	* Precondition: archive != nullptr
+	* Postcondition: archive is open for appending, with an empty index
+	*
+	* Param archive is the archive being opened
+	* Param path is the location of the archive file, which will be overwritten
+	*/
+	void openArchive(archive_t* archive, const std::string& path);
+
+
+	/*Appends an encoded graph to an open archive as a new tar member, and notes
+	*  where its data landed in the archive's index
+	*
+	* Precondition: archive was opened by openArchive AND name is under 100 characters
+	*
+	* Param archive is the archive being written to
+	* Param name is the name of the member inside the archive
+	* Param data is the encoded image being stored
+	*/
+	void appendToArchive(
+		archive_t* archive, const std::string& name, const std::vector<unsigned char>& data
 	);
 
+
+	/*Finishes an archive. The offset table is written both as a final index.tsv member
+	*  of the tar and as a sidecar file (the archive's path with .idx appended) so
+	*  readers can seek straight to any graph without walking the tar headers
+	*
+	* Precondition: archive was opened by openArchive
+	* Postcondition: archive is closed and both copies of the index are written
+	*
+	* Param archive is the archive being closed
+	*/
+	void closeArchive(archive_t* archive);
+
 }
 
 
@@ -0,0 +1,100 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+
+#include <string>
+#include <chrono>
+#include <stdint.h>
+
+
+namespace prof {
+
+	//Whether stage timings are being collected. Timers do nothing while this is false
+	extern bool enabled;
+
+	//Whether heap allocations are reported alongside the timings
+	extern bool memory;
+
+	//Whether each timed scope is also kept as a span for the trace export
+	extern bool tracing;
+
+	//Running allocation totals for each thread. These are plain integers so that counting
+	// an allocation never allocates anything itself. Only the AbrPrint program links in
+	// the operator new that counts them (src/allochook.cpp), so they stay at zero in any
+	// other program built from these sources
+	extern thread_local uint64_t threadAllocs;
+	extern thread_local uint64_t threadBytes;
+
+
+	//This struct times the scope it lives in and records the result against a stage
+	struct scopedTimer_t {
+		const char* stage;
+		std::chrono::steady_clock::time_point start;
+		uint64_t startAllocs, startBytes;
+
+		scopedTimer_t(const char* stageName);
+		~scopedTimer_t();
+	};
+
+
+	//This struct times the scope it lives in and records the result against an input file
+	struct fileScope_t {
+		std::string file;
+		std::chrono::steady_clock::time_point start;
+		uint64_t startAllocs, startBytes;
+
+		fileScope_t(const std::string& fileName);
+		~fileScope_t();
+	};
+
+
+	/*Reads the running totals of heap allocations made by the calling thread. Every
+	*  call to the global operator new is counted, whether or not profiling is enabled,
+	*  as long as the allocation hook is linked in
+	*
+	* Param allocs is populated with the number of allocations made
+	* Param bytes is populated with the number of bytes requested
+	*/
+	void threadAllocations(uint64_t* allocs, uint64_t* bytes);
+
+
+	/*Reads the peak resident set size of the process
+	*
+	* Returns the peak resident set size in bytes, 0 if the platform can't report it
+	*/
+	uint64_t peakRss();
+
+
+	/*Records a single timing sample against a stage
+	*
+	* Param stage is the name of the stage that was timed
+	* Param ms is the time the stage took, in milliseconds
+	* Param allocs is the number of heap allocations the stage made
+	* Param bytes is the number of bytes the stage allocated
+	*/
+	void record(const char* stage, double ms, uint64_t allocs = 0, uint64_t bytes = 0);
+
+
+	/*Writes the aggregated timings of every stage to a JSON file. Each stage reports
+	*  its count, total, min, max, p50 and p99 in milliseconds, in the order the stages
+	*  first ran. Each file reports the time spent on it. When memory is set, stages and
+	*  files also report their allocation counts and bytes, and the process its peak RSS
+	*
+	* Param path is the location of the JSON report, which will be overwritten
+	*/
+	void writeReport(std::string path);
+
+
+
+	/*Writes every recorded span to a JSON file in the Chrome Trace Event format, for
+	*  viewing in Perfetto or chrome://tracing. Stages are grouped into the categories
+	*  parse, layout, frame, text, bars, encode and write, each file gets a span of its
+	*  own, and every thread gets its own track
+	*
+	* Param path is the location of the trace file, which will be overwritten
+	*/
+	void writeTrace(std::string path);
+
+}
+
+#endif
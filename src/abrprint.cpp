@@ -0,0 +1,151 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+
+#include "../abrprint.h"
+#include "../utils.h"
+#include "../dataprocessing.h"
+#include "../filectrl.h"
+
+
+namespace abr {
+
+	/*Initializes the graphics and text libraries used for rendering. This must be
+	*  called once before any graphs are rendered
+	*/
+	void init() {
+		ABR_DEBUG(2, "abr::init():");
+		if (TTF_Init() < 0) throw "abr::init(): " + (std::string)TTF_GetError();
+	}
+
+
+	/*Shuts down the graphics and text libraries started by init()*/
+	void quit() {
+		ABR_DEBUG(2, "abr::quit():");
+		TTF_Quit();
+	}
+
+
+	/*Parses the text of an Abricate combined summary into a table
+	*
+	* Param buffer is the full text of the summary, header line included
+	* Returns the parsed table, with one column per label
+	*/
+	table_t parseTable(const std::string& buffer) {
+		ABR_DEBUG(2, "abr::parseTable():");
+
+		std::istringstream src(buffer);
+		table_t table;
+		try {
+			table.labels = proc::makeLabels("buffer", &src);
+			table.columns = proc::makeTable("buffer", table.labels, &src);
+		}
+		catch (const char* err) {
+			throw "abr::parseTable(): " + (std::string)err;
+		}
+		catch (std::string err) {
+			throw "abr::parseTable(): " + err;
+		}
+
+		ABR_DEBUG(2, "  Buffer parsed, returning...");
+		return table;
+	}
+
+
+	/*Renders a bar graph from a parsed table and encodes it as an image
+	*
+	* Precondition: init() has been called AND style.fontData != nullptr
+	*
+	* Param table is the parsed summary being graphed
+	* Param style is the set of rendering options for the graph
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> renderGraph(const table_t& table, const style_t& style) {
+		ABR_DEBUG(2, "abr::renderGraph():");
+
+		if (style.fontData == nullptr || style.fontDataSize == 0)
+			throw (std::string)"abr::renderGraph(): No font data provided";
+		if (style.width <= 0 || style.height <= 0)
+			throw (std::string)"abr::renderGraph(): Image dimensions must be positive";
+
+		//The layout is scaled to fit the style's size, like -r does for the program
+		double layoutScale = std::min(
+			(double)style.width / util::BASE_IMG_W, (double)style.height / util::BASE_IMG_H
+		);
+
+		//Load the typeface straight from the caller's buffer, scaled along with the layout
+		ABR_DEBUG(2, "  Loading typeface from memory");
+		SDL_RWops* fontSrc = SDL_RWFromConstMem(style.fontData, (int)style.fontDataSize);
+		if (!fontSrc) throw "abr::renderGraph(): " + (std::string)SDL_GetError();
+		TTF_Font* font = TTF_OpenFontRW(
+			fontSrc, 1, std::max(1, (int)std::lround(style.fontSize * layoutScale))
+		);
+		if (!font) throw "abr::renderGraph(): " + (std::string)TTF_GetError();
+
+		//Only this thread draws at the style's scale, leaving the program's own alone
+		double callerScale = util::threadScale;
+		util::threadScale = layoutScale;
+
+		//Each call gets its own surface, renderer and texture so nothing is shared
+		ABR_DEBUG(2, "  Creating graphics elements");
+		SDL_Surface* surf = nullptr; SDL_Renderer* renderer = nullptr; SDL_Texture* texture = nullptr;
+		std::vector<unsigned char> encoded;
+		try {
+			renderer = util::generateRenderer(&surf, style.width, style.height);
+			texture = util::generateTexture(renderer, style.width, style.height);
+
+			ABR_DEBUG(2, "  Rendering and encoding graph");
+			proc::renderBarGraph(
+				renderer, texture, font, style.title, table.labels, table.columns,
+				style.width, style.height
+			);
+			encoded = filectrl::encodeGraph(renderer, style.fileType, texture);
+		}
+		catch (const char* err) {
+			if (texture) SDL_DestroyTexture(texture);
+			if (renderer) util::releaseTextCache(renderer);
+			if (renderer) SDL_DestroyRenderer(renderer);
+			if (surf) SDL_FreeSurface(surf);
+			TTF_CloseFont(font);
+			util::threadScale = callerScale;
+			throw "abr::renderGraph(): " + (std::string)err;
+		}
+		catch (std::string err) {
+			if (texture) SDL_DestroyTexture(texture);
+			if (renderer) util::releaseTextCache(renderer);
+			if (renderer) SDL_DestroyRenderer(renderer);
+			if (surf) SDL_FreeSurface(surf);
+			TTF_CloseFont(font);
+			util::threadScale = callerScale;
+			throw "abr::renderGraph(): " + err;
+		}
+
+		//Clean up the graphics elements
+		ABR_DEBUG(2, "  Releasing graphics elements");
+		SDL_DestroyTexture(texture);
+		util::releaseTextCache(renderer);
+		SDL_DestroyRenderer(renderer);
+		SDL_FreeSurface(surf);
+		TTF_CloseFont(font);
+		util::threadScale = callerScale;
+
+		ABR_DEBUG(2, "  Graph rendered, returning...");
+		return encoded;
+	}
+
+
+	/*Parses the text of an Abricate combined summary and renders it as an encoded image
+	*
+	* Precondition: init() has been called AND style.fontData != nullptr
+	*
+	* Param buffer is the full text of the summary, header line included
+	* Param style is the set of rendering options for the graph
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> renderGraph(const std::string& buffer, const style_t& style) {
+		return renderGraph(parseTable(buffer), style);
+	}
+
+}
@@ -0,0 +1,111 @@
+#include <new>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "../profiler.h"
+
+
+//Replacement global allocation functions, counting every allocation made through new
+// into the profiler's per-thread totals. Replacing operator new swaps the allocator of
+// the whole program, so this file belongs to the AbrPrint program alone and is never
+// built into anything that embeds the graphing sources. The nothrow forms from the
+// standard library all route through the throwing ones replaced here
+
+
+/*Allocates a block, counting it against the calling thread. A failed allocation calls
+*  the installed new_handler and tries again, as the standard operator new does
+*
+* Param size is the number of bytes requested
+* Param alignment is the alignment the block needs, 0 for malloc's own
+* Returns the allocated block
+*/
+static void* countedAlloc(std::size_t size, std::size_t alignment) {
+	prof::threadAllocs++;
+	prof::threadBytes += size;
+	if (size == 0) size = 1;
+
+	while (true) {
+		void* block = nullptr;
+		if (alignment == 0) block = std::malloc(size);
+#ifdef _WIN32
+		else block = _aligned_malloc(size, alignment);
+#else
+		else if (posix_memalign(&block, alignment, size) != 0) block = nullptr;
+#endif
+		if (block) return block;
+
+		std::new_handler handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+
+/*Frees a block made by countedAlloc
+*
+* Param block is the block being freed, which may be nullptr
+* Param aligned is whether the block was made with an alignment
+*/
+static void countedFree(void* block, bool aligned) {
+#ifdef _WIN32
+	if (aligned) {
+		_aligned_free(block);
+		return;
+	}
+#else
+	(void)aligned;
+#endif
+	std::free(block);
+}
+
+
+void* operator new(std::size_t size) {
+	return countedAlloc(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+	return countedAlloc(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	return countedAlloc(size, (std::size_t)alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return countedAlloc(size, (std::size_t)alignment);
+}
+
+void operator delete(void* block) noexcept {
+	countedFree(block, false);
+}
+
+void operator delete[](void* block) noexcept {
+	countedFree(block, false);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+	countedFree(block, false);
+}
+
+void operator delete[](void* block, std::size_t) noexcept {
+	countedFree(block, false);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+	countedFree(block, true);
+}
+
+void operator delete[](void* block, std::align_val_t) noexcept {
+	countedFree(block, true);
+}
+
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept {
+	countedFree(block, true);
+}
+
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept {
+	countedFree(block, true);
+}
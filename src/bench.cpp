@@ -0,0 +1,694 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <SDL_Image.h>
+
+#include "../bench.h"
+#include "../utils.h"
+#include "../dataprocessing.h"
+#include "../filectrl.h"
+
+
+namespace bench {
+	using std::string; using std::vector;
+
+	//Results of the timed calls are folded in here so the optimizer can't drop the work
+	static volatile size_t sink = 0;
+
+
+	//Gene stems that synthetic column names are built from, so headers look like real ones
+	static const char* geneStems[] = {
+		"blaOXA", "blaTEM", "blaADC", "aac(6')-Ib", "aph(3'')-Ib", "aph(6)-Id", "sul",
+		"tet(A)", "tet(B)", "qnrB", "msr(E)", "mph(E)", "catA", "floR", "armA", "ant(3'')-Ia"
+	};
+
+	//The databases Abricate is usually run against, one row per sample and database
+	static const char* databases[] = {
+		"argannot", "card", "ecoh", "megares", "ncbi", "plasmidfinder", "resfinder", "vfdb"
+	};
+
+
+	/*Writes an identity value between 80.00 and 100.00 without going through printf,
+	*  which would dominate the time taken to write a million-row summary
+	*
+	* Param dest is the buffer the value is written into, with room for 6 characters
+	* Param hundredths is the value in hundredths of a percent, 8000 to 10000
+	* Returns the number of characters written
+	*/
+	static int writeIdentity(char* dest, unsigned int hundredths) {
+		int len = 0;
+		unsigned int whole = hundredths / 100, frac = hundredths % 100;
+		if (whole >= 100) dest[len++] = '0' + whole / 100;
+		dest[len++] = '0' + (whole / 10) % 10;
+		dest[len++] = '0' + whole % 10;
+		dest[len++] = '.';
+		dest[len++] = '0' + frac / 10;
+		dest[len++] = '0' + frac % 10;
+		return len;
+	}
+
+
+	/*Streams a synthetic Abricate summary, laid out exactly like the output of
+	*  abricate --summary with rows cycling through the usual databases. The same spec
+	*  always produces the same summary, byte for byte, on every platform
+	*
+	* Precondition: out != nullptr AND spec.rows >= 0 AND spec.genes > 0 AND
+	*		density and multiHit are between 0 and 1
+	*
+	* Param spec is the shape of the summary: its row and gene column counts, the share
+	*  of cells with a hit, the share of hits that list a second identity, and the seed
+	* Param out is the stream the summary is written to
+	*/
+	void writeSummary(const summarySpec_t& spec, std::ostream* out) {
+		ABR_DEBUG(2, "writeSummary():");
+
+		//A small LCG keeps the output identical on every platform, unlike std::rand
+		unsigned int state = spec.seed;
+		auto next = [&state]() {
+			state = state * 1664525u + 1013904223u;
+			return state >> 8;
+		};
+
+		//Compare the rolls as 24 bit integers rather than converting each one to a double
+		unsigned int hitCutoff = (unsigned int)(spec.density * (1u << 24));
+		unsigned int multiCutoff = (unsigned int)(spec.multiHit * (1u << 24));
+
+		ABR_DEBUG(2, "  Writing summary header");
+		const size_t stemCount = sizeof(geneStems) / sizeof(geneStems[0]);
+		std::string header = "#FILE\tNUM_FOUND";
+		for (int x = 0; x < spec.genes; x++)
+			header += "\t" + std::string(geneStems[x % stemCount]) + "_" + std::to_string(x / stemCount + 1);
+		*out << header << "\n";
+
+		//Each row is built in one buffer and written out whole
+		ABR_DEBUG(2, "  Writing summary rows");
+		const size_t dbCount = sizeof(databases) / sizeof(databases[0]);
+		vector<char> cells(spec.genes * 14);
+		char prefix[128];
+		for (long x = 0; x < spec.rows; x++) {
+			size_t len = 0;
+			int found = 0;
+			for (int y = 0; y < spec.genes; y++) {
+				cells[len++] = '\t';
+				if (next() >= hitCutoff) {
+					cells[len++] = '.';
+					continue;
+				}
+
+				len += writeIdentity(&cells[len], 8000 + next() % 2001);
+				if (next() < multiCutoff) {
+					cells[len++] = ';';
+					len += writeIdentity(&cells[len], 8000 + next() % 2001);
+				}
+				found++;
+			}
+
+			int prefixLen = snprintf(prefix, sizeof(prefix),
+				"/synthetic/abricate_results/SAMPLE_%06ld_%s_out.tab\t%d",
+				x / (long)dbCount, databases[x % dbCount], found
+			);
+			out->write(prefix, prefixLen);
+			out->write(cells.data(), len);
+			out->put('\n');
+		}
+
+		if (!*out) throw "bench::writeSummary(): Error writing synthetic summary";
+
+		ABR_DEBUG(2, "  Summary written, returning...");
+		return;
+	}
+
+
+	/*Builds a synthetic Abricate summary in memory
+	*
+	* Param spec is the shape of the summary (see writeSummary)
+	* Returns the full text of the summary, header included
+	*/
+	string syntheticSummary(const summarySpec_t& spec) {
+		std::ostringstream summary;
+		writeSummary(spec, &summary);
+		return summary.str();
+	}
+
+
+	/*Times repeated runs of a single stage and writes out its line of results
+	*
+	* Param out is the stream the results are written to
+	* Param stage is the name of the stage being timed
+	* Param input is the name of the input the stage is timed against
+	* Param iterations is the number of timed runs
+	* Param setup is run before every run of the stage, outside of the timer
+	* Param body is the stage being timed
+	*/
+	template <typename Setup, typename Body>
+	static void measure(
+		std::ostream* out, const char* stage, const string& input, int iterations,
+		Setup setup, Body body
+		) {
+		ABR_DEBUG(3, "    Timing " + string(stage) + " on " + input);
+
+		//One untimed run to warm the caches and any state SDL creates lazily
+		setup();
+		body();
+
+		vector<double> samples;
+		samples.reserve(iterations);
+		for (int x = 0; x < iterations; x++) {
+			setup();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			body();
+			std::chrono::duration<double, std::micro> elapsed =
+				std::chrono::steady_clock::now() - start;
+			samples.push_back(elapsed.count());
+		}
+
+		std::sort(samples.begin(), samples.end());
+		double total = 0;
+		for (double us : samples) total += us;
+
+		char line[512];
+		snprintf(line, sizeof(line), "%s\t%s\t%d\t%.3f\t%.3f\t%.3f\n",
+			stage, input.c_str(), iterations, samples.front(),
+			samples[(samples.size() - 1) / 2], total / samples.size()
+		);
+		*out << line << std::flush;
+	}
+
+
+	/*Sets up the graph information for a table the same way renderBarGraph does
+	*
+	* Param labels is the list of column labels from the parsed table
+	* Param table is the 2D list of string data from the parsed table
+	* Returns the graph information, with everything but the data range filled in
+	*/
+	static proc::graphData_t graphInfoFor(
+		const vector<string>& labels, const vector<vector<string>>& table
+		) {
+		size_t fileindex = 0;
+		for (size_t x = 0; x < labels.size(); x++)
+			if (labels[x] == "FILE") fileindex = x;
+
+		proc::graphData_t graphInfo;
+		graphInfo.framepos = {
+			util::scaled(75), util::scaled(110),
+			util::IMG_W - util::scaled(125), util::IMG_H - util::scaled(300)
+		};
+		for (const string& file : table[fileindex])
+			graphInfo.fileList.push_back(std::pair<string, int>(file, 0));
+		graphInfo.vertDivisions = 10;
+		return graphInfo;
+	}
+
+
+	/*Times each of the hot stages of graph generation against the given summaries plus
+	*  a set of scaled-up synthetic ones, and writes one tab-separated line per stage and
+	*  input. Inputs are run in a fixed order and the columns never change, so two runs
+	*  can be compared with a plain diff or join
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer, texture and font are
+	*		not nullptr AND texture is util::IMG_W x util::IMG_H AND iterations > 0
+	* Postcondition: texture holds whatever was drawn last
+	*
+	* Param renderer is the SDL_Renderer used by the drawing stages
+	* Param texture is the SDL_Texture the drawing stages draw onto
+	* Param font is the TTF_Font used by the text stages
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to benchmark
+	* Param iterations is the number of timed runs of each stage on each input
+	* Param out is the stream the results are written to
+	*/
+	void runBenchmarks(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font,
+		string directory, vector<string> filenames, int iterations, std::ostream* out
+		) {
+		ABR_DEBUG(2, "runBenchmarks():");
+
+		//Directory listings come back in any order, so sort them to keep runs comparable
+		ABR_DEBUG(2, "  Reading each summary into memory");
+		std::sort(filenames.begin(), filenames.end());
+		vector<std::pair<string, string>> inputs;
+		filectrl::reader_t reader;
+		for (const string& filename : filenames) {
+			filectrl::loadFile(directory, filename, &reader);
+			std::stringstream contents;
+			contents << reader.in.rdbuf();
+			filectrl::closeFile(&reader);
+			inputs.push_back(std::pair<string, string>(filename, contents.str()));
+		}
+
+		//Scaled-up summaries show how each stage grows with the number of rows and genes.
+		// Every case is wider than the bar palette, which util::barColor wraps around
+		ABR_DEBUG(2, "  Building synthetic summaries");
+		const summarySpec_t synthSpecs[] = {
+			{ 32, 32, 0.33, 0.25, 33 }, { 128, 64, 0.33, 0.25, 33 }, { 512, 100, 0.33, 0.25, 33 }
+		};
+		for (const summarySpec_t& spec : synthSpecs)
+			inputs.push_back(std::pair<string, string>(
+				"synthetic_" + std::to_string(spec.rows) + "x" + std::to_string(spec.genes),
+				syntheticSummary(spec)
+			));
+
+		//Saved graphs go to a scratch directory so the real output directory is untouched
+		string scratchDir =
+			(std::filesystem::temp_directory_path() / "abrprint_bench").string() + "/";
+
+		*out << "#stage\tinput\titerations\tmin_us\tp50_us\tmean_us" << std::endl;
+
+		ABR_DEBUG(2, "  Timing stages on each input");
+		for (const std::pair<string, string>& input : inputs) {
+			const string& name = input.first;
+			const string& text = input.second;
+			std::istringstream stream;
+
+			vector<string> labels;
+			measure(out, "makeLabels", name, iterations,
+				[&]() { stream.clear(); stream.str(text); },
+				[&]() { labels = proc::makeLabels(name, &stream); sink += labels.size(); }
+			);
+
+			vector<vector<string>> table;
+			measure(out, "makeTable", name, iterations,
+				[&]() {
+					stream.clear(); stream.str(text);
+					stream.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+				},
+				[&]() { table = proc::makeTable(name, labels, &stream); sink += table.size(); }
+			);
+
+			proc::graphData_t graphInfo = graphInfoFor(labels, table);
+			measure(out, "getDataRange", name, iterations,
+				[]() {},
+				[&]() { proc::getDataRange(table, &graphInfo); }
+			);
+
+			vector<proc::graphBar_t> bars;
+			measure(out, "generateBars", name, iterations,
+				[]() {},
+				[&]() { bars = proc::generateBars(graphInfo, labels, table); sink += bars.size(); }
+			);
+
+			vector<proc::graphBar_t> sorted;
+			measure(out, "focusShortBars", name, iterations,
+				[&]() { sorted = bars; },
+				[&]() { proc::focusShortBars(&sorted); }
+			);
+
+			proc::graphData_t frameInfo;
+			measure(out, "printGraphFrame", name, iterations,
+				[&]() { frameInfo = graphInfo; },
+				[&]() { proc::printGraphFrame(renderer, texture, &frameInfo, font); }
+			);
+
+			//Save the finished graph, so the encoder sees real image content
+			proc::renderBarGraph(
+				renderer, texture, font, name, labels, table, util::IMG_W, util::IMG_H
+			);
+			measure(out, "saveGraphToFile", name, iterations,
+				[]() {},
+				[&]() {
+					filectrl::saveGraphToFile(
+						renderer, name, util::ABR_OUTPUT_EXT, scratchDir, "bargraph", texture
+					);
+				}
+			);
+		}
+
+		//The drawing primitives don't depend on the input, so they're timed once
+		ABR_DEBUG(2, "  Timing drawing primitives");
+		measure(out, "printText", "horizontal", iterations,
+			[]() {},
+			[&]() {
+				util::printText(
+					renderer, texture, "ABA4_165_combined_summary.tab", 75, 10, 24, 0,
+					util::ABR_GRAPH_COLOR1, font, nullptr
+				);
+			}
+		);
+		measure(out, "printText", "rotated", iterations,
+			[]() {},
+			[&]() {
+				util::printText(
+					renderer, texture, "ABA4_165_combined_summary.tab", 75, 600, 24, -45,
+					util::ABR_GRAPH_COLOR1, font, nullptr
+				);
+			}
+		);
+		measure(out, "fillRect", "bar", iterations,
+			[]() {},
+			[&]() {
+				util::fillRect(renderer, texture, { 100, 110, 12, 500 }, util::ABR_GRAPH_COLOR1);
+			}
+		);
+		measure(out, "fillRect", "full", iterations,
+			[]() {},
+			[&]() {
+				util::fillRect(
+					renderer, texture, { 0, 0, util::IMG_W, util::IMG_H }, util::ABR_BKGD_COLOR
+				);
+			}
+		);
+
+		ABR_DEBUG(2, "  Removing scratch output");
+		std::error_code err;
+		std::filesystem::remove_all(scratchDir, err);
+
+		ABR_DEBUG(2, "  Benchmarks complete, returning...");
+		return;
+	}
+
+
+
+	//This struct holds what verification reuses from graph to graph, the same storage
+	// the batch loop keeps
+	struct verifyState_t {
+		proc::workspace_t ws;
+		filectrl::reader_t reader;
+		util::displayList_t displayList;
+		proc::bandCanvas_t bands;
+		string sourcePath, cachePath;
+		vector<vector<unsigned char>> encodedTargets;
+		vector<string> graphTypes;
+	};
+
+
+	/*Parses a summary and renders it as a bar graph, the same way the batch loop does.
+	*  A cache that still matches the summary stands in for parsing it when caching is
+	*  on. Graphs of 4K and up are recorded and drawn in bands on the pool's workers, and
+	*  smaller ones are drawn onto the texture and read back
+	*
+	* Param renderer is the SDL_Renderer used to draw the graph
+	* Param texture is the SDL_Texture the graph is drawn onto
+	* Param font is the TTF_Font used for the graph's text
+	* Param workers is the worker pool drawing the bands
+	* Param directory is the directory that the summary is found in
+	* Param filename is the name of the summary
+	* Param state is the storage reused across the summaries
+	* Returns the finished graph, which stays valid until the next graph is rendered
+	*/
+	static SDL_Surface* renderFile(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font, util::workerPool_t* workers,
+		const string& directory, const string& filename, verifyState_t* state
+		) {
+		bool cached = false;
+		if (util::tableCache) {
+			state->sourcePath.assign(directory).append(filename);
+			state->cachePath.assign(state->sourcePath).append(".abrc");
+			cached = proc::loadCache(state->cachePath, state->sourcePath, &state->ws);
+		}
+		if (!cached) {
+			filectrl::loadFile(directory, filename, &state->reader);
+			proc::makeLabels(filename, &state->reader.in, &state->ws);
+			proc::makeTable(filename, state->ws.labels, &state->reader.in, &state->ws);
+			filectrl::closeFile(&state->reader);
+			if (util::tableCache && !proc::saveCache(state->cachePath, state->sourcePath, state->ws))
+				ABR_DEBUG(2, "  Unable to write cache file " + state->cachePath);
+		}
+
+		bool banded = (long long)util::IMG_W * util::IMG_H >= BANDED_MIN_PIXELS;
+		if (banded) {
+			state->displayList.ops.clear();
+			util::recording = &state->displayList;
+		}
+		proc::renderBarGraph(
+			renderer, texture, font, filename, state->ws.labels, state->ws.table,
+			util::IMG_W, util::IMG_H, &state->ws
+		);
+		util::recording = nullptr;
+
+		if (banded)
+			return proc::rasterizeBands(
+				state->displayList, workers, &state->bands, util::IMG_W, util::IMG_H
+			);
+		return filectrl::readGraph(renderer, texture);
+	}
+
+
+	/*Encodes a finished graph into every output target and writes them into a
+	*  directory, the same way the batch loop saves its graphs
+	*
+	* Param frame is the finished graph
+	* Param targets is the list of images being made
+	* Param workers is the worker pool the targets are encoded on
+	* Param directory is the directory the images are written to
+	* Param filename is the name of the summary the graph was made from
+	* Param state is the storage reused across the summaries
+	*/
+	static void saveFile(
+		SDL_Surface* frame, const vector<util::outputTarget_t>& targets,
+		util::workerPool_t* workers, const string& directory, const string& filename,
+		verifyState_t* state
+		) {
+		filectrl::encodeTargets(frame, targets, &state->encodedTargets, workers);
+		for (size_t t = 0; t < targets.size(); t++)
+			filectrl::saveEncodedToFile(
+				state->encodedTargets[t], filename, targets[t].type, directory, state->graphTypes[t]
+			);
+	}
+
+
+	/*Renders every given summary as a bar graph and compares it against a golden image,
+	*  then times a few passes over the whole set to check that throughput hasn't dropped.
+	*  Goldens are PNGs named like normal output (e.g. test123_bargraph.png), and the
+	*  throughput baseline is kept in throughput.tsv beside them. Blessing writes the
+	*  current output and throughput as the new goldens and baseline instead. Once the
+	*  timed passes have warmed everything up, one more pass checks that no graph
+	*  allocates anything on the heap. Graphs of 4K and up are drawn in bands on every
+	*  core, the way the batch loop draws them
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer, texture and font are
+	*		not nullptr AND texture is util::IMG_W x util::IMG_H
+	* Postcondition: texture holds the last graph rendered, unless it was drawn in bands
+	*
+	* Param renderer is the SDL_Renderer used to draw the graphs
+	* Param texture is the SDL_Texture the graphs are drawn onto
+	* Param font is the TTF_Font used for the graphs' text
+	* Param workers is the worker pool that encodes the targets and draws banded graphs
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to verify
+	* Param targets is the list of images each graph is saved as, the way the batch
+	*  loop saves it, while checking for allocations
+	* Param goldenDir is the directory holding the golden images and throughput baseline
+	* Param tolerance is the largest difference allowed in any color channel of a pixel,
+	*  0 for an exact match
+	* Param maxSlowdown is the largest drop in graphs per second allowed, in percent
+	* Param bless is whether to write new goldens rather than compare against them
+	* Param out is the stream the results are written to
+	* Returns the number of checks that failed
+	*/
+	int verifyGraphs(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font,
+		util::workerPool_t* workers, string directory, vector<string> filenames,
+		const vector<util::outputTarget_t>& targets, string goldenDir, int tolerance,
+		double maxSlowdown, bool bless, std::ostream* out
+		) {
+		ABR_DEBUG(2, "verifyGraphs():");
+		if (goldenDir.back() != '/') goldenDir += "/";
+		std::sort(filenames.begin(), filenames.end());
+		int failures = 0;
+		char line[512];
+
+		//Every pass renders and encodes through the same storage, like the batch loop
+		verifyState_t state;
+		vector<unsigned char> encoded;
+		for (const util::outputTarget_t& target : targets)
+			state.graphTypes.push_back(filectrl::targetGraphType(target, "bargraph"));
+
+		//Graphs of 4K and up are drawn in bands on every worker, as the batch loop draws
+		// them, with a typeface for each
+		state.bands.fonts = { font };
+		if ((long long)util::IMG_W * util::IMG_H >= BANDED_MIN_PIXELS)
+			while (state.bands.fonts.size() < workers->threads.size() + 1)
+				state.bands.fonts.push_back(util::getFont("Consolas", util::scaled(24)));
+
+		//A directory without a single golden can't check anything, so rather than fail
+		// every graph one by one it's refused as a whole
+		if (!bless) {
+			bool anyGolden = std::filesystem::exists(goldenDir + "throughput.tsv");
+			for (size_t x = 0; !anyGolden && x < filenames.size(); x++)
+				anyGolden = std::filesystem::exists(
+					goldenDir + filectrl::graphFileName(filenames[x], "PNG", "bargraph")
+				);
+			if (!anyGolden)
+				throw "bench::verifyGraphs(): " + goldenDir + " holds no goldens for these files, " +
+					"bless them on the reference build with --bless first";
+		}
+
+		//Check each graph pixel by pixel against its golden image
+		ABR_DEBUG(2, "  Comparing graphs against golden images");
+		for (const string& filename : filenames) {
+			SDL_Surface* frame = renderFile(
+				renderer, texture, font, workers, directory, filename, &state
+			);
+			string goldenName = filectrl::graphFileName(filename, "PNG", "bargraph");
+
+			//Blessing stores the graph losslessly as the new golden
+			if (bless) {
+				ABR_DEBUG(3, "    Blessing " + goldenName);
+				filectrl::encodeSurface(frame, "PNG", &encoded);
+				filectrl::saveEncodedToFile(encoded, filename, "PNG", goldenDir, "bargraph");
+				*out << "BLESS\t" << goldenName << std::endl;
+				continue;
+			}
+
+			ABR_DEBUG(3, "    Comparing " + goldenName);
+			SDL_Surface* loaded = IMG_Load((goldenDir + goldenName).c_str());
+			if (!loaded) {
+				*out << "FAIL\t" << goldenName << "\tmissing golden image" << std::endl;
+				failures++;
+				continue;
+			}
+			SDL_Surface* golden = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+			SDL_FreeSurface(loaded);
+			if (!golden) throw "bench::verifyGraphs(): " + (string)SDL_GetError();
+
+			if (golden->w != util::IMG_W || golden->h != util::IMG_H) {
+				snprintf(line, sizeof(line), "FAIL\t%s\tgolden is %dx%d, graph is %dx%d",
+					goldenName.c_str(), golden->w, golden->h, util::IMG_W, util::IMG_H);
+				*out << line << std::endl;
+				SDL_FreeSurface(golden);
+				failures++;
+				continue;
+			}
+
+			//Count the pixels where any channel is further off than the tolerance allows
+			SDL_Surface* graph = frame;
+			if (frame->format->format != SDL_PIXELFORMAT_RGBA32)
+				graph = SDL_ConvertSurfaceFormat(frame, SDL_PIXELFORMAT_RGBA32, 0);
+			if (!graph) {
+				SDL_FreeSurface(golden);
+				throw "bench::verifyGraphs(): " + (string)SDL_GetError();
+			}
+			long differing = 0;
+			int maxDiff = 0;
+			for (int y = 0; y < util::IMG_H; y++) {
+				const Uint8* goldenRow = (const Uint8*)golden->pixels + (size_t)y * golden->pitch;
+				const Uint8* graphRow = (const Uint8*)graph->pixels + (size_t)y * graph->pitch;
+				for (int x = 0; x < util::IMG_W; x++) {
+					int pixelDiff = 0;
+					for (int c = 0; c < 4; c++) {
+						int diff = std::abs((int)goldenRow[x * 4 + c] - (int)graphRow[x * 4 + c]);
+						if (diff > pixelDiff) pixelDiff = diff;
+					}
+					if (pixelDiff > tolerance) differing++;
+					if (pixelDiff > maxDiff) maxDiff = pixelDiff;
+				}
+			}
+			SDL_FreeSurface(golden);
+			if (graph != frame) SDL_FreeSurface(graph);
+
+			snprintf(line, sizeof(line), "%s\t%s\tdiffering_pixels=%ld\tmax_channel_diff=%d",
+				differing ? "FAIL" : "PASS", goldenName.c_str(), differing, maxDiff);
+			*out << line << std::endl;
+			if (differing) failures++;
+		}
+
+		//Time whole passes of parsing, drawing and encoding every target, keeping the best
+		// one so a single hiccup on a busy machine doesn't count as a regression
+		ABR_DEBUG(2, "  Measuring throughput");
+		double bestRate = 0;
+		for (int pass = 0; pass < 3 && !filenames.empty(); pass++) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (const string& filename : filenames) {
+				SDL_Surface* frame = renderFile(
+					renderer, texture, font, workers, directory, filename, &state
+				);
+				filectrl::encodeTargets(frame, targets, &state.encodedTargets, workers);
+				sink += state.encodedTargets[0].size();
+			}
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			double rate = filenames.size() / elapsed.count();
+			if (rate > bestRate) bestRate = rate;
+		}
+
+		//With the workspace, buffers and text cache warmed up by the passes above, a graph
+		// should go from summary to saved images without touching the heap. The graphs
+		// are saved as every target into a scratch directory, through the same calls the
+		// batch loop saves with, once to warm saving up and once more while counting.
+		// Allocations made inside SDL and the image libraries go through malloc and
+		// aren't counted
+		ABR_DEBUG(2, "  Checking for allocations once warmed up");
+		string scratchDir = (std::filesystem::temp_directory_path() / "abrprint_verify").string() + "/";
+		for (const string& filename : filenames) {
+			SDL_Surface* frame = renderFile(
+				renderer, texture, font, workers, directory, filename, &state
+			);
+			saveFile(frame, targets, workers, scratchDir, filename, &state);
+		}
+		int allocatingFiles = 0;
+		for (const string& filename : filenames) {
+			uint64_t startAllocs, startBytes, endAllocs, endBytes;
+			prof::threadAllocations(&startAllocs, &startBytes);
+			SDL_Surface* frame = renderFile(
+				renderer, texture, font, workers, directory, filename, &state
+			);
+			saveFile(frame, targets, workers, scratchDir, filename, &state);
+			prof::threadAllocations(&endAllocs, &endBytes);
+
+			if (endAllocs != startAllocs) {
+				snprintf(line, sizeof(line), "FAIL\tsteady_state\t%s\tallocs=%llu\tbytes=%llu",
+					filename.c_str(), (unsigned long long)(endAllocs - startAllocs),
+					(unsigned long long)(endBytes - startBytes));
+				*out << line << std::endl;
+				allocatingFiles++;
+			}
+		}
+		if (allocatingFiles == 0 && !filenames.empty()) {
+			snprintf(line, sizeof(line), "PASS\tsteady_state\t%zu graphs with no allocations",
+				filenames.size());
+			*out << line << std::endl;
+		}
+		failures += allocatingFiles;
+
+		ABR_DEBUG(2, "  Releasing the band workers and scratch directory");
+		std::error_code removeErr;
+		std::filesystem::remove_all(scratchDir, removeErr);
+		proc::releaseBands(workers, &state.bands);
+		for (size_t x = 1; x < state.bands.fonts.size(); x++) TTF_CloseFont(state.bands.fonts[x]);
+
+		string baselinePath = goldenDir + "throughput.tsv";
+		if (bless) {
+			ABR_DEBUG(2, "  Writing throughput baseline");
+			std::ofstream baseline(baselinePath, std::ios::out | std::ios::trunc);
+			if (!baseline.is_open())
+				throw "bench::verifyGraphs(): Error opening throughput baseline " + baselinePath;
+			snprintf(line, sizeof(line), "graphs_per_second\t%.3f\n", bestRate);
+			baseline << line;
+			baseline.close();
+
+			snprintf(line, sizeof(line), "BLESS\tthroughput\t%.3f graphs/s", bestRate);
+			*out << line << std::endl;
+			return failures;
+		}
+
+		//A missing baseline isn't a failure, there's just nothing to compare against yet
+		ABR_DEBUG(2, "  Comparing throughput against the baseline");
+		std::ifstream baseline(baselinePath);
+		string key;
+		double baselineRate = 0;
+		if (!(baseline >> key >> baselineRate) || key != "graphs_per_second") {
+			snprintf(line, sizeof(line), "SKIP\tthroughput\t%.3f graphs/s, no baseline", bestRate);
+			*out << line << std::endl;
+			return failures;
+		}
+
+		double change = (bestRate - baselineRate) / baselineRate * 100.0;
+		bool slower = change < -maxSlowdown;
+		snprintf(line, sizeof(line), "%s\tthroughput\t%.3f graphs/s\tbaseline=%.3f\tchange=%+.1f%%",
+			slower ? "FAIL" : "PASS", bestRate, baselineRate, change);
+		*out << line << std::endl;
+		if (slower) failures++;
+
+		ABR_DEBUG(2, "  Verification complete, returning...");
+		return failures;
+	}
+
+}
@@ -0,0 +1,749 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <filesystem>
+#include <stdint.h>
+
+#include "../cohort.h"
+#include "../utils.h"
+#include "../dataprocessing.h"
+#include "../filectrl.h"
+
+
+namespace cohort {
+
+	//Store files start with this tag and version, bumped whenever the layout changes
+	static const char STORE_MAGIC[4] = { 'A', 'B', 'R', 'S' };
+	static const uint32_t STORE_VERSION = 1;
+
+	//This struct is the fixed header at the start of a store file. The sections after
+	// it are found from these counts alone, so the header holds no offsets
+	struct storeHeader_t {
+		char magic[4];
+		uint32_t version;
+		uint32_t strings, samples;
+		uint64_t records, hits;
+		uint64_t textSize;
+	};
+
+	//This struct holds where each section of a store file starts, and where it ends
+	struct storeLayout_t {
+		uint64_t dictionary, samples, sample, source, database, hitOffsets;
+		uint64_t identity, hits, text, end;
+	};
+
+	//Lower edges of the identity bins after the first, which holds everything below 80
+	static const double identityEdges[STATS_IDENTITY_BINS - 1] = { 80, 90, 95, 99 };
+	static const char* identityBinNames[STATS_IDENTITY_BINS] = {
+		"identity_lt80", "identity_80_90", "identity_90_95", "identity_95_99", "identity_99_100"
+	};
+
+	//This struct holds the hits pulled out of one summary, with its strings interned
+	// so workers never have to agree on the store's dictionary
+	struct sampleHits_t {
+		vector<util::textId_t> source, database;
+		vector<double> identity;
+		vector<uint32_t> hitCounts;
+		vector<double> hits;
+	};
+
+
+	/*Works out where each section of a store file lies. Every section starts on an 8
+	*  byte boundary so the identity columns can be read in place
+	*
+	* Param header is the header of the store file
+	* Returns the offset of each section from the start of the file
+	*/
+	static storeLayout_t layoutFor(const storeHeader_t& header) {
+		auto pad = [](uint64_t offset) { return (offset + 7) & ~(uint64_t)7; };
+
+		storeLayout_t layout;
+		layout.dictionary = sizeof(storeHeader_t);
+		layout.samples = pad(layout.dictionary + ((uint64_t)header.strings + 1) * sizeof(uint32_t));
+		layout.sample = pad(layout.samples + (uint64_t)header.samples * sizeof(uint32_t));
+		layout.source = pad(layout.sample + header.records * sizeof(uint32_t));
+		layout.database = pad(layout.source + header.records * sizeof(uint32_t));
+		layout.hitOffsets = pad(layout.database + header.records * sizeof(uint32_t));
+		layout.identity = pad(layout.hitOffsets + (header.records + 1) * sizeof(uint32_t));
+		layout.hits = layout.identity + header.records * sizeof(double);
+		layout.text = layout.hits + header.hits * sizeof(double);
+		layout.end = layout.text + header.textSize;
+		return layout;
+	}
+
+
+	/*Splits a table entry into every identity it lists, where multi-hit entries separate
+	*  them with semicolons
+	*
+	* Param entry is the string entry from the parsed table
+	* Param hits has each identity of the entry appended to it
+	* Returns the number of identities appended
+	*/
+	static uint32_t splitHits(const string& entry, vector<double>* hits) {
+		uint32_t count = 0;
+		const char* pos = entry.c_str();
+		while (*pos) {
+			char* end;
+			double value = std::strtod(pos, &end);
+			if (end == pos) break;
+			hits->push_back(value);
+			count++;
+
+			if (*end != ';') break;
+			pos = end + 1;
+		}
+		return count;
+	}
+
+
+	/*Pulls every hit out of a parsed summary
+	*
+	* Precondition: ws holds a table read in by makeLabels and makeTable
+	*
+	* Param ws is the workspace holding the table
+	* Param found is populated with the summary's hits, replacing whatever it held
+	*/
+	static void collectHits(const proc::workspace_t& ws, sampleHits_t* found) {
+		found->source.clear();
+		found->database.clear();
+		found->identity.clear();
+		found->hitCounts.clear();
+		found->hits.clear();
+
+		//Discover the filename index
+		static const util::textId_t fileLabel = util::intern("FILE");
+		size_t fileindex = 0;
+		for (size_t x = 0; x < ws.labelIds.size(); x++)
+			if (ws.labelIds[x] == fileLabel) { fileindex = x; break; }
+
+		//Only the cells holding a hit become records, column by column
+		for (size_t x = 2; x < ws.table.size(); x++) {
+			for (size_t y = 0; y < ws.table[x].size(); y++) {
+				const string& cell = ws.table[x][y];
+				if (cell == "." || cell.empty()) continue;
+
+				found->source.push_back(util::intern(ws.table[fileindex][y]));
+				found->database.push_back(ws.labelIds[x]);
+				found->identity.push_back(ws.rawdata[x - 2][y]);
+				found->hitCounts.push_back(splitHits(cell, &found->hits));
+			}
+		}
+	}
+
+
+	/*Parses a list of summaries on several threads, handing each parsed table to fold.
+	*  Each worker keeps one workspace for every summary it parses, and uses and keeps
+	*  .abrc caches when -c was given. The first error raised by any worker is kept and
+	*  rethrown once they have all stopped
+	*
+	* Precondition: 0 < workerCount <= filenames.size()
+	*
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to parse
+	* Param workerCount is the number of worker threads, the calling thread included
+	* Param caller is the name of the calling function, which errors are prefixed with
+	* Param outputs maps each sample to its raw Abricate outputs, which are read in its
+	*  place, or is nullptr when the files are summaries
+	* Param fold is called as fold(worker, file, ws) with the index of the worker and
+	*  summary, and the workspace holding the summary's table
+	*/
+	template <typename fold_t>
+	static void parseSummaries(
+		const string& directory, const vector<string>& filenames, size_t workerCount,
+		const string& caller, const filectrl::outputGroups_t* outputs, fold_t fold
+		) {
+		std::atomic<size_t> nextFile(0);
+		std::mutex errLock;
+		string firstErr = "";
+
+		auto worker = [&](size_t index) {
+			proc::workspace_t ws;
+			filectrl::reader_t reader;
+			for (size_t f = nextFile++; f < filenames.size(); f = nextFile++) {
+				const string& filename = filenames[f];
+				try {
+					//A sample's raw outputs are summarised on this worker alone
+					if (outputs != nullptr) {
+						proc::makeSummary(directory, outputs->at(filename), &ws, 1);
+						fold(index, f, ws);
+						continue;
+					}
+
+					//A cache that still matches its summary stands in for parsing it
+					string sourcePath = directory + filename, cachePath = sourcePath + ".abrc";
+					if (!util::tableCache || !proc::loadCache(cachePath, sourcePath, &ws)) {
+						filectrl::loadFile(directory, filename, &reader);
+						proc::makeLabels(filename, &reader.in, &ws);
+						proc::makeTable(filename, ws.labels, &reader.in, &ws);
+						filectrl::closeFile(&reader);
+
+						if (util::tableCache && !proc::saveCache(cachePath, sourcePath, ws))
+							ABR_DEBUG(1, "Unable to write cache file " + cachePath);
+					}
+					fold(index, f, ws);
+				}
+				catch (const char* err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = filename + ": " + err;
+				}
+				catch (string err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = filename + ": " + err;
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = filename + ": Unknown error occurred while parsing";
+				}
+			}
+		};
+
+		vector<std::thread> workers;
+		for (size_t x = 1; x < workerCount; x++) workers.push_back(std::thread(worker, x));
+		worker(0);
+		for (std::thread& th : workers) th.join();
+
+		if (firstErr != "") throw caller + firstErr;
+	}
+
+
+	/*Parses a directory of summaries on several threads and gathers every hit into a
+	*  single columnar store. Records come out in the order of the sorted file names, so
+	*  the same directory always gives the same store no matter how the work was split
+	*
+	* Precondition: threads > 0
+	*
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to ingest
+	* Param outputs maps each sample to its raw Abricate outputs, or is nullptr when the
+	*  files are summaries
+	* Param threads is the most worker threads used to parse the summaries
+	* Returns the store holding every sample and hit
+	*/
+	store_t ingest(
+		const string& directory, vector<string> filenames, const filectrl::outputGroups_t* outputs,
+		int threads
+		) {
+		ABR_DEBUG(2, "ingest():");
+		prof::scopedTimer_t timer("ingest");
+
+		if (filenames.empty()) throw (string)"cohort::ingest(): No summaries to ingest";
+		std::sort(filenames.begin(), filenames.end());
+
+		//Each summary's hits are kept apart until every worker has stopped, never more
+		// workers than there are summaries
+		ABR_DEBUG(2, "  Parsing summaries on worker threads");
+		vector<sampleHits_t> found(filenames.size());
+		size_t workerCount = std::min((size_t)threads, filenames.size());
+		parseSummaries(directory, filenames, workerCount, "cohort::ingest(): ", outputs,
+			[&](size_t, size_t f, const proc::workspace_t& ws) { collectHits(ws, &found[f]); }
+		);
+
+		//Gather the summaries in order, giving each string its place in the dictionary
+		// the first time it turns up
+		ABR_DEBUG(2, "  Merging hits into the store");
+		store_t store;
+		std::unordered_map<util::textId_t, uint32_t> entries;
+		auto encode = [&](util::textId_t id) {
+			auto inserted = entries.emplace(id, (uint32_t)store.dictionary.size());
+			if (inserted.second) store.dictionary.push_back(util::internedText(id));
+			return inserted.first->second;
+		};
+
+		size_t records = 0, hits = 0;
+		for (const sampleHits_t& sample : found) {
+			records += sample.identity.size();
+			hits += sample.hits.size();
+		}
+		if (hits > UINT32_MAX) throw (string)"cohort::ingest(): Too many hits for one store";
+		store.sample.reserve(records);
+		store.source.reserve(records);
+		store.database.reserve(records);
+		store.identity.reserve(records);
+		store.hitOffsets.reserve(records + 1);
+		store.hits.reserve(hits);
+
+		store.hitOffsets.push_back(0);
+		for (size_t f = 0; f < found.size(); f++) {
+			const sampleHits_t& sample = found[f];
+			uint32_t sampleId = encode(util::intern(filenames[f]));
+			store.samples.push_back(sampleId);
+
+			for (size_t r = 0; r < sample.identity.size(); r++) {
+				store.sample.push_back(sampleId);
+				store.source.push_back(encode(sample.source[r]));
+				store.database.push_back(encode(sample.database[r]));
+				store.identity.push_back(sample.identity[r]);
+				store.hitOffsets.push_back(store.hitOffsets.back() + sample.hitCounts[r]);
+			}
+			store.hits.insert(store.hits.end(), sample.hits.begin(), sample.hits.end());
+		}
+
+		ABR_DEBUG(2, "  Ingested " + std::to_string(records) + " records from " +
+			std::to_string(filenames.size()) + " summaries, returning...");
+		return store;
+	}
+
+
+	/*Finds the Abricate database an output file was made with, from a name like
+	*  SAMPLE_database_out.tab
+	*
+	* Param source is the output file name from a FILE entry, without its path
+	* Returns the name of the database
+	*/
+	static string databaseOf(const string& source) {
+		string sample, database;
+		filectrl::splitOutputName(source, &sample, &database);
+		return database;
+	}
+
+
+	/*Adds one parsed summary to a set of running totals
+	*
+	* Precondition: ws holds a table read in by makeLabels and makeTable
+	*
+	* Param ws is the workspace holding the table
+	* Param report is the set of totals the summary is added to
+	* Param databases maps each output file name already seen onto its database, so each
+	*  name is only split apart once
+	* Param rowDatabase is scratch space for the database of each row
+	*/
+	static void foldStats(
+		const proc::workspace_t& ws, statsReport_t* report,
+		std::unordered_map<util::textId_t, util::textId_t>* databases,
+		vector<databaseStats_t*>* rowDatabase
+		) {
+		//Discover the filename index
+		static const util::textId_t fileLabel = util::intern("FILE");
+		size_t fileindex = 0;
+		for (size_t x = 0; x < ws.labelIds.size(); x++)
+			if (ws.labelIds[x] == fileLabel) { fileindex = x; break; }
+
+		//Find the totals each row goes into, counting the sample once per database
+		report->samples++;
+		const vector<string>& files = ws.table[fileindex];
+		rowDatabase->resize(files.size());
+		vector<databaseStats_t*> seen;
+		for (size_t y = 0; y < files.size(); y++) {
+			util::textId_t source = util::intern(files[y]);
+			auto found = databases->find(source);
+			if (found == databases->end())
+				found = databases->emplace(source, util::intern(databaseOf(files[y]))).first;
+
+			databaseStats_t* stats = &report->databases[found->second];
+			(*rowDatabase)[y] = stats;
+			if (std::find(seen.begin(), seen.end(), stats) == seen.end()) {
+				seen.push_back(stats);
+				stats->samples++;
+			}
+			stats->rows++;
+		}
+
+		//Walk the table a column at a time, marking the rows that had any hit
+		vector<bool> rowHit(files.size(), false);
+		for (size_t x = 2; x < ws.table.size(); x++) {
+			for (size_t y = 0; y < ws.table[x].size() && y < files.size(); y++) {
+				const string& cell = ws.table[x][y];
+				if (cell == "." || cell.empty()) continue;
+
+				databaseStats_t* stats = (*rowDatabase)[y];
+				rowHit[y] = true;
+				stats->hits++;
+				stats->geneHits[ws.labelIds[x]]++;
+
+				//Every identity of a multi-hit cell counts towards the spread
+				const char* pos = cell.c_str();
+				while (*pos) {
+					char* end;
+					double value = std::strtod(pos, &end);
+					if (end == pos) break;
+
+					if (stats->identities == 0 || value < stats->identityMin) stats->identityMin = value;
+					if (stats->identities == 0 || value > stats->identityMax) stats->identityMax = value;
+					stats->identities++;
+					stats->identitySum += value;
+					int bin = 0;
+					while (bin < STATS_IDENTITY_BINS - 1 && value >= identityEdges[bin]) bin++;
+					stats->identityBins[bin]++;
+
+					if (*end != ';') break;
+					pos = end + 1;
+				}
+			}
+		}
+		for (size_t y = 0; y < files.size(); y++)
+			if (rowHit[y]) (*rowDatabase)[y]->hitRows++;
+	}
+
+
+	/*Parses a directory of summaries on several threads and totals up, for each Abricate
+	*  database, how many rows had hits, how their identities were spread and which genes
+	*  were hit most. The database of a row is read from its FILE entry, where Abricate
+	*  names each output like SAMPLE_database_out.tab. Each worker folds the summaries it
+	*  parses into its own totals, which are merged once every summary has been read
+	*
+	* Precondition: threads > 0
+	*
+	* Param directory is the directory that the summaries are found in
+	* Param filenames is the list of summaries to report on
+	* Param outputs maps each sample to its raw Abricate outputs, or is nullptr when the
+	*  files are summaries
+	* Param threads is the most worker threads used to parse the summaries
+	* Returns the totals for every database
+	*/
+	statsReport_t reduceStats(
+		const string& directory, const vector<string>& filenames,
+		const filectrl::outputGroups_t* outputs, int threads
+		) {
+		ABR_DEBUG(2, "reduceStats():");
+		prof::scopedTimer_t timer("reduceStats");
+
+		if (filenames.empty()) throw (string)"cohort::reduceStats(): No summaries to report on";
+
+		//Each worker only ever touches its own totals, so nothing is locked while parsing
+		ABR_DEBUG(2, "  Folding summaries into per-worker totals");
+		size_t workerCount = std::min((size_t)threads, filenames.size());
+		vector<statsReport_t> partials(workerCount);
+		vector<std::unordered_map<util::textId_t, util::textId_t>> databases(workerCount);
+		vector<vector<databaseStats_t*>> rowDatabase(workerCount);
+		parseSummaries(directory, filenames, workerCount, "cohort::reduceStats(): ", outputs,
+			[&](size_t worker, size_t, const proc::workspace_t& ws) {
+				foldStats(ws, &partials[worker], &databases[worker], &rowDatabase[worker]);
+			}
+		);
+
+		//Add the workers' totals together
+		ABR_DEBUG(2, "  Merging worker totals");
+		statsReport_t report = std::move(partials[0]);
+		for (size_t w = 1; w < partials.size(); w++) {
+			report.samples += partials[w].samples;
+			for (auto& entry : partials[w].databases) {
+				const databaseStats_t& part = entry.second;
+				databaseStats_t& total = report.databases[entry.first];
+				if (part.identities > 0) {
+					if (total.identities == 0 || part.identityMin < total.identityMin)
+						total.identityMin = part.identityMin;
+					if (total.identities == 0 || part.identityMax > total.identityMax)
+						total.identityMax = part.identityMax;
+				}
+				total.samples += part.samples;
+				total.rows += part.rows;
+				total.hitRows += part.hitRows;
+				total.hits += part.hits;
+				total.identities += part.identities;
+				total.identitySum += part.identitySum;
+				for (int b = 0; b < STATS_IDENTITY_BINS; b++) total.identityBins[b] += part.identityBins[b];
+				for (auto& gene : part.geneHits) total.geneHits[gene.first] += gene.second;
+			}
+		}
+
+		ABR_DEBUG(2, "  Totalled " + std::to_string(report.databases.size()) + " databases from " +
+			std::to_string(report.samples) + " summaries, returning...");
+		return report;
+	}
+
+
+	/*Writes a stats report as one line per database, sorted by name. Paths ending in
+	*  .csv are written comma-separated, and anything else tab-separated
+	*
+	* Param report is the report being written
+	* Param path is the path of the report file, which is replaced if it exists
+	*/
+	void writeStatsReport(const statsReport_t& report, const string& path) {
+		ABR_DEBUG(2, "writeStatsReport():");
+
+		bool csv = path.length() >= 4 && path.compare(path.length() - 4, 4, ".csv") == 0;
+		char sep = csv ? ',' : '\t';
+
+		//Fields holding the separator or a quote are quoted for CSV, and have the
+		// separator swapped for a space in TSV, which has no quoting
+		auto field = [&](const string& text) {
+			if (text.find_first_of(csv ? ",\"\n" : "\t\n") == string::npos) return text;
+			if (!csv) {
+				string flat = text;
+				for (char& c : flat) if (c == '\t' || c == '\n') c = ' ';
+				return flat;
+			}
+			string quoted = "\"";
+			for (char c : text) {
+				if (c == '"') quoted += '"';
+				quoted += c;
+			}
+			return quoted + "\"";
+		};
+
+		ABR_DEBUG(2, "  Sorting databases by name");
+		vector<std::pair<string, const databaseStats_t*>> sorted;
+		for (const auto& entry : report.databases)
+			sorted.push_back({ util::internedText(entry.first), &entry.second });
+		std::sort(sorted.begin(), sorted.end(),
+			[](const auto& a, const auto& b) { return a.first < b.first; }
+		);
+
+		ABR_DEBUG(2, "  Writing report to " + path);
+		std::ofstream out(path, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!out.is_open()) throw "cohort::writeStatsReport(): Error opening report file " + path;
+
+		out << "database" << sep << "samples" << sep << "rows" << sep << "hit_rows" << sep
+			<< "hit_rate" << sep << "hits" << sep << "identities" << sep << "identity_mean" << sep
+			<< "identity_min" << sep << "identity_max";
+		for (int b = 0; b < STATS_IDENTITY_BINS; b++) out << sep << identityBinNames[b];
+		out << sep << "top_genes" << "\n";
+
+		out << std::fixed;
+		for (const auto& entry : sorted) {
+			const databaseStats_t& stats = *entry.second;
+
+			//The most-hit genes come first, with ties broken by name so runs always match
+			vector<std::pair<string, size_t>> genes;
+			for (const auto& gene : stats.geneHits)
+				genes.push_back({ util::internedText(gene.first), gene.second });
+			size_t top = std::min(genes.size(), (size_t)STATS_TOP_GENES);
+			std::partial_sort(genes.begin(), genes.begin() + top, genes.end(),
+				[](const auto& a, const auto& b) {
+					return a.second != b.second ? a.second > b.second : a.first < b.first;
+				}
+			);
+			string topGenes = "";
+			for (size_t g = 0; g < top; g++)
+				topGenes += (g > 0 ? ";" : "") + genes[g].first + ":" + std::to_string(genes[g].second);
+
+			out << field(entry.first) << sep << stats.samples << sep << stats.rows << sep
+				<< stats.hitRows << sep << std::setprecision(4)
+				<< (stats.rows > 0 ? (double)stats.hitRows / stats.rows : 0.0) << sep
+				<< stats.hits << sep << stats.identities << sep << std::setprecision(2)
+				<< (stats.identities > 0 ? stats.identitySum / stats.identities : 0.0) << sep
+				<< stats.identityMin << sep << stats.identityMax;
+			for (int b = 0; b < STATS_IDENTITY_BINS; b++) out << sep << stats.identityBins[b];
+			out << sep << field(topGenes) << "\n";
+		}
+		out.close();
+		if (out.fail()) throw "cohort::writeStatsReport(): Error writing report file " + path;
+
+		ABR_DEBUG(2, "  Report written, returning...");
+		return;
+	}
+
+
+	/*Writes a store to a binary file: a header giving the counts, then the dictionary's
+	*  offsets, the sample list, each record column and the hits, then the dictionary's
+	*  text. The file is written beside its destination and moved into place once whole
+	*
+	* Param store is the store being written
+	* Param path is the path of the store file, which is replaced if it exists
+	*/
+	void writeStore(const store_t& store, const string& path) {
+		ABR_DEBUG(2, "writeStore():");
+		prof::scopedTimer_t timer("writeStore");
+
+		storeHeader_t header = {};
+		memcpy(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC));
+		header.version = STORE_VERSION;
+		header.strings = (uint32_t)store.dictionary.size();
+		header.samples = (uint32_t)store.samples.size();
+		header.records = store.identity.size();
+		header.hits = store.hits.size();
+
+		//Dictionary offsets are 32 bits, so the text of every string has to fit in that
+		ABR_DEBUG(2, "  Laying out dictionary");
+		vector<uint32_t> offsets;
+		offsets.reserve(store.dictionary.size() + 1);
+		uint64_t textSize = 0;
+		for (const string& text : store.dictionary) {
+			offsets.push_back((uint32_t)textSize);
+			textSize += text.length();
+		}
+		if (textSize > UINT32_MAX) throw (string)"cohort::writeStore(): Dictionary too large for one store";
+		offsets.push_back((uint32_t)textSize);
+		header.textSize = textSize;
+		storeLayout_t layout = layoutFor(header);
+
+		//Write to a temporary file and move it into place once it's complete, so a run
+		// that stops partway never leaves a store that looks whole
+		ABR_DEBUG(2, "  Writing store file");
+		string tempPath = path + ".tmp";
+		std::ofstream out(tempPath, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!out.is_open()) throw "cohort::writeStore(): Error opening store file " + tempPath;
+
+		uint64_t written = 0;
+		auto section = [&](uint64_t start, const void* data, uint64_t size) {
+			static const char padding[8] = {};
+			out.write(padding, start - written);
+			out.write((const char*)data, size);
+			written = start + size;
+		};
+		section(0, &header, sizeof(header));
+		section(layout.dictionary, offsets.data(), offsets.size() * sizeof(uint32_t));
+		section(layout.samples, store.samples.data(), store.samples.size() * sizeof(uint32_t));
+		section(layout.sample, store.sample.data(), store.sample.size() * sizeof(uint32_t));
+		section(layout.source, store.source.data(), store.source.size() * sizeof(uint32_t));
+		section(layout.database, store.database.data(), store.database.size() * sizeof(uint32_t));
+		section(layout.hitOffsets, store.hitOffsets.data(), store.hitOffsets.size() * sizeof(uint32_t));
+		section(layout.identity, store.identity.data(), store.identity.size() * sizeof(double));
+		section(layout.hits, store.hits.data(), store.hits.size() * sizeof(double));
+		for (const string& text : store.dictionary) out.write(text.data(), text.length());
+		out.close();
+
+		std::error_code err;
+		if (out.fail()) {
+			std::filesystem::remove(tempPath, err);
+			throw "cohort::writeStore(): Error writing store file " + tempPath;
+		}
+		std::filesystem::rename(tempPath, path, err);
+		if (err) {
+			std::filesystem::remove(tempPath, err);
+			throw "cohort::writeStore(): Error moving store file into place at " + path;
+		}
+
+		ABR_DEBUG(2, "  Store written, returning...");
+		return;
+	}
+
+
+	/*Reads a store back from the file writeStore made, mapping it into memory and
+	*  checking that every index and span lies inside it
+	*
+	* Param path is the path of the store file
+	* Returns the store held in the file
+	*/
+	store_t readStore(const string& path) {
+		ABR_DEBUG(2, "readStore():");
+		prof::scopedTimer_t timer("readStore");
+
+		filectrl::mappedFile_t map;
+		if (!filectrl::mapFile(path, &map))
+			throw "cohort::readStore(): Error opening store file " + path;
+
+		//Check the header and that the sections it describes fill the file exactly. The
+		// counts are checked against the file size first so the layout can't overflow
+		ABR_DEBUG(2, "  Checking store header");
+		storeHeader_t header;
+		bool valid = map.size >= sizeof(header);
+		if (valid) memcpy(&header, map.data, sizeof(header));
+		valid = valid && memcmp(header.magic, STORE_MAGIC, sizeof(STORE_MAGIC)) == 0 &&
+			header.version == STORE_VERSION && header.records <= map.size &&
+			header.hits <= map.size && header.textSize <= map.size;
+		storeLayout_t layout;
+		if (valid) layout = layoutFor(header);
+		valid = valid && layout.end == map.size;
+		if (!valid) {
+			filectrl::unmapFile(&map);
+			throw "cohort::readStore(): " + path + " is not a store file or is damaged";
+		}
+
+		//Copy each section out of the mapping
+		ABR_DEBUG(2, "  Copying store columns");
+		auto copySection = [&](auto* column, uint64_t start, uint64_t count) {
+			column->resize(count);
+			if (count > 0) memcpy(column->data(), map.data + start, count * sizeof((*column)[0]));
+		};
+		store_t store;
+		vector<uint32_t> offsets;
+		copySection(&offsets, layout.dictionary, (uint64_t)header.strings + 1);
+		copySection(&store.samples, layout.samples, header.samples);
+		copySection(&store.sample, layout.sample, header.records);
+		copySection(&store.source, layout.source, header.records);
+		copySection(&store.database, layout.database, header.records);
+		copySection(&store.hitOffsets, layout.hitOffsets, header.records + 1);
+		copySection(&store.identity, layout.identity, header.records);
+		copySection(&store.hits, layout.hits, header.hits);
+
+		const char* text = (const char*)map.data + layout.text;
+		valid = offsets[0] == 0 && offsets[header.strings] == header.textSize;
+		store.dictionary.resize(header.strings);
+		for (uint32_t x = 0; valid && x < header.strings; x++) {
+			if (offsets[x] > offsets[x + 1]) valid = false;
+			else store.dictionary[x].assign(text + offsets[x], offsets[x + 1] - offsets[x]);
+		}
+		filectrl::unmapFile(&map);
+
+		//Check that every index points into the dictionary and every record's hits lie
+		// inside the hit list, so nothing that reads the store can run off the end
+		ABR_DEBUG(2, "  Checking store indices");
+		for (uint32_t id : store.samples) if (id >= header.strings) valid = false;
+		for (uint64_t r = 0; valid && r < header.records; r++) {
+			if (store.sample[r] >= header.strings || store.source[r] >= header.strings ||
+				store.database[r] >= header.strings ||
+				store.hitOffsets[r] > store.hitOffsets[r + 1]) valid = false;
+		}
+		valid = valid && store.hitOffsets[0] == 0 && store.hitOffsets[header.records] == header.hits;
+		if (!valid) throw "cohort::readStore(): " + path + " is not a store file or is damaged";
+
+		ABR_DEBUG(2, "  Read " + std::to_string(header.records) + " records from " +
+			std::to_string(header.samples) + " samples, returning...");
+		return store;
+	}
+
+
+	/*Adds one row per sample of a store to a heatmap, holding the best hit the sample
+	*  had in each database. This gives the same heatmap as collapsing each summary with
+	*  proc::addHeatmapRows, without reading any of them
+	*
+	* Precondition: heatmap != nullptr
+	*
+	* Param heatmap is the heatmap being added to
+	* Param store is the store the rows are taken from
+	*/
+	void addStoreRows(proc::heatmap_t* heatmap, const store_t& store) {
+		ABR_DEBUG(2, "addStoreRows():");
+
+		//Every sample gets a row, even one without a single hit
+		ABR_DEBUG(2, "  Adding a row for each sample");
+		std::unordered_map<uint32_t, int> rowIndex;
+		for (uint32_t id : store.samples) {
+			rowIndex[id] = heatmap->rowLabels.size();
+			heatmap->rowLabels.push_back(store.dictionary[id]);
+		}
+
+		//Map each database onto a heatmap column, adding new ones, in the order they
+		// first turn up
+		ABR_DEBUG(2, "  Matching databases to heatmap columns");
+		vector<int> colMap(store.dictionary.size(), -1);
+		for (uint32_t id : store.database) {
+			if (colMap[id] >= 0) continue;
+			util::textId_t label = util::intern(store.dictionary[id]);
+			auto found = heatmap->colIndex.find(label);
+			if (found == heatmap->colIndex.end()) {
+				colMap[id] = heatmap->colLabels.size();
+				heatmap->colIndex[label] = colMap[id];
+				heatmap->colLabels.push_back(store.dictionary[id]);
+			}
+			else colMap[id] = found->second;
+		}
+
+		//A sample's records sit together, so the best hit in each column is kept until
+		// the next sample starts
+		ABR_DEBUG(2, "  Keeping the best hit of each sample and database");
+		vector<double> best(heatmap->colLabels.size(), 0.0);
+		vector<int> touched;
+		for (size_t r = 0; r < store.identity.size(); r++) {
+			int col = colMap[store.database[r]];
+			if (store.identity[r] > 0.0) {
+				if (best[col] <= 0.0) touched.push_back(col);
+				if (store.identity[r] > best[col]) best[col] = store.identity[r];
+			}
+
+			if (r + 1 == store.identity.size() || store.sample[r + 1] != store.sample[r]) {
+				std::sort(touched.begin(), touched.end());
+				int row = rowIndex[store.sample[r]];
+				for (int c : touched) {
+					heatmap->cells.push_back({ row, c, (float)best[c] });
+					best[c] = 0.0;
+				}
+				touched.clear();
+			}
+		}
+
+		ABR_DEBUG(2, "  Rows added, returning...");
+		return;
+	}
+
+}
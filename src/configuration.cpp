@@ -0,0 +1,48 @@
+#include <string>
+
+#include "../configuration.h"
+
+
+namespace util {
+	std::string ABR_INPUT_DIR = "./";
+	std::string ABR_TYPEFACE_DIR = "./";
+	std::string ABR_TYPEFACE_NAME = "Consolas";
+	std::string ABR_OUTPUT_DIR = "./";
+	std::string ABR_OUTPUT_EXT = "PNG";
+	int ABR_RUN_DEBUG = 0;
+
+	bool batch = false;
+	bool raw = false;
+	bool flagsUsed = false;
+	bool stream = false;
+	bool mosaic = false;
+	int mosaicColumns = 0;
+	int mosaicTileW = 0;
+	int mosaicTileH = 0;
+	bool heatmap = false;
+	std::string archivePath = "";
+	bool tableCache = false;
+	bool abricateOutputs = false;
+	std::string ingestPath = "";
+	std::vector<outputTarget_t> outputTargets;
+	std::string reportPath = "";
+	std::string statsPath = "";
+	bool memStats = false;
+	std::string tracePath = "";
+	int benchIterations = 0;
+	std::string verifyDir = "";
+	int verifyTolerance = 0;
+	double verifyMaxSlowdown = 10;
+	bool verifyBless = false;
+	std::string generatePath = "";
+	long generateRows = 1000;
+	int generateColumns = 16;
+	double generateDensity = 0.3;
+	double generateMultiHit = 0.2;
+	unsigned int generateSeed = 1;
+
+	int IMG_W = BASE_IMG_W;
+	int IMG_H = BASE_IMG_H;
+	double scale = 1.0;
+	thread_local double threadScale = 0;
+}
@@ -4,25 +4,166 @@
 #include <cstring>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <filesystem>
+#include <stdint.h>
+#include <climits>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "../utils.h"
 #include "../dataprocessing.h"
+#include "../filectrl.h"
 
 namespace proc {
+	/*Gives the entry at index of a pooled list, growing the list by one with storage
+	*  from the spare list when index is just past its end
+	*
+	* Precondition: index <= items->size()
+	*
+	* Param items is the list being filled
+	* Param index is the index of the entry being filled
+	* Param spare is the list of entries parked by earlier, larger files
+	* Returns a pointer to the entry, which still holds whatever it held before
+	*/
+	template <typename T>
+	static T* pooledSlot(vector<T>* items, size_t index, vector<T>* spare) {
+		if (index == items->size()) {
+			if (spare->empty()) items->emplace_back();
+			else {
+				items->push_back(std::move(spare->back()));
+				spare->pop_back();
+			}
+		}
+		return &(*items)[index];
+	}
+
+
+	/*Resizes a pooled list, parking any entries it no longer needs in the spare list
+	*  and taking entries back from the spare list when it grows
+	*
+	* Param items is the list being resized
+	* Param n is the new size of the list
+	* Param spare is the list of parked entries
+	*/
+	template <typename T>
+	static void resizePooled(vector<T>* items, size_t n, vector<T>* spare) {
+		while (items->size() > n) {
+			spare->push_back(std::move(items->back()));
+			items->pop_back();
+		}
+		while (items->size() < n) pooledSlot(items, items->size(), spare);
+	}
+
+
+	/*Interns a table's labels so its columns can be looked for by ID
+	*
+	* Param labels is the list of column labels from the parsed table
+	* Param ids is populated with the ID of each label, in the same order
+	*/
+	static void internLabels(const vector<string>& labels, vector<util::textId_t>* ids) {
+		ids->resize(labels.size());
+		for (size_t x = 0; x < labels.size(); x++) (*ids)[x] = util::intern(labels[x]);
+	}
+
+
+	/*Gives the interned ID of the FILE label that marks a table's filename column*/
+	static util::textId_t fileLabel() {
+		static const util::textId_t id = util::intern("FILE");
+		return id;
+	}
+
+
+	/*Empties a workspace's numeric matrix, column statistics and data range, ready for
+	*  a new table to be scanned into it
+	*
+	* Param columns is the number of data columns in the new table
+	* Param ws is the workspace being reset
+	*/
+	static void resetScan(size_t columns, workspace_t* ws) {
+		resizePooled(&ws->rawdata, columns, &ws->spareRaw);
+		for (vector<double>& column : ws->rawdata) column.clear();
+		ws->columnHits.assign(columns, 0);
+		ws->hasHits = false;
+		ws->dataMin = 0; ws->dataMax = 0;
+	}
+
+
+	/*Converts one data entry of a table and folds it into a workspace's numeric matrix,
+	*  column statistics and data range
+	*
+	* Precondition: resetScan was called for the table AND column >= 2
+	*
+	* Param entry is the string entry from the table
+	* Param column is the index of the entry's column in the table
+	* Param ws is the workspace collecting the table's values
+	*/
+	static void scanEntry(const string& entry, size_t column, workspace_t* ws) {
+		//Null entries become zero and are left out of the range
+		double value = parseIdentity(entry);
+		ws->rawdata[column - 2].push_back(value);
+		if (entry == ".") return;
+
+		//Only the first of several hits is kept (fix this later)
+		if (value != 0) ws->columnHits[column - 2]++;
+		if (!ws->hasHits) {
+			ws->dataMin = value; ws->dataMax = value;
+			ws->hasHits = true;
+		}
+		if (value > ws->dataMax) ws->dataMax = value;
+		if (value < ws->dataMin) ws->dataMin = value;
+	}
+
+
+	/*Scans an already parsed table into a workspace's numeric matrix, column statistics
+	*  and data range, for tables that weren't read in by makeTable with the workspace
+	*
+	* Param table is the 2D list of string data from the parsed table
+	* Param ws is the workspace collecting the table's values
+	*/
+	static void scanTable(const vector<vector<string>>& table, workspace_t* ws) {
+		resetScan(table.size() > 2 ? table.size() - 2 : 0, ws);
+		for (size_t x = 2; x < table.size(); x++)
+			for (const string& entry : table[x]) scanEntry(entry, x, ws);
+	}
+
+
 	/*Uses a file stream to access the file's headers, creating a list of labels for use in graphing
 	*
 	* Precondition: src is not nullptr, file referenced by src is not empty
 	* Postcondition: The iterator of src is advanced to the file's data
 	*
-	* Param src is a pointer to an opened ifstream
+	* Param src is a pointer to an opened input stream (a file or STDIN)
 	* Returns a string vector containing the data's column labels
 	*/
-	vector<string> makeLabels(string filename, ifstream* src) {
-		util::debug(1, "makeLabels():");
+	vector<string> makeLabels(const string& filename, std::istream* src) {
+		workspace_t ws;
+		makeLabels(filename, src, &ws);
+		return std::move(ws.labels);
+	}
+
+
+	/*Reads a file's header into a workspace's labels, reusing the storage left over
+	*  from the files before it
+	*
+	* Precondition: src is not nullptr AND ws is not nullptr
+	* Postcondition: ws->labels holds the file's labels AND the iterator of src is
+	*		advanced to the file's data
+	*
+	* Param filename is the name of the file, used in error messages
+	* Param src is a pointer to an opened input stream (a file or STDIN)
+	* Param ws is the workspace receiving the labels
+	*/
+	void makeLabels(const string& filename, std::istream* src, workspace_t* ws) {
+		ABR_DEBUG(2, "makeLabels():");
+		prof::scopedTimer_t timer("makeLabels");
 
 		//Read in the entire header from the file being processed
-		util::debug(1, "  Ensuring that the file has a header to read");
-		char header[4096];
+		ABR_DEBUG(2, "  Ensuring that the file has a header to read");
+		char header[HEADER_BUFFER_SIZE];
 		if (!(*src).getline(header, sizeof(header)))
 			throw "proc::makeLabels(): " + filename + " appears to be empty";
 
@@ -30,23 +171,26 @@ namespace proc {
 		if (header[0] != '#')
 			throw "proc::makeLabels(): " + filename + " does not contain a header to process";
 
-		//Parse through the header line and create a vector to store the header labels
-		util::debug(1, "  Parsing through the header to store labels");
-		vector<string> labels; string currHeader = "";
-		for (size_t x = 1; x < strlen(header); x++) {
-			//If a delimiter is found, separate it and push it into the label vector
-			if (header[x] == '\t' || x == strlen(header) - 1) {
-				labels.push_back(currHeader);
-				util::debug(1, "    Label found to be " + currHeader);
-				currHeader = "";
+		//Parse through the header line and store the header labels
+		ABR_DEBUG(2, "  Parsing through the header to store labels");
+		size_t count = 0, length = strlen(header);
+		string& currHeader = ws->cell;
+		currHeader.clear();
+		for (size_t x = 1; x < length; x++) {
+			//If a delimiter is found, separate it and store it as the next label
+			if (header[x] == '\t' || x == length - 1) {
+				pooledSlot(&ws->labels, count++, &ws->spareCells)->assign(currHeader);
+				ABR_DEBUG(3, "    Label found to be " + currHeader);
+				currHeader.clear();
 				continue;
 			}
 			//Otherwise, add the character to the compiled header
 			currHeader += header[x];
 		}
+		resizePooled(&ws->labels, count, &ws->spareCells);
 
-		util::debug(1, "  Header parsed, returning...");
-		return labels;
+		ABR_DEBUG(2, "  Header parsed, returning...");
+		return;
 	}
 
 
@@ -56,49 +200,562 @@ namespace proc {
 	* Postcondition: src has been entirely processed, labels = #labels
 	*
 	* Param labels is the list of labels for each of the columns on the table
-	* Param src is a pointer to an opened ifstream
+	* Param src is a pointer to an opened input stream (a file or STDIN)
 	* Returns a 2d vector, with the first index referencing the column (matching the index of
 	*   its respective label) and the second matching the row in the source file
 	*/
-	vector<vector<string>> makeTable(string filename, vector<string> labels, ifstream* src) {
-		util::debug(1, "makeTable():");
+	vector<vector<string>> makeTable(
+		const string& filename, const vector<string>& labels, std::istream* src
+		) {
+		workspace_t ws;
+		makeTable(filename, labels, src, &ws);
+		return std::move(ws.table);
+	}
 
-		//Create an empty vector for each label for population later
-		util::debug(1, "  Creating a list of data tables to populate");
-		vector<vector<string>> table;
-		for (size_t x = 0; x < labels.size(); x++) table.push_back(vector<string>());
 
-		//Iterate through the file to populate the table
-		util::debug(1, "  Populating data table from input file");
-		string currEntry;
-		int i = 0;
-		while ((*src) >> currEntry) {
-			table[i].push_back(currEntry);
-			i++;
-			i %= labels.size();
+	/*Populates a workspace's table from a file stream in a single pass, reusing the
+	*  storage left over from the files before it. Filenames lose their paths and data
+	*  entries are converted and ranged as they are read
+	*
+	* Precondition: labels.size() equals the columns in the data file AND src is not
+	*		nullptr AND ws is not nullptr
+	* Postcondition: ws->table holds the file's data, ws->rawdata its values and ws its
+	*		data range AND src has been entirely processed
+	*
+	* Param filename is the name of the file, used in error messages
+	* Param labels is the list of labels for each of the columns on the table
+	* Param src is a pointer to an opened input stream (a file or STDIN)
+	* Param ws is the workspace receiving the table
+	*/
+	void makeTable(
+		const string& filename, const vector<string>& labels, std::istream* src,
+		workspace_t* ws
+		) {
+		ABR_DEBUG(2, "makeTable():");
+		prof::scopedTimer_t timer("makeTable");
+
+		//Make a column for each label, keeping the columns from the last file
+		ABR_DEBUG(2, "  Creating a list of data tables to populate");
+		vector<vector<string>>& table = ws->table;
+		resizePooled(&table, labels.size(), &ws->spareColumns);
+		resetScan(labels.size() > 2 ? labels.size() - 2 : 0, ws);
+
+		//The file paths are trimmed as they're read, so find their column first
+		ABR_DEBUG(2, "  Discovering the file index");
+		internLabels(labels, &ws->labelIds);
+		size_t fileIndex = 0;
+		for (size_t x = 0; x < labels.size(); x++) {
+			if (ws->labelIds[x] == fileLabel()) { fileIndex = x; break; }
 		}
 
-		//Clean up the absolute file paths from the source file
-		util::debug(1, "  Discovering the file index");
-		int fileIndex = 0;
-		for (size_t x = 0; x < labels.size(); x++) {
-			if (labels[x] == "FILE") { fileIndex = x; break; }
+		//Iterate through the file to populate the table, copying each entry over the
+		// one left in its place by the last file so the cell keeps its capacity. Data
+		// entries are converted and folded into the range on the way, so the table is
+		// only ever read once
+		ABR_DEBUG(2, "  Populating data table from input file");
+		const string& entry = ws->cell;
+		size_t count = 0;
+		try {
+			while ((*src) >> ws->cell) {
+				size_t column = count % labels.size(), row = count / labels.size();
+				string* slot = pooledSlot(&table[column], row, &ws->spareCells);
+
+				//Drop the absolute path from a filename, keeping the name itself
+				if (column == fileIndex) {
+					size_t slash = string::npos;
+					if (entry.length() > 1) slash = entry.find_last_of('/', entry.length() - 2);
+					slot->assign(entry, slash == string::npos ? 0 : slash + 1, string::npos);
+				}
+				else slot->assign(entry);
+
+				if (column >= 2) scanEntry(entry, column, ws);
+				count++;
+			}
 		}
+		//A stream that fails partway, like a damaged compressed file, names the file it was
+		catch (const char* err) {
+			throw "proc::makeTable(): " + filename + " could not be read: " + (string)err;
+		}
+		catch (string err) {
+			throw "proc::makeTable(): " + filename + " could not be read: " + err;
+		}
+		if (src->bad()) throw "proc::makeTable(): " + filename + " could not be read";
+
+		//Drop whatever the last file left past the end of each column
+		for (size_t x = 0; x < table.size(); x++) {
+			size_t rows = count / labels.size() + (x < count % labels.size() ? 1 : 0);
+			resizePooled(&table[x], rows, &ws->spareCells);
+		}
+
+		ABR_DEBUG(2, "  Table populated, returning...");
+		return;
+	}
 
-		//Iterate through the file column and erase the absolute file paths
-		util::debug(1, "  Triming paths from the filenames");
-		for (int x = 0; x < table[fileIndex].size(); x++) {
-			//Find the index of the string where the file path ends
-			string currString = table[fileIndex][x];
-			int i = currString.length() - 1;
-			while (currString[i - 1] != '/' && i > 0) i--;
 
-			//Store the filename substring
-			table[fileIndex][x] = currString.substr(i, currString.length());
+	/*Reads the gene and identity of every hit in a raw ABRicate output. The columns are
+	*  found by name, so outputs from older ABRicate versions with fewer columns work too
+	*
+	* Precondition: reader is not nullptr AND hits is not nullptr
+	* Postcondition: hits holds the output's hits and their order sorted by gene
+	*
+	* Param directory is the directory that the output is found in
+	* Param filename is the name of the output
+	* Param reader is the reader the output is opened with
+	* Param hits is populated with the output's hits, replacing whatever it held
+	*/
+	static void readOutput(
+		const string& directory, const string& filename, filectrl::reader_t* reader,
+		outputHits_t* hits
+		) {
+		filectrl::loadFile(directory, filename, reader);
+		std::istream& src = reader->in;
+		string& line = hits->line;
+
+		//Find the gene and identity columns in the header
+		if (!std::getline(src, line) || line.empty() || line[0] != '#')
+			throw "proc::makeSummary(): " + filename + " does not contain a header to process";
+		if (line.back() == '\r') line.pop_back();
+		size_t geneField = string::npos, identityField = string::npos, fields = 0;
+		for (size_t start = 1, end = 0; end != string::npos; start = end + 1, fields++) {
+			end = line.find('\t', start);
+			size_t length = (end == string::npos ? line.length() : end) - start;
+			if (line.compare(start, length, "GENE") == 0) geneField = fields;
+			if (line.compare(start, length, "%IDENTITY") == 0) identityField = fields;
 		}
+		if (geneField == string::npos || identityField == string::npos)
+			throw "proc::makeSummary(): " + filename + " is not an ABRicate output (no GENE or %IDENTITY column)";
+
+		//Copy the two fields out of each hit, over the entries left by the last output.
+		// Outputs that were joined together repeat their header, which is skipped
+		size_t count = 0;
+		while (std::getline(src, line)) {
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.empty() || line[0] == '#') continue;
+
+			if (count == hits->genes.size()) {
+				hits->genes.emplace_back();
+				hits->identities.emplace_back();
+			}
+			bool found = false;
+			size_t field = 0;
+			for (size_t start = 0, end = 0; end != string::npos; start = end + 1, field++) {
+				end = line.find('\t', start);
+				size_t length = (end == string::npos ? line.length() : end) - start;
+				if (field == geneField) hits->genes[count].assign(line, start, length);
+				if (field == identityField) {
+					hits->identities[count].assign(line, start, length);
+					found = true;
+				}
+			}
+			if (!found || field <= geneField)
+				throw "proc::makeSummary(): " + filename + " has a hit with missing columns";
+			count++;
+		}
+		filectrl::closeFile(reader);
+		hits->genes.resize(count);
+		hits->identities.resize(count);
+
+		//A gene hit more than once keeps its hits in the order they were listed
+		hits->order.resize(count);
+		for (size_t x = 0; x < count; x++) hits->order[x] = (uint32_t)x;
+		std::stable_sort(hits->order.begin(), hits->order.end(),
+			[&](uint32_t a, uint32_t b) { return hits->genes[a] < hits->genes[b]; }
+		);
+	}
 
-		util::debug(1, "  Table populated, returning...");
-		return table;
+
+	/*Builds the summary abricate --summary would have made from a sample's raw ABRicate
+	*  outputs, straight into a workspace. Each output becomes a row, each gene found in
+	*  any of them a column (sorted by name), and each cell lists the identities of that
+	*  gene's hits separated by semicolons. The outputs are read on several threads, then
+	*  gathered into the table, which is converted and ranged just like makeTable's
+	*
+	* Precondition: outputs is not empty AND ws is not nullptr AND threads > 0
+	* Postcondition: ws holds what makeLabels and makeTable would have left in it for the
+	*		sample's summary
+	*
+	* Param directory is the directory that the outputs are found in
+	* Param outputs is the list of the sample's outputs, one per database
+	* Param ws is the workspace receiving the table
+	* Param threads is the most threads used to read the outputs
+	*/
+	void makeSummary(
+		const string& directory, const vector<string>& outputs, workspace_t* ws, int threads
+		) {
+		ABR_DEBUG(2, "makeSummary():");
+		prof::scopedTimer_t timer("makeSummary");
+
+		if (outputs.empty()) throw (string)"proc::makeSummary(): No outputs given for the sample";
+
+		//Workers pull the next unread output until the list runs out. The first error
+		// raised by any worker is kept and rethrown once they have all stopped
+		ABR_DEBUG(2, "  Reading " + std::to_string(outputs.size()) + " outputs");
+		if (ws->outputHits.size() < outputs.size()) ws->outputHits.resize(outputs.size());
+		std::atomic<size_t> nextOutput(0);
+		std::mutex errLock;
+		string firstErr = "";
+		auto worker = [&]() {
+			filectrl::reader_t reader;
+			for (size_t f = nextOutput++; f < outputs.size(); f = nextOutput++) {
+				try {
+					readOutput(directory, outputs[f], &reader, &ws->outputHits[f]);
+				}
+				catch (const char* err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = err;
+				}
+				catch (string err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = err;
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = "proc::makeSummary(): Unknown error reading " + outputs[f];
+				}
+			}
+		};
+		size_t workerCount = std::min((size_t)threads, outputs.size());
+		vector<std::thread> workers;
+		for (size_t x = 1; x < workerCount; x++) workers.push_back(std::thread(worker));
+		worker();
+		for (std::thread& th : workers) th.join();
+		if (firstErr != "") throw firstErr;
+
+		//Every gene hit in any of the outputs gets a column, in sorted order
+		ABR_DEBUG(2, "  Gathering the sample's genes");
+		vector<string>& genes = ws->outputGenes;
+		size_t geneCount = 0;
+		for (size_t f = 0; f < outputs.size(); f++)
+			for (const string& gene : ws->outputHits[f].genes)
+				pooledSlot(&genes, geneCount++, &ws->spareCells)->assign(gene);
+		resizePooled(&genes, geneCount, &ws->spareCells);
+		std::sort(genes.begin(), genes.end());
+		resizePooled(&genes, std::unique(genes.begin(), genes.end()) - genes.begin(), &ws->spareCells);
+
+		ABR_DEBUG(2, "  Laying out the summary's labels");
+		size_t columns = genes.size() + 2, rows = outputs.size();
+		resizePooled(&ws->labels, columns, &ws->spareCells);
+		ws->labels[0].assign("FILE");
+		ws->labels[1].assign("NUM_FOUND");
+		for (size_t g = 0; g < genes.size(); g++) ws->labels[g + 2].assign(genes[g]);
+		internLabels(ws->labels, &ws->labelIds);
+
+		vector<vector<string>>& table = ws->table;
+		resizePooled(&table, columns, &ws->spareColumns);
+		for (vector<string>& column : table) resizePooled(&column, rows, &ws->spareCells);
+		resetScan(genes.size(), ws);
+
+		//Walk each output's hits in gene order alongside the sorted columns, joining the
+		// identities of every hit of a gene into its cell
+		ABR_DEBUG(2, "  Filling in the summary's table");
+		for (size_t f = 0; f < rows; f++) {
+			const outputHits_t& hits = ws->outputHits[f];
+			size_t slash = outputs[f].find_last_of('/');
+			table[0][f].assign(outputs[f], slash == string::npos ? 0 : slash + 1, string::npos);
+
+			size_t next = 0, found = 0;
+			for (size_t g = 0; g < genes.size(); g++) {
+				string& cell = table[g + 2][f];
+				cell.clear();
+				while (next < hits.order.size() && hits.genes[hits.order[next]] == genes[g]) {
+					if (!cell.empty()) cell += ';';
+					cell += hits.identities[hits.order[next++]];
+				}
+				if (cell.empty()) cell.assign(".");
+				else found++;
+				scanEntry(cell, g + 2, ws);
+			}
+			table[1][f].assign(std::to_string(found));
+		}
+
+		ABR_DEBUG(2, "  Summary built, returning...");
+		return;
+	}
+
+
+	//Cache files start with this tag and version, bumped whenever the layout changes
+	static const char CACHE_MAGIC[4] = { 'A', 'B', 'R', 'C' };
+	static const uint32_t CACHE_VERSION = 1;
+
+	//This struct is the fixed header at the start of a cache file. Everything after it
+	// is found through offsets from the start of the file
+	struct cacheHeader_t {
+		char magic[4];
+		uint32_t version;
+		int64_t sourceTime;
+		uint64_t sourceSize;
+		uint32_t columns;
+		uint32_t hasHits;
+		double dataMin, dataMax;
+		uint64_t textOffset, textSize;
+	};
+
+	//This struct is the directory entry of one labelled column in a cache file. Data
+	// columns point at their values, and every column points at the offsets of its
+	// cells' text, with one extra offset marking the end of the last cell
+	struct cacheColumn_t {
+		uint32_t labelOffset, labelLength;
+		uint32_t rows, hits;
+		uint64_t valuesOffset, cellsOffset;
+	};
+
+
+	/*Finds the modification time and size of a summary, which tell whether a cache
+	*  made from it is still good
+	*
+	* Param path is the path of the summary
+	* Param time is populated with the summary's modification time
+	* Param size is populated with the summary's size in bytes
+	* Returns false if the summary couldn't be found, true OW
+	*/
+	static bool sourceStamp(const string& path, int64_t* time, uint64_t* size) {
+		//stat is asked directly, since std::filesystem builds a path object from the
+		// string and allocates on every call, where a cached graph otherwise doesn't
+#ifdef _WIN32
+		struct _stat64 info;
+		if (_stat64(path.c_str(), &info) != 0) return false;
+		*time = (int64_t)info.st_mtime * 1000000000;
+#else
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0) return false;
+#ifdef __APPLE__
+		*time = (int64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+		*time = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+#endif
+		*size = (uint64_t)info.st_size;
+		return true;
+	}
+
+
+	/*Checks a mapped cache file and copies its table into a workspace
+	*
+	* Param map is the mapped cache file
+	* Param sourcePath is the path of the summary the cache was made from
+	* Param ws is the workspace receiving the table
+	* Returns false if the cache is stale or damaged, true OW
+	*/
+	static bool readCache(
+		const filectrl::mappedFile_t& map, const string& sourcePath, workspace_t* ws
+		) {
+		//Check the header against the summary before trusting anything else in the file
+		ABR_DEBUG(2, "  Checking cache header against the summary");
+		cacheHeader_t header;
+		if (map.size < sizeof(header)) return false;
+		memcpy(&header, map.data, sizeof(header));
+		if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) return false;
+		if (header.version != CACHE_VERSION) return false;
+		int64_t time; uint64_t size;
+		if (!sourceStamp(sourcePath, &time, &size)) return false;
+		if (time != header.sourceTime || size != header.sourceSize) {
+			ABR_DEBUG(2, "  Summary has changed since the cache was written");
+			return false;
+		}
+
+		//Check that every span the directory gives lies inside the file, and that the
+		// table has its FILE and NUM_FOUND columns with every column as long as the first,
+		// so a truncated or damaged cache is reparsed rather than read out of bounds
+		ABR_DEBUG(2, "  Checking cache directory");
+		if (header.columns < 2) return false;
+		uint64_t dirEnd = sizeof(header) + (uint64_t)header.columns * sizeof(cacheColumn_t);
+		if (dirEnd > map.size || header.textOffset < dirEnd || header.textOffset > map.size ||
+			header.textSize > map.size - header.textOffset) return false;
+		const cacheColumn_t* directory = (const cacheColumn_t*)(map.data + sizeof(header));
+		const char* text = (const char*)map.data + header.textOffset;
+		for (uint32_t x = 0; x < header.columns; x++) {
+			const cacheColumn_t& col = directory[x];
+			if (col.rows != directory[0].rows) return false;
+			if ((uint64_t)col.labelOffset + col.labelLength > header.textSize) return false;
+			if (col.cellsOffset % sizeof(uint32_t) != 0 || col.cellsOffset < dirEnd ||
+				col.cellsOffset + ((uint64_t)col.rows + 1) * sizeof(uint32_t) > header.textOffset)
+				return false;
+			if (x >= 2 && (col.valuesOffset % sizeof(double) != 0 || col.valuesOffset < dirEnd ||
+				col.valuesOffset + (uint64_t)col.rows * sizeof(double) > header.textOffset))
+				return false;
+
+			const uint32_t* cells = (const uint32_t*)(map.data + col.cellsOffset);
+			if (cells[col.rows] > header.textSize) return false;
+			for (uint32_t y = 0; y < col.rows; y++)
+				if (cells[y] > cells[y + 1]) return false;
+		}
+
+		//Copy the labels, cells and values straight out of the mapping, over whatever
+		// the last file left in the workspace
+		ABR_DEBUG(2, "  Copying cached table into the workspace");
+		size_t columns = header.columns;
+		resizePooled(&ws->labels, columns, &ws->spareCells);
+		resizePooled(&ws->table, columns, &ws->spareColumns);
+		resetScan(columns > 2 ? columns - 2 : 0, ws);
+		for (size_t x = 0; x < columns; x++) {
+			const cacheColumn_t& col = directory[x];
+			ws->labels[x].assign(text + col.labelOffset, col.labelLength);
+
+			vector<string>& column = ws->table[x];
+			const uint32_t* cells = (const uint32_t*)(map.data + col.cellsOffset);
+			for (uint32_t y = 0; y < col.rows; y++)
+				pooledSlot(&column, y, &ws->spareCells)->assign(
+					text + cells[y], cells[y + 1] - cells[y]
+				);
+			resizePooled(&column, col.rows, &ws->spareCells);
+
+			if (x >= 2) {
+				vector<double>& values = ws->rawdata[x - 2];
+				values.resize(col.rows);
+				if (col.rows > 0)
+					memcpy(values.data(), map.data + col.valuesOffset, col.rows * sizeof(double));
+				ws->columnHits[x - 2] = col.hits;
+			}
+		}
+		ws->hasHits = header.hasHits != 0;
+		ws->dataMin = header.dataMin;
+		ws->dataMax = header.dataMax;
+		internLabels(ws->labels, &ws->labelIds);
+
+		return true;
+	}
+
+
+	/*Reads a table from its binary cache file into a workspace, in place of parsing the
+	*  summary it was made from. The cache is mapped into memory and copied straight into
+	*  the workspace, with no tokenizing or number conversion. A cache is only used when
+	*  its summary still has the modification time and size it had when it was written
+	*
+	* Precondition: ws is not nullptr
+	* Postcondition: If the cache was used, ws holds exactly what makeLabels and makeTable
+	*		would have left in it for the summary
+	*
+	* Param cachePath is the path of the cache file
+	* Param sourcePath is the path of the summary the cache was made from
+	* Param ws is the workspace receiving the table
+	* Returns true if the table was read from the cache, false if the cache is missing,
+	*  stale or damaged and the summary has to be parsed
+	*/
+	bool loadCache(const string& cachePath, const string& sourcePath, workspace_t* ws) {
+		ABR_DEBUG(2, "loadCache():");
+		prof::scopedTimer_t timer("loadCache");
+
+		filectrl::mappedFile_t map;
+		if (!filectrl::mapFile(cachePath, &map)) {
+			ABR_DEBUG(2, "  No cache found, returning...");
+			return false;
+		}
+		bool loaded = readCache(map, sourcePath, ws);
+		filectrl::unmapFile(&map);
+
+		ABR_DEBUG(2, loaded ? "  Table read from cache, returning..." :
+			"  Cache is stale or damaged, returning...");
+		return loaded;
+	}
+
+
+	/*Writes the table held in a workspace to a binary cache file beside its summary.
+	*  The file holds a header recording the summary's modification time and size, the
+	*  labels, a directory of the columns, each data column's values and hit count, and
+	*  the offsets of every cell's text (multi-hit cells included) in one string block
+	*
+	* Precondition: ws holds a table read in by makeLabels and makeTable
+	*
+	* Param cachePath is the path of the cache file, which is replaced if it exists
+	* Param sourcePath is the path of the summary the table was read from
+	* Param ws is the workspace holding the table
+	* Returns false if the cache couldn't be written, true OW
+	*/
+	bool saveCache(const string& cachePath, const string& sourcePath, const workspace_t& ws) {
+		ABR_DEBUG(2, "saveCache():");
+		prof::scopedTimer_t timer("saveCache");
+
+		cacheHeader_t header = {};
+		memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header.version = CACHE_VERSION;
+		if (!sourceStamp(sourcePath, &header.sourceTime, &header.sourceSize)) return false;
+		header.columns = (uint32_t)ws.table.size();
+		header.hasHits = ws.hasHits ? 1 : 0;
+		header.dataMin = ws.dataMin;
+		header.dataMax = ws.dataMax;
+
+		//Lay the file out as the header, the directory, each column's values and cell
+		// offsets, then the text of every label and cell. Each column's label comes just
+		// before its cells in the text, and values are kept on 8 byte boundaries
+		ABR_DEBUG(2, "  Laying out cache file");
+		vector<cacheColumn_t> directory(header.columns);
+		uint64_t offset = sizeof(header) + directory.size() * sizeof(cacheColumn_t);
+		uint64_t textSize = 0;
+		for (size_t x = 0; x < directory.size(); x++) {
+			cacheColumn_t& col = directory[x];
+			col.labelOffset = (uint32_t)textSize;
+			col.labelLength = (uint32_t)ws.labels[x].length();
+			textSize += col.labelLength;
+			col.rows = (uint32_t)ws.table[x].size();
+			col.hits = x >= 2 ? (uint32_t)ws.columnHits[x - 2] : 0;
+			col.valuesOffset = 0;
+			if (x >= 2) {
+				col.valuesOffset = offset;
+				offset += (uint64_t)col.rows * sizeof(double);
+			}
+			col.cellsOffset = offset;
+			offset += ((uint64_t)col.rows + 1) * sizeof(uint32_t);
+			offset = (offset + 7) & ~(uint64_t)7;
+			for (const string& cell : ws.table[x]) textSize += cell.length();
+		}
+		//Cell offsets are 32 bits, so summaries with more text than that go uncached
+		if (textSize > UINT32_MAX) return false;
+		header.textOffset = offset;
+		header.textSize = textSize;
+
+		//Write to a temporary file and move it into place once it's complete, so a run
+		// that stops partway never leaves a cache that looks whole
+		ABR_DEBUG(2, "  Writing cache file");
+		string tempPath = cachePath + ".tmp";
+		std::ofstream out(tempPath, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!out.is_open()) return false;
+		out.write((const char*)&header, sizeof(header));
+		out.write((const char*)directory.data(), directory.size() * sizeof(cacheColumn_t));
+
+		vector<uint32_t> cells;
+		uint64_t written = sizeof(header) + directory.size() * sizeof(cacheColumn_t);
+		uint32_t cellText = 0;
+		for (size_t x = 0; x < directory.size(); x++) {
+			if (x >= 2) {
+				out.write((const char*)ws.rawdata[x - 2].data(), directory[x].rows * sizeof(double));
+				written += (uint64_t)directory[x].rows * sizeof(double);
+			}
+
+			cellText += directory[x].labelLength;
+			cells.clear();
+			for (const string& cell : ws.table[x]) {
+				cells.push_back(cellText);
+				cellText += (uint32_t)cell.length();
+			}
+			cells.push_back(cellText);
+			out.write((const char*)cells.data(), cells.size() * sizeof(uint32_t));
+			written += cells.size() * sizeof(uint32_t);
+
+			static const char padding[8] = {};
+			uint64_t aligned = (written + 7) & ~(uint64_t)7;
+			out.write(padding, aligned - written);
+			written = aligned;
+		}
+
+		for (size_t x = 0; x < directory.size(); x++) {
+			out.write(ws.labels[x].data(), ws.labels[x].length());
+			for (const string& cell : ws.table[x]) out.write(cell.data(), cell.length());
+		}
+		out.close();
+
+		std::error_code err;
+		if (out.fail()) {
+			std::filesystem::remove(tempPath, err);
+			return false;
+		}
+		std::filesystem::rename(tempPath, cachePath, err);
+		if (err) {
+			std::filesystem::remove(tempPath, err);
+			return false;
+		}
+
+		ABR_DEBUG(2, "  Cache written, returning...");
+		return true;
 	}
 
 
@@ -114,39 +771,41 @@ namespace proc {
 	void printGraphFrame(
 		SDL_Renderer* renderer, SDL_Texture* texture, graphData_t* graphInfo, TTF_Font* font
 		) {
-		util::debug(1, "printGraphFrame():");
+		ABR_DEBUG(2, "printGraphFrame():");
+		prof::scopedTimer_t timer("printGraphFrame");
 
 		//Draw boundaries between the file columns
-		util::debug(1, "  Generating horizontal divisions");
+		ABR_DEBUG(2, "  Generating horizontal divisions");
 		int colWidth = graphInfo->framepos.w / graphInfo->fileList.size();
+		int labelOffset = util::scaled(20);
 		for (size_t x = 0; x < graphInfo->fileList.size(); x++) {
-			util::debug(1, "  Handling label " + graphInfo->fileList[x].first);
-			util::debug(1, "    Printing label text");
+			ABR_DEBUG(2, "  Handling label " + graphInfo->fileList[x].first);
+			ABR_DEBUG(3, "    Printing label text");
 			util::printText(
 				renderer, texture,
 				graphInfo->fileList[x].first,
-				graphInfo->framepos.x + x * colWidth + 20,
-				graphInfo->framepos.y + graphInfo->framepos.h + 5 + util::ABR_GRAPH_THICKNESS,
-				14, 40,
+				graphInfo->framepos.x + x * colWidth + labelOffset,
+				graphInfo->framepos.y + graphInfo->framepos.h + util::scaled(5) + util::graphThickness(),
+				util::scaled(14), 40,
 				util::ABR_GRAPH_COLOR1,
 				font,
 				nullptr
 				);
-			graphInfo->fileList[x].second = graphInfo->framepos.x + x * colWidth + 20;
+			graphInfo->fileList[x].second = graphInfo->framepos.x + x * colWidth + labelOffset;
 
-			util::debug(1, "    Drawing vertical division");
+			ABR_DEBUG(3, "    Drawing vertical division");
 			SDL_Point top = {
-				graphInfo->framepos.x + (x + 1) * colWidth + util::ABR_GRAPH_THICKNESS,
+				graphInfo->framepos.x + (x + 1) * colWidth + util::graphThickness(),
 				graphInfo->framepos.y
 			};
 			SDL_Point bottom = {
-				graphInfo->framepos.x + (x + 1) * colWidth + util::ABR_GRAPH_THICKNESS,
+				graphInfo->framepos.x + (x + 1) * colWidth + util::graphThickness(),
 				graphInfo->framepos.y + graphInfo->framepos.h
 			};
 			util::drawLine(renderer, texture, top, bottom, util::ABR_GRAPH_COLOR2);
 
 		}
-		util::debug(1, "  Drawing graph cap line");
+		ABR_DEBUG(2, "  Drawing graph cap line");
 		util::drawLine(
 			renderer, texture,
 			{ graphInfo->framepos.x, graphInfo->framepos.y },
@@ -155,10 +814,10 @@ namespace proc {
 			);
 
 		//Draw the graph height markers and labels
-		util::debug(1, "  Drawing graph height markers");
+		ABR_DEBUG(2, "  Drawing graph height markers");
 		int rowHeight = graphInfo->framepos.h / graphInfo->vertDivisions;
 		for (int x = 0; x <= graphInfo->vertDivisions; x++) {
-			util::debug(1, "    Drawing horizontal line across the graph frame");
+			ABR_DEBUG(3, "    Drawing horizontal line across the graph frame");
 			//Get the endpoints of a horizontal line across the screen
 			SDL_Point left = {
 				graphInfo->framepos.x,
@@ -172,7 +831,7 @@ namespace proc {
 			util::drawLine(renderer, texture, left, right, util::ABR_GRAPH_COLOR2);
 
 			//Store the numeric value of the horizontal line as a double
-			util::debug(1, "    Calculating numeric value of horizontal division");
+			ABR_DEBUG(3, "    Calculating numeric value of horizontal division");
 			double index =
 				(graphInfo->rangeMax - graphInfo->rangeMin) / graphInfo->vertDivisions;
 			index *= graphInfo->vertDivisions - x;
@@ -182,13 +841,13 @@ namespace proc {
 			hLabel = hLabel.substr(0, hLabel.length() - 4);
 
 			//Print the text label for the horizontal mark
-			util::debug(1, "    Printing horizontal division");
+			ABR_DEBUG(3, "    Printing horizontal division");
 			util::printText(
 				renderer, texture,
 				hLabel,
-				graphInfo->framepos.x - 20 - 5 * hLabel.length() - util::ABR_GRAPH_THICKNESS,
-				graphInfo->framepos.y + x * rowHeight - 5,
-				14, 0,
+				graphInfo->framepos.x - util::scaled(20 + 5 * hLabel.length()) - util::graphThickness(),
+				graphInfo->framepos.y + x * rowHeight - util::scaled(5),
+				util::scaled(14), 0,
 				util::ABR_GRAPH_COLOR1,
 				font,
 				nullptr
@@ -196,21 +855,21 @@ namespace proc {
 		}
 
 		//Store the points for the outer edge of the graph
-		util::debug(1, "  Printing initial left-bottom sides of the graph");
+		ABR_DEBUG(2, "  Printing initial left-bottom sides of the graph");
 		SDL_Point points[3] = {
 			{graphInfo->framepos.x,
 			 graphInfo->framepos.y},
 
 			{graphInfo->framepos.x,
-			 graphInfo->framepos.y + graphInfo->framepos.h + util::ABR_GRAPH_THICKNESS},
+			 graphInfo->framepos.y + graphInfo->framepos.h + util::graphThickness()},
 
 			{graphInfo->framepos.x + graphInfo->framepos.w,
-			 graphInfo->framepos.y + graphInfo->framepos.h + util::ABR_GRAPH_THICKNESS}
+			 graphInfo->framepos.y + graphInfo->framepos.h + util::graphThickness()}
 		};
 		util::polygon_t boundary = { points, 3 };
 
-		util::debug(1, "  Increasing main frame thickness");
-		for (int x = 0; x < util::ABR_GRAPH_THICKNESS; x++) {
+		ABR_DEBUG(2, "  Increasing main frame thickness");
+		for (int x = 0, thickness = util::graphThickness(); x < thickness; x++) {
 			//Draw the current boundary
 			util::drawPolygon(renderer, texture, boundary, util::ABR_GRAPH_COLOR1);
 
@@ -225,7 +884,37 @@ namespace proc {
 			boundary.pointArr[2].y -= 1;
 		}
 
-		util::debug(1, "  Graph frame printed, returning...");
+		ABR_DEBUG(2, "  Graph frame printed, returning...");
+		return;
+	}
+
+
+	/*Pads a data range out for display and stores it as a graph's range
+	*
+	* Param min is the smallest value in the data
+	* Param max is the largest value in the data
+	* Param graphdata is the a data structure whose range values will be populated
+	*/
+	static void padRange(double min, double max, graphData_t* graphdata) {
+		ABR_DEBUG(2, "  Calculating range margin for display padding");
+		double margin = 0.0;
+		//If the min and max are the same, add 5% padding on either side
+		if (max == min) {
+			ABR_DEBUG(3, "    Range found to be zero, storing absolute 5% margin");
+			margin = 5.0;
+		}
+		//If there is a range of values, add 25% of the range as padding
+		else {
+			ABR_DEBUG(3, "    Range found to be greater than zero, storing 25% of range as margin");
+			margin = (max - min) * 0.25;
+		}
+
+		//Add the padding to the value, ensuring that the range does not
+		// exceed 100% or 0% certainty values
+		ABR_DEBUG(2, "  Ensuring range expansion does not exit the bounds");
+		graphdata->rangeMax = (max + margin < 100.0 ? max + margin : 100.0);
+		graphdata->rangeMin = (min - margin > 000.0 ? min - margin : 100.0);
+
 		return;
 	}
 
@@ -238,87 +927,72 @@ namespace proc {
 	* Param table is the data table generated from the input file
 	* Param graphdata is the a data structure whose range values will be populated
 	*/
-	void getDataRange(vector<vector<string>> table, graphData_t* graphdata) {
-		util::debug(1, "getDataRange():");
+	void getDataRange(const vector<vector<string>>& table, graphData_t* graphdata) {
+		ABR_DEBUG(2, "getDataRange():");
+		prof::scopedTimer_t timer("getDataRange");
 
 		//Initialize the minimum and maximum values to null values
 		double min = 0, max = 0;
 
 		//Set a value to track the initialization of the min/max values
 		bool first = true;
-		util::debug(1, "  Parsing data to gather data range");
+		ABR_DEBUG(2, "  Parsing data to gather data range");
 		for (int x = 2; x < table.size(); x++) {
 			for (int y = 0; y < table[x].size(); y++) {
 				
 				//If no value was found in the Abricate processing, skip past the entry
 				if (table[x][y] == ".") {
-					util::debug(1, "    Null value found, moving on to next entry in the table");
+					ABR_DEBUG(3, "    Null value found, moving on to next entry in the table");
 					continue;
 				}
 
-				//This section converts a string entry to a double value
-				double currVal = 0;
-				//If multiple values have been found, take the first and convert it to a double
+				//Convert the string entry to a double value. If multiple values have been
+				// found, only the first is taken
 				// This will probably change later when I decide on how to handle multiple hits
-				if (util::contains(table[x][y].c_str(), ';', table[x][y].size())) {
-					util::debug(1, "    Multivalue entry found, taking first numeric value");
-					int endpt = 0;
-					for (char c : table[x][y]) {
-						if (c == ';') break;
-						endpt++;
-					}
-
-					currVal = std::stod(table[x][y].substr(0, endpt));
-				}
-				//If a single value has been found, convert it to a double directly
-				else {
-					util::debug(1, "    Single value entry found");
-					currVal = std::stod(table[x][y]);
-				}
+				double currVal = parseIdentity(table[x][y]);
 
 				//If this is the first value found, initialize the min and max values
 				if (first) {
-					util::debug(1, "    First numeiric entry found, initializing range values");
+					ABR_DEBUG(3, "    First numeiric entry found, initializing range values");
 					min = currVal; max = currVal;
 					first = false;
 				}
 
-				util::debug(1, "    Adjusting range values");
+				ABR_DEBUG(3, "    Adjusting range values");
 				//Check whether the maximum value is greater than the current maximum
 				if (currVal > max) {
-					util::debug(1, "      Increasing maximum range value");
+					ABR_DEBUG(3, "      Increasing maximum range value");
 					max = currVal;
 				}
 				//Check whether the minimum value is less than the current minimum
 				if (currVal < min) {
-					util::debug(1, "      Decreasing minimum range value");
+					ABR_DEBUG(3, "      Decreasing minimum range value");
 					min = currVal;
 				}
 
-				util::debug(1, "    Entry properly parsed, moving on");
+				ABR_DEBUG(3, "    Entry properly parsed, moving on");
 			}
 		}
-		util::debug(1, "  Finished parsing table");
+		ABR_DEBUG(2, "  Finished parsing table");
 
-		util::debug(1, "  Calculating range margin for display padding");
-		double margin = 0.0;
-		//If the min and max are the same, add 5% padding on either side
-		if (max == min) {
-			util::debug(1, "    Range found to be zero, storing absolute 5% margin");
-			margin = 5.0;
-		}
-		//If there is a range of values, add 25% of the range as padding
-		else {
-			util::debug(1, "    Range found to be greater than zero, storing 25% of range as margin");
-			margin = (max - min) * 0.25;
-		}
+		padRange(min, max, graphdata);
+		return;
+	}
 
-		//Add the padding to the value, ensuring that the range does not
-		// exceed 100% or 0% certainty values
-		util::debug(1, "  Ensuring range expansion does not exit the bounds");
-		graphdata->rangeMax = (max + margin < 100.0 ? max + margin : 100.0);
-		graphdata->rangeMin = (min - margin > 000.0 ? min - margin : 100.0);
 
+	/*Sets a graph's range from the data range a workspace collected while its table
+	*  was read in, with no further pass over the table
+	*
+	* Precondition: graphdata != nullptr AND ws holds a scanned table
+	* Postcondition: graphdata.rangeMax and graphdata.rangeMin will be populated with appropriate values
+	*
+	* Param ws is the workspace holding the scanned table
+	* Param graphdata is the a data structure whose range values will be populated
+	*/
+	void getDataRange(const workspace_t& ws, graphData_t* graphdata) {
+		ABR_DEBUG(2, "getDataRange():");
+		prof::scopedTimer_t timer("getDataRange");
+		padRange(ws.dataMin, ws.dataMax, graphdata);
 		return;
 	}
 
@@ -335,52 +1009,47 @@ namespace proc {
 	* Returns a vector of graph bars reflecting the confidence of hits from the database
 	*/
 	vector<graphBar_t> generateBars(
-		graphData_t graphdata, vector<string> labels, vector<vector<string>> table
+		const graphData_t& graphdata, const vector<string>& labels,
+		const vector<vector<string>>& table
 		) {
-		util::debug(1, "generateBars()");
+		workspace_t ws;
+		scanTable(table, &ws);
+		generateBars(graphdata, labels, &ws);
+		return std::move(ws.bars);
+	}
 
-		//Process the table into raw data
-		vector<vector<double>> rawdata;
-		util::debug(1, "  Processing passed-in table into raw data");
-		for (int x = 2; x < labels.size(); x++) {
-			
-			vector<double> currCol;
-			for (string s : table[x]) {
-
-				//If there were no hits found, add a zero to the value list
-				if (s == ".") {
-					util::debug(1, "    Null value entryfound, interpreting as 0.0");
-					currCol.push_back(0.0);
-				}
-				//If there is only a single hit in the table, convert it directly for the table
-				else if (!util::contains(s.c_str(), ';', s.length())) {
-					util::debug(1, "    Single value entry found");
-					currCol.push_back(std::stod(s));
-				}
-				//if there are several hits in the table, take the first (fix this later)
-				else {
-					util::debug(1, "    Multivalue entry found, taking first numeric value");
-					int endpt = 0;
-					for (char c : s) {
-						if (c == ';') break;
-						endpt++;
-					}
-					currCol.push_back( std::stod(s.substr(0, endpt)) );
-				}
-			}
-			rawdata.push_back(currCol);
-		}
-		util::debug(1, "  Table successfully parsed into raw data");
+
+	/*Generates the list of bars for a graph into a workspace from the numeric matrix
+	*  collected when its table was read in, reusing the storage left over from the
+	*  graphs before it
+	*
+	* Precondition: ws is not nullptr AND ws holds the scanned table that labels belong
+	*		to AND graphdata range values are already populated
+	* Postcondition: ws->bars holds the graph's bars
+	*
+	* Param graphdata is a struct containing graph positioning and range data
+	* Param labels is the list of database labels matching the table's columns
+	* Param ws is the workspace holding the scanned table and receiving the bars
+	*/
+	void generateBars(
+		const graphData_t& graphdata, const vector<string>& labels, workspace_t* ws
+		) {
+		ABR_DEBUG(2, "generateBars()");
+		prof::scopedTimer_t timer("generateBars");
+
+		//The table was already converted into raw data as it was read in
+		const vector<vector<double>>& rawdata = ws->rawdata;
 
 		if (rawdata.size() == 0) {
-			util::debug(1, "  Parsed table found to be empty, returning...");
-			return vector<graphBar_t>();
+			ABR_DEBUG(2, "  Parsed table found to be empty, returning...");
+			resizePooled(&ws->bars, 0, &ws->spareBars);
+			return;
 		}
 
 		//Calculate the width of a bar on the screen so it only has to be done once
-		util::debug(1, "  Calculating bar width");
+		ABR_DEBUG(2, "  Calculating bar width");
 		const int entryWidth = (graphdata.framepos.w / graphdata.fileList.size()) + 1;
-		int barwidth = entryWidth - util::ABR_GRAPH_THICKNESS * 4;
+		int barwidth = entryWidth - util::graphThickness() * 4;
 		int padding = (entryWidth - barwidth) / 2;
 
 		//barwidth /= rawdata.size();
@@ -389,26 +1058,38 @@ namespace proc {
 		if (rawdata.size() > 3) barwidth *= 2;
 
 
-		//Create a vector to store the bars, they will be graphed label-by-label
-		vector<graphBar_t> graphList;
+		//Store the bars in the workspace, they will be graphed label-by-label. Sorting
+		// shuffles the bars between slots, so every slot is sized for the longest label
+		// the workspace has seen to keep a short slot from growing when a long label
+		// lands in it later
+		size_t barCount = 0;
+		for (const string& label : labels)
+			ws->longestLabel = std::max(ws->longestLabel, label.length());
 		//Parse through the data to create bars for rendering
-		util::debug(1, "  Generating displayable bars");
+		ABR_DEBUG(2, "  Generating displayable bars");
 		int xoffset = 0;
 		for (int x = 0; x < rawdata.size(); x++) {
+			//Columns without a single hit have no bars to make
+			if (ws->columnHits[x] == 0) {
+				ABR_DEBUG(3, "    Column found to have no hits, moving on to next column");
+				xoffset += barwidth;
+				continue;
+			}
+
 			for (int y = 0; y < rawdata[x].size(); y++) {
 				//If the current entry is zero, move on
 				if (rawdata[x][y] == 0) {
-					util::debug(1, "    Bar value found to be zero, moving on to next entry");
+					ABR_DEBUG(3, "    Bar value found to be zero, moving on to next entry");
 					continue;
 				}
 
 				//Update the horizontal position based on the file being displayed
-				util::debug(1, "    Calculating horizontal bar position");
-				int xpos = graphdata.fileList[y].second - 15 + padding;
+				ABR_DEBUG(3, "    Calculating horizontal bar position");
+				int xpos = graphdata.fileList[y].second - util::scaled(15) + padding;
 				xpos += barpad * x;
 
 				//Calculate the height of the bar
-				util::debug(1, "    Calculating bar height");
+				ABR_DEBUG(3, "    Calculating bar height");
 				double range = graphdata.rangeMax - graphdata.rangeMin;
 				int height = 0;
 				if (rawdata[x][y] != 0)
@@ -417,34 +1098,34 @@ namespace proc {
 						);
 				
 				//Calculate the top position of the bar
-				util::debug(1, "    Calculating vertical bar position");
+				ABR_DEBUG(3, "    Calculating vertical bar position");
 				int ypos = graphdata.framepos.y + (graphdata.framepos.h - height) + 1;
 
 				//Gather the bar's rect
-				util::debug(1, "    Storing bar data");
+				ABR_DEBUG(3, "    Storing bar data");
 				SDL_Rect barRect = { xpos, ypos, barwidth, height };
 
-				util::debug(1, "    Storing bar metadata");
-				graphBar_t newBar;
-				newBar.label = labels[x + 2];
-				newBar.value = rawdata[x][y];
-				newBar.barRect = barRect;
-				newBar.color = util::ABR_BAR_COLORS[x];
-
-				graphList.push_back(newBar);
+				ABR_DEBUG(3, "    Storing bar metadata");
+				graphBar_t* newBar = pooledSlot(&ws->bars, barCount++, &ws->spareBars);
+				newBar->label.reserve(ws->longestLabel);
+				newBar->label.assign(labels[x + 2]);
+				newBar->value = rawdata[x][y];
+				newBar->barRect = barRect;
+				newBar->color = util::barColor(x);
 			}
 			//Increase the offset so the bars are all equally visible
 			xoffset += barwidth;
 		}
 
-		//Return the compiled list of bars
-		util::debug(1, "  Bar list successfully generated, returning...");
-		return graphList;
+		//Drop whatever bars the last graph left past the end of the list
+		resizePooled(&ws->bars, barCount, &ws->spareBars);
+		ABR_DEBUG(2, "  Bar list successfully generated, returning...");
+		return;
 	}
 
 
 	/*Determines if the height of bar B is less than that of bar A*/
-	bool isShorter(graphBar_t barA, graphBar_t barB) {
+	bool isShorter(const graphBar_t& barA, const graphBar_t& barB) {
 		return barA.barRect.h > barB.barRect.h;
 	}
 
@@ -459,10 +1140,11 @@ namespace proc {
 	* Returns nothing
 	*/
 	void focusShortBars(vector<graphBar_t>* barsList) {
-		util::debug(1, "focusShortBars()");
-		util::debug(1, "  Sorting bars by height, tallest to shortest");
+		ABR_DEBUG(2, "focusShortBars()");
+		prof::scopedTimer_t timer("focusShortBars");
+		ABR_DEBUG(2, "  Sorting bars by height, tallest to shortest");
 		std::sort(barsList->begin(), barsList->end(), isShorter);
-		util::debug(1, "  Bars sorted, returning...");
+		ABR_DEBUG(2, "  Bars sorted, returning...");
 	}
 
 
@@ -480,28 +1162,30 @@ namespace proc {
 	* Param font is the TTL_Font that the labels will be printed in
 	*/
 	void printKeys(
-		SDL_Renderer* renderer, SDL_Texture* texture, vector<string> labels,
-		graphData_t graphinfo, TTF_Font* font
+		SDL_Renderer* renderer, SDL_Texture* texture, const vector<string>& labels,
+		const graphData_t& graphinfo, TTF_Font* font
 		) {
-		util::debug(1, "printKeys():");
+		ABR_DEBUG(2, "printKeys():");
+		prof::scopedTimer_t timer("printKeys");
 
 		//Store the starting positions of the graph and the sizing for both color tiles and text
-		util::debug(1, "  Storing key starting position, as well as sizing information");
-		int xpos = graphinfo.framepos.x, ypos = graphinfo.framepos.y - 70;
-		int colw = 10, colh = 10;
-		int fontsize = 14;
+		ABR_DEBUG(2, "  Storing key starting position, as well as sizing information");
+		int xpos = graphinfo.framepos.x, ypos = graphinfo.framepos.y - util::scaled(70);
+		int colw = util::scaled(10), colh = util::scaled(10);
+		int fontsize = util::scaled(14);
+		int tilePad = util::scaled(5), textPad = util::scaled(25);
 
 		//Iterate through each database field in the labels list
-		util::debug(1, "  Iterating through labels");
+		ABR_DEBUG(2, "  Iterating through labels");
 		for (int x = 2; x < labels.size(); x++) {
-			util::debug(1, "  Handling label " + labels[x]);
+			ABR_DEBUG(2, "  Handling label " + labels[x]);
 
 			//Create a color tile rect with a proper position, centering it with the text
 			SDL_Rect colTileRect = { xpos, ypos + (fontsize - colh) / 2, colw, colh };
 			//Draw the color tile and move the xposition to where the new text will be printed
 			try {
-				util::debug(1, "    Drawing bar color");
-				util::fillRect(renderer, texture, colTileRect, util::ABR_BAR_COLORS[x - 2]);
+				ABR_DEBUG(3, "    Drawing bar color");
+				util::fillRect(renderer, texture, colTileRect, util::barColor(x - 2));
 			}
 			//Handle potential errors and throw them up the chain
 			catch (std::string err) {
@@ -513,12 +1197,12 @@ namespace proc {
 			catch (...) {
 				throw "proc::printKeuys(): Unknown error occurred while drawing color tile";
 			}
-			xpos += colw + 5;
+			xpos += colw + tilePad;
 
 			//Print the label of the database and store the destination rect of the text
 			SDL_Rect textRect;
 			try {
-				util::debug(1, "    Printing label text");
+				ABR_DEBUG(3, "    Printing label text");
 				util::printText(renderer, texture, labels[x], xpos, ypos, fontsize,
 								0, util::ABR_GRAPH_COLOR1, font, &textRect);
 			}
@@ -533,19 +1217,19 @@ namespace proc {
 				throw "proc::printKeuys(): Unknown error occurred while rendering label text";
 			}
 
-			util::debug(1, "    Shifting horizontal index forward");
-			xpos += colw + 5;
+			ABR_DEBUG(3, "    Shifting horizontal index forward");
+			xpos += colw + tilePad;
 			//Advance the x-position to the other side of the text, adding padding
-			xpos += textRect.w + 25;
+			xpos += textRect.w + textPad;
 
 			if (xpos >= graphinfo.framepos.w * 0.9) {
-				util::debug(1, "      Horizontal position exited range, moving to a new line");
+				ABR_DEBUG(3, "      Horizontal position exited range, moving to a new line");
 				xpos = graphinfo.framepos.x;
 				ypos += fontsize * 1.5;
 			}
 		}
 
-		util::debug(1, "  Key successfully printed, returning...");
+		ABR_DEBUG(2, "  Key successfully printed, returning...");
 		return;
 	}
 
@@ -563,29 +1247,718 @@ namespace proc {
 	* Param printVals is a bool representing whether the bar values will be printed
 	*/
 	void printBars(
-		SDL_Renderer* renderer, SDL_Texture* texture, vector<graphBar_t> barsList,
+		SDL_Renderer* renderer, SDL_Texture* texture, const vector<graphBar_t>& barsList,
 		TTF_Font* font, bool printVals
 		) {
-		util::debug(1, "printBars()");
+		ABR_DEBUG(2, "printBars()");
+		prof::scopedTimer_t timer("printBars");
 
 		//Iterate through each bar in the list
-		util::debug(1, "  Iterating through the passed-in list of bars");
-		for (graphBar_t bar : barsList) {
-			util::debug(1, "    Rendering bar to screen");
+		ABR_DEBUG(2, "  Iterating through the passed-in list of bars");
+		for (const graphBar_t& bar : barsList) {
+			ABR_DEBUG(3, "    Rendering bar to screen");
 			//Print the bar itself
 			util::fillRect(renderer, texture, bar.barRect, bar.color);
 
 			//Print the value of the bar if instructed to do so
 			if (printVals) {
-				util::debug(1, "    Printing bar hit value");
+				ABR_DEBUG(3, "    Printing bar hit value");
 				util::printText(renderer, texture,
 					std::to_string(bar.value).substr(0, std::to_string(bar.value).length() - 4), //I don't want to talk about it
-					bar.barRect.x + 5,
-					bar.barRect.y + 5, 14, 0, util::ABR_GRAPH_COLOR1, font, nullptr);
+					bar.barRect.x + util::scaled(5),
+					bar.barRect.y + util::scaled(5), util::scaled(14), 0, util::ABR_GRAPH_COLOR1,
+					font, nullptr);
+			}
+		}
+
+		ABR_DEBUG(2, "  Bars successfully printed, returning...");
+		return;
+	}
+
+
+	/*Renders a complete bar graph (header, frame, keys and bars) from a parsed table
+	* 
+	* Precondition: renderer != nullptr AND texture != nullptr AND font != nullptr AND
+	*		labels and table were produced by makeLabels/makeTable AND texture is img_w x img_h
+	* Postcondition: texture and the renderer's target surface hold the finished graph
+	* 
+	* Param renderer is the SDL_Renderer that will draw the graph
+	* Param texture is the SDL_Texture that the graph is drawn onto
+	* Param font is the TTF_Font used for all of the graph's text
+	* Param title is the heading printed above the graph
+	* Param labels is the list of column labels from the parsed table
+	* Param table is the 2D list of string data from the parsed table
+	* Param img_w is the width of the texture in pixels
+	* Param img_h is the height of the texture in pixels
+	*/
+	void renderBarGraph(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font, const string& title,
+		const vector<string>& labels, const vector<vector<string>>& table, int img_w, int img_h
+		) {
+		workspace_t ws;
+		renderBarGraph(renderer, texture, font, title, labels, table, img_w, img_h, &ws);
+	}
+
+
+	/*Renders a complete bar graph using a workspace for the graph's metadata and bars,
+	*  so that rendering a batch doesn't allocate once the workspace has warmed up
+	*
+	* Precondition: as renderBarGraph above AND ws is not nullptr
+	* Postcondition: texture and the renderer's target surface hold the finished graph
+	*
+	* Param renderer is the SDL_Renderer that will draw the graph
+	* Param texture is the SDL_Texture that the graph is drawn onto
+	* Param font is the TTF_Font used for all of the graph's text
+	* Param title is the heading printed above the graph
+	* Param labels is the list of column labels from the parsed table
+	* Param table is the 2D list of string data from the parsed table
+	* Param img_w is the width of the texture in pixels
+	* Param img_h is the height of the texture in pixels
+	* Param ws is the workspace used for the graph's intermediate data
+	*/
+	void renderBarGraph(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font, const string& title,
+		const vector<string>& labels, const vector<vector<string>>& table, int img_w, int img_h,
+		workspace_t* ws
+		) {
+		ABR_DEBUG(2, "renderBarGraph():");
+
+		//Fill the background and print the header of the graph
+		ABR_DEBUG(2, "  Filling background and print graph header");
+		util::fill(renderer, texture, util::ABR_BKGD_COLOR);
+		util::printText(
+			renderer, texture, title, util::scaled(75), util::scaled(10), util::scaled(24), 0,
+			util::ABR_GRAPH_COLOR1, font, nullptr
+		);
+
+		//Discover the filename index
+		ABR_DEBUG(2, "  Scanning for filename index");
+		internLabels(labels, &ws->labelIds);
+		size_t fileindex = 0;
+		for (size_t x = 0; x < labels.size(); x++)
+			if (ws->labelIds[x] == fileLabel()) fileindex = x;
+
+		//Store the position of the graph on the screen
+		ABR_DEBUG(2, "  Establishing graph frame position");
+		SDL_Rect framepos = {
+			util::scaled(75), util::scaled(110), img_w - util::scaled(125), img_h - util::scaled(300)
+		};
+
+		//Initialize some graph information
+		ABR_DEBUG(2, "  Initializing graph metadata");
+		graphData_t& graphInfo = ws->graphInfo;
+		graphInfo.framepos = framepos;
+		//graphInfo.fileList = { table[fileindex], 0 };
+		const vector<string>& files = table[fileindex];
+		for (size_t x = 0; x < files.size(); x++) {
+			std::pair<string, int>* entry = pooledSlot(&graphInfo.fileList, x, &ws->spareFiles);
+			entry->first.assign(files[x]);
+			entry->second = 0;
+		}
+		resizePooled(&graphInfo.fileList, files.size(), &ws->spareFiles);
+		graphInfo.vertDivisions = 10;
+		//A table read in through the workspace was converted and ranged as it was read,
+		// any other table is scanned here in a single pass
+		if (&table != &ws->table) scanTable(table, ws);
+		getDataRange(*ws, &graphInfo);
+
+		//Print the graph frame that will show behind the data
+		ABR_DEBUG(2, "  Rendering graph frame to texture");
+		printGraphFrame(renderer, texture, &graphInfo, font);
+
+		ABR_DEBUG(2, "  Generating graph bars from parsed data");
+		generateBars(graphInfo, labels, ws);
+		focusShortBars(&ws->bars);
+
+		//Print the color keys at the top of the graph frame
+		ABR_DEBUG(2, "  Rendering graph key to texture");
+		printKeys(renderer, texture, labels, graphInfo, font);
+
+		//Draw each of the bars on under the graph
+		ABR_DEBUG(2, "  Rendering graph bars to texture");
+		printBars(renderer, texture, ws->bars, font, false);
+
+		//Render the graph onto the window
+		ABR_DEBUG(2, "  Rendering texture to visual surface");
+		util::renderTexture(renderer, texture);
+
+		ABR_DEBUG(2, "  Bar graph rendered, returning...");
+		return;
+	}
+
+
+	/*Renders a list of parsed tables as bar graphs tiled in a grid on one large canvas.
+	*  Tiles are drawn concurrently, one worker thread per provided font. Full-size tiles
+	*  are rendered straight into their region of the shared canvas, while thumbnails are
+	*  drawn on the worker's own full-size frame and shrunk into place. A canvas too big
+	*  for one SDL surface is refused before any tile is drawn
+	* 
+	* Precondition: tiles is not empty AND fonts is not empty AND no two fonts are the
+	*		same TTF_Font AND 0 < tile_w <= img_w AND 0 < tile_h <= img_h
+	* Postcondition: tiles = #tiles
+	* 
+	* Param tiles is the list of parsed tables to graph, in grid order
+	* Param fonts is one TTF_Font per worker thread
+	* Param img_w is the width each graph is drawn at in pixels
+	* Param img_h is the height each graph is drawn at in pixels
+	* Param tile_w is the width of a single tile in pixels
+	* Param tile_h is the height of a single tile in pixels
+	* Param columns is the number of tiles in each row of the grid (0 picks a square-ish grid)
+	* Returns a newly allocated SDL_Surface containing the mosaic, to be freed by the caller
+	*/
+	SDL_Surface* renderMosaic(
+		const vector<mosaicTile_t>& tiles, const vector<TTF_Font*>& fonts,
+		int img_w, int img_h, int tile_w, int tile_h, int columns
+		) {
+		ABR_DEBUG(2, "renderMosaic():");
+
+		if (tiles.empty()) throw (string)"proc::renderMosaic(): No tiles provided";
+		if (fonts.empty()) throw (string)"proc::renderMosaic(): No worker fonts provided";
+
+		//Lay the tiles out in a grid, defaulting to roughly square
+		ABR_DEBUG(2, "  Calculating mosaic grid dimensions");
+		if (columns <= 0) columns = (int)std::ceil(std::sqrt((double)tiles.size()));
+		if (columns > (int)tiles.size()) columns = tiles.size();
+		size_t rows = (tiles.size() + columns - 1) / columns;
+
+		//SDL keeps a surface's size and its whole pixel buffer in ints, so a grid past
+		// that is refused now rather than after every tile has been drawn
+		size_t canvas_w = (size_t)columns * tile_w, canvas_h = rows * tile_h;
+		if (canvas_w * 4 > INT_MAX || canvas_h > INT_MAX / (canvas_w * 4))
+			throw "proc::renderMosaic(): A " + std::to_string(canvas_w) + "x" +
+				std::to_string(canvas_h) + " mosaic is too big for one image, use smaller tiles";
+
+		//Create the shared canvas with the same pixel layout generateRenderer uses
+		ABR_DEBUG(2, "  Creating " + std::to_string(canvas_w) + "x" +
+			std::to_string(canvas_h) + " mosaic canvas");
+		SDL_Surface* canvas = SDL_CreateRGBSurfaceWithFormat(
+			0, (int)canvas_w, (int)canvas_h, 32, SDL_PIXELFORMAT_RGBA32
+		);
+		if (!canvas) throw "proc::renderMosaic(): " + (string)SDL_GetError();
+		SDL_FillRect(canvas, NULL, SDL_MapRGBA(
+			canvas->format, util::ABR_BKGD_COLOR.r, util::ABR_BKGD_COLOR.g,
+			util::ABR_BKGD_COLOR.b, util::ABR_BKGD_COLOR.a
+		));
+
+		//Workers pull the next unrendered tile until the list runs out. The first
+		// error raised by any worker is kept and rethrown once they have all stopped
+		std::atomic<size_t> nextTile(0);
+		std::mutex errLock;
+		string firstErr = "";
+		bool thumbnails = tile_w != img_w || tile_h != img_h;
+
+		auto worker = [&](TTF_Font* font) {
+			//Each worker keeps one workspace for all of the tiles it draws, and thumbnails
+			// one full-size frame to draw them on before they're shrunk
+			workspace_t ws;
+			SDL_Surface* frame = nullptr;
+			SDL_Renderer* frameRenderer = nullptr;
+			SDL_Texture* frameTexture = nullptr;
+			try {
+				if (thumbnails) {
+					frame = SDL_CreateRGBSurfaceWithFormat(0, img_w, img_h, 32, SDL_PIXELFORMAT_RGBA32);
+					if (!frame) throw "proc::renderMosaic(): " + (string)SDL_GetError();
+					frameRenderer = SDL_CreateSoftwareRenderer(frame);
+					if (!frameRenderer) throw "proc::renderMosaic(): " + (string)SDL_GetError();
+					frameTexture = util::generateTexture(frameRenderer, img_w, img_h);
+				}
+			}
+			catch (const char* err) {
+				std::lock_guard<std::mutex> guard(errLock);
+				if (firstErr == "") firstErr = err;
+			}
+			catch (string err) {
+				std::lock_guard<std::mutex> guard(errLock);
+				if (firstErr == "") firstErr = err;
+			}
+
+			for (size_t t = nextTile++; t < tiles.size() && (!thumbnails || frameTexture); t = nextTile++) {
+				size_t col = t % columns, row = t / columns;
+
+				//Point a surface at this tile's region of the canvas so the worker's
+				// renderer can only ever write inside it
+				SDL_Surface* region = SDL_CreateRGBSurfaceWithFormatFrom(
+					(Uint8*)canvas->pixels + row * tile_h * (size_t)canvas->pitch + col * tile_w * 4,
+					tile_w, tile_h, 32, canvas->pitch, SDL_PIXELFORMAT_RGBA32
+				);
+				SDL_Renderer* renderer = region && !thumbnails ? SDL_CreateSoftwareRenderer(region) : nullptr;
+				SDL_Texture* texture = nullptr;
+
+				try {
+					if (!region || (!thumbnails && !renderer))
+						throw "proc::renderMosaic(): " + (string)SDL_GetError();
+					if (thumbnails) {
+						renderBarGraph(
+							frameRenderer, frameTexture, font, tiles[t].title, tiles[t].labels,
+							tiles[t].table, img_w, img_h, &ws
+						);
+						util::downscaleSurface(frame, region);
+					}
+					else {
+						texture = util::generateTexture(renderer, tile_w, tile_h);
+						renderBarGraph(
+							renderer, texture, font, tiles[t].title, tiles[t].labels,
+							tiles[t].table, tile_w, tile_h, &ws
+						);
+					}
+				}
+				catch (const char* err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = err;
+				}
+				catch (string err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = err;
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = "Unknown error occurred while rendering tile";
+				}
+
+				if (texture) SDL_DestroyTexture(texture);
+				if (renderer) util::releaseTextCache(renderer);
+				if (renderer) SDL_DestroyRenderer(renderer);
+				if (region) SDL_FreeSurface(region);
+			}
+
+			if (frameTexture) SDL_DestroyTexture(frameTexture);
+			if (frameRenderer) util::releaseTextCache(frameRenderer);
+			if (frameRenderer) SDL_DestroyRenderer(frameRenderer);
+			if (frame) SDL_FreeSurface(frame);
+		};
+
+		//Start one worker per font, never more than there are tiles
+		ABR_DEBUG(2, "  Rendering tiles on worker threads");
+		size_t workerCount = std::min(fonts.size(), tiles.size());
+		vector<std::thread> workers;
+		for (size_t x = 1; x < workerCount; x++) workers.push_back(std::thread(worker, fonts[x]));
+		worker(fonts[0]);
+		for (std::thread& th : workers) th.join();
+
+		if (firstErr != "") {
+			SDL_FreeSurface(canvas);
+			throw "proc::renderMosaic(): " + firstErr;
+		}
+
+		ABR_DEBUG(2, "  Mosaic rendered, returning...");
+		return canvas;
+	}
+
+
+	/*Draws a recorded graph onto the band canvas in horizontal bands. Bands are drawn
+	*  concurrently on the pool's workers, and each band only replays the recorded calls
+	*  that reach into it. Every worker keeps its band and renderer for the next graph,
+	*  so once the first graph of a size is drawn the text is drawn from each worker's
+	*  cache. Always call this from the same thread with the same pool, since worker 0's
+	*  text is cached on the calling thread
+	*
+	* Precondition: pool != nullptr AND bands != nullptr AND bands->fonts is not empty
+	*		AND no two of bands->fonts are the same TTF_Font AND img_w > 0 AND img_h > 0
+	* Postcondition: list = #list
+	*
+	* Param list is the display list of the graph, recorded at img_w x img_h
+	* Param pool is the worker pool drawing the bands, one worker per font at most
+	* Param bands holds one TTF_Font per worker, and is where the canvas is kept
+	* Param img_w is the width of the graph in pixels
+	* Param img_h is the height of the graph in pixels
+	* Returns the canvas containing the graph, owned by bands and overwritten by the next
+	*  graph
+	*/
+	SDL_Surface* rasterizeBands(
+		const util::displayList_t& list, util::workerPool_t* pool, bandCanvas_t* bands,
+		int img_w, int img_h
+		) {
+		ABR_DEBUG(2, "rasterizeBands():");
+		prof::scopedTimer_t timer("rasterizeBands");
+
+		if (bands->fonts.empty()) throw (string)"proc::rasterizeBands(): No worker fonts provided";
+		size_t workerCount = std::min(bands->fonts.size(), pool->threads.size() + 1);
+		bands->bands.resize(bands->fonts.size(), nullptr);
+		bands->renderers.resize(bands->fonts.size(), nullptr);
+
+		//A few bands per worker, dealt out in turn, keeps them all busy when the bands
+		// cost different amounts, since most of a graph's calls sit in the frame in the
+		// middle of the image. Each band always goes to the same worker, so text that
+		// sits in the same place on every graph is found in that worker's cache
+		int bandH = img_h / ((int)workerCount * 4);
+		if (bandH < BAND_MIN_ROWS) bandH = BAND_MIN_ROWS;
+		if (bandH > img_h) bandH = img_h;
+		int bandCount = (img_h + bandH - 1) / bandH;
+
+		//Create the canvas with the same pixel layout generateRenderer uses, keeping it
+		// while the graphs stay the same size
+		SDL_Surface*& canvas = bands->canvas;
+		if (!canvas || canvas->w != img_w || canvas->h != img_h) {
+			ABR_DEBUG(2, "  Creating " + std::to_string(img_w) + "x" + std::to_string(img_h) +
+				" canvas in " + std::to_string(bandCount) + " bands");
+			if (canvas) SDL_FreeSurface(canvas);
+			canvas = SDL_CreateRGBSurfaceWithFormat(0, img_w, img_h, 32, SDL_PIXELFORMAT_RGBA32);
+			if (!canvas) throw "proc::rasterizeBands(): " + (string)SDL_GetError();
+		}
+
+		//The first error raised by any worker is kept and rethrown once they have all
+		// stopped
+		size_t runningWorkers = std::min(workerCount, (size_t)bandCount);
+		std::mutex errLock;
+		string firstErr = "";
+
+		auto worker = [&](size_t w) {
+			SDL_Surface*& band = bands->bands[w];
+			SDL_Renderer*& renderer = bands->renderers[w];
+			try {
+				//A band of a new size needs a new renderer, whose cached text goes with
+				// the old one
+				if (!band || band->w != img_w || band->h != bandH) {
+					if (renderer) {
+						util::releaseTextCache(renderer);
+						SDL_DestroyRenderer(renderer);
+						renderer = nullptr;
+					}
+					if (band) SDL_FreeSurface(band);
+					band = SDL_CreateRGBSurfaceWithFormat(0, img_w, bandH, 32, SDL_PIXELFORMAT_RGBA32);
+					if (!band) throw "proc::rasterizeBands(): " + (string)SDL_GetError();
+					renderer = SDL_CreateSoftwareRenderer(band);
+					if (!renderer) throw "proc::rasterizeBands(): " + (string)SDL_GetError();
+				}
+
+				for (int b = (int)w; b < bandCount; b += (int)runningWorkers) {
+					int top = b * bandH;
+					int height = std::min(bandH, img_h - top);
+					util::replayBand(renderer, list, top, height, bands->fonts[w]);
+					SDL_RenderFlush(renderer);
+
+					//Copy the band's rows into their place on the canvas
+					for (int y = 0; y < height; y++)
+						memcpy(
+							(Uint8*)canvas->pixels + (size_t)(top + y) * canvas->pitch,
+							(const Uint8*)band->pixels + (size_t)y * band->pitch, (size_t)img_w * 4
+						);
+				}
+			}
+			catch (const char* err) {
+				std::lock_guard<std::mutex> guard(errLock);
+				if (firstErr == "") firstErr = err;
+			}
+			catch (string err) {
+				std::lock_guard<std::mutex> guard(errLock);
+				if (firstErr == "") firstErr = err;
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> guard(errLock);
+				if (firstErr == "") firstErr = "Unknown error occurred while drawing band";
 			}
+		};
+
+		//Never wake more workers than there are bands
+		ABR_DEBUG(2, "  Drawing bands on worker threads");
+		util::runPool(pool, runningWorkers, worker);
+		if (firstErr != "") throw "proc::rasterizeBands(): " + firstErr;
+
+		ABR_DEBUG(2, "  Graph drawn, returning...");
+		return canvas;
+	}
+
+
+	/*Releases the bands, renderers, cached text and canvas held for banded drawing. The
+	*  fonts are left to the caller
+	*
+	* Precondition: pool is the pool bands was drawn with, and is still running
+	* Postcondition: bands holds nothing but its fonts
+	*
+	* Param pool is the worker pool that drew the bands
+	* Param bands is the band canvas being released
+	*/
+	void releaseBands(util::workerPool_t* pool, bandCanvas_t* bands) {
+		ABR_DEBUG(2, "releaseBands():");
+
+		//Each renderer's text is cached on the worker that drew with it, so that's where
+		// it has to be released
+		auto worker = [&](size_t w) {
+			if (w >= bands->renderers.size()) return;
+			if (bands->renderers[w]) {
+				util::releaseTextCache(bands->renderers[w]);
+				SDL_DestroyRenderer(bands->renderers[w]);
+			}
+			if (bands->bands[w]) SDL_FreeSurface(bands->bands[w]);
+		};
+		util::runPool(pool, bands->renderers.size(), worker);
+
+		bands->renderers.clear();
+		bands->bands.clear();
+		if (bands->canvas) SDL_FreeSurface(bands->canvas);
+		bands->canvas = nullptr;
+	}
+
+
+	/*Converts a single table entry into an identity value, taking the first hit when
+	*  several are listed
+	* 
+	* Param entry is the string entry from the parsed table
+	* Returns the identity percentage of the entry's first hit, 0 if there were no hits
+	*/
+	double parseIdentity(const string& entry) {
+		if (entry == "." || entry.empty()) return 0.0;
+
+		//std::stod stops at the first character that isn't part of the number, which
+		// conveniently is the semicolon between hits
+		return std::stod(entry);
+	}
+
+
+	/*Adds the rows of a parsed table to a heatmap. Columns are matched up by label, so
+	*  tables with different databases can share a heatmap
+	* 
+	* Precondition: heatmap != nullptr AND labels and table were produced by
+	*		makeLabels/makeTable
+	* Postcondition: heatmap holds a new row for every FILE entry of the table, or a single
+	*		row named sampleName if collapse is set
+	* 
+	* Param heatmap is the heatmap being added to
+	* Param labels is the list of column labels from the parsed table
+	* Param table is the 2D list of string data from the parsed table
+	* Param collapse is whether the whole table becomes one row (the best hit per column)
+	* Param sampleName is the row label used when collapse is set
+	*/
+	void addHeatmapRows(
+		heatmap_t* heatmap, const vector<string>& labels, const vector<vector<string>>& table,
+		bool collapse, const string& sampleName
+		) {
+		ABR_DEBUG(2, "addHeatmapRows():");
+
+		//Discover the filename index
+		ABR_DEBUG(2, "  Scanning for filename index");
+		vector<util::textId_t> labelIds;
+		internLabels(labels, &labelIds);
+		size_t fileindex = 0;
+		for (size_t x = 0; x < labels.size(); x++)
+			if (labelIds[x] == fileLabel()) fileindex = x;
+
+		//Map each database column of the table onto a heatmap column, adding new ones
+		ABR_DEBUG(2, "  Matching table columns to heatmap columns");
+		vector<int> colMap(labels.size(), -1);
+		for (size_t x = 2; x < labels.size(); x++) {
+			auto found = heatmap->colIndex.find(labelIds[x]);
+			if (found == heatmap->colIndex.end()) {
+				int newCol = heatmap->colLabels.size();
+				heatmap->colIndex[labelIds[x]] = newCol;
+				heatmap->colLabels.push_back(labels[x]);
+				colMap[x] = newCol;
+			}
+			else colMap[x] = found->second;
 		}
 
-		util::debug(1, "  Bars successfully printed, returning...");
+		//A collapsed table takes up a single row, otherwise each FILE entry gets its own
+		ABR_DEBUG(2, "  Adding rows to the heatmap");
+		int firstRow = heatmap->rowLabels.size();
+		if (collapse) heatmap->rowLabels.push_back(sampleName);
+		else
+			for (const string& file : table[fileindex]) heatmap->rowLabels.push_back(file);
+
+		//Only the hits are stored, everything else is left empty
+		for (size_t x = 2; x < labels.size(); x++) {
+			//A collapsed row only keeps the best hit found in each column
+			double best = 0.0;
+			for (size_t y = 0; y < table[x].size(); y++) {
+				double value = parseIdentity(table[x][y]);
+				if (value <= 0.0) continue;
+
+				if (collapse) {
+					if (value > best) best = value;
+				}
+				else heatmap->cells.push_back({ firstRow + (int)y, colMap[x], (float)value });
+			}
+			if (collapse && best > 0.0)
+				heatmap->cells.push_back({ firstRow, colMap[x], (float)best });
+		}
+
+		ABR_DEBUG(2, "  Rows added, returning...");
+		return;
+	}
+
+
+	/*Renders a heatmap of identity values, with samples as rows and databases as columns
+	* 
+	* Precondition: renderer != nullptr AND texture != nullptr AND font != nullptr AND
+	*		texture is img_w x img_h
+	* Postcondition: texture and the renderer's target surface hold the finished heatmap
+	* 
+	* Param renderer is the SDL_Renderer that will draw the heatmap
+	* Param texture is the SDL_Texture that the heatmap is drawn onto
+	* Param font is the TTF_Font used for all of the heatmap's text
+	* Param title is the heading printed above the heatmap
+	* Param heatmap is the populated heatmap data
+	* Param img_w is the width of the texture in pixels
+	* Param img_h is the height of the texture in pixels
+	*/
+	void renderHeatmap(
+		SDL_Renderer* renderer, SDL_Texture* texture, TTF_Font* font, const string& title,
+		const heatmap_t& heatmap, int img_w, int img_h
+		) {
+		ABR_DEBUG(2, "renderHeatmap():");
+
+		int rows = heatmap.rowLabels.size(), cols = heatmap.colLabels.size();
+		if (rows == 0 || cols == 0) throw (string)"proc::renderHeatmap(): Heatmap has no data to render";
+
+		//Fill the background and print the header of the heatmap
+		ABR_DEBUG(2, "  Filling background and printing heatmap header");
+		util::fill(renderer, texture, util::ABR_BKGD_COLOR);
+		util::printText(
+			renderer, texture, title, util::scaled(75), util::scaled(10), util::scaled(24), 0,
+			util::ABR_GRAPH_COLOR1, font, nullptr
+		);
+
+		//Row labels are only worth printing if they get enough room to be legible
+		ABR_DEBUG(2, "  Establishing heatmap frame position");
+		const int labelSize = util::scaled(14);
+		int frameTop = util::scaled(170), frameBottom = util::scaled(50);
+		bool rowText = (img_h - frameTop - frameBottom) / rows >= labelSize;
+		int frameLeft = rowText ? util::scaled(300) : util::scaled(75);
+		SDL_Rect framepos = {
+			frameLeft, frameTop, img_w - frameLeft - util::scaled(50), img_h - frameTop - frameBottom
+		};
+		bool colText = framepos.w / cols >= labelSize;
+
+		//Find the spread of identity values so the colors use the full ramp
+		ABR_DEBUG(2, "  Finding the range of identity values");
+		float lo = 100.0f, hi = 0.0f;
+		for (const heatCell_t& cell : heatmap.cells) {
+			if (cell.value < lo) lo = cell.value;
+			if (cell.value > hi) hi = cell.value;
+		}
+		if (heatmap.cells.empty()) { lo = 0.0f; hi = 100.0f; }
+		if (hi - lo < 1.0f) lo = (hi > 1.0f ? hi - 1.0f : 0.0f);
+
+		//Build the color lookup table. Entry 0 is for cells with no hits, entries 1 through
+		// 1001 cover 0.0% through 100.0% identity in tenths of a percent, packed in the
+		// visualizer's RGBA8888 format so a cell's color is a single table read
+		ABR_DEBUG(2, "  Building identity color lookup table");
+		const util::color_t ramp[3] = {
+			util::ABR_GRAPH_COLOR2, util::ABR_BAR_COLORS[8], util::ABR_BAR_COLORS[1]
+		};
+		Uint32 lut[1002];
+		lut[0] = ((Uint32)util::ABR_BKGD_COLOR.r << 24) | ((Uint32)util::ABR_BKGD_COLOR.g << 16) |
+			((Uint32)util::ABR_BKGD_COLOR.b << 8) | 0xFF;
+		for (int q = 0; q <= 1000; q++) {
+			double t = (q / 10.0 - lo) / (hi - lo);
+			if (t < 0.0) t = 0.0;
+			if (t > 1.0) t = 1.0;
+			int seg = t < 0.5 ? 0 : 1;
+			double f = t < 0.5 ? t * 2.0 : (t - 0.5) * 2.0;
+			Uint32 r = ramp[seg].r + (ramp[seg + 1].r - ramp[seg].r) * f;
+			Uint32 g = ramp[seg].g + (ramp[seg + 1].g - ramp[seg].g) * f;
+			Uint32 b = ramp[seg].b + (ramp[seg + 1].b - ramp[seg].b) * f;
+			lut[q + 1] = (r << 24) | (g << 16) | (b << 8) | 0xFF;
+		}
+
+		//Reduce the rows down to at most one per pixel, keeping the best hit of each
+		// bucket so that a single hit in a huge cohort still shows up
+		ABR_DEBUG(2, "  Reducing heatmap cells to frame resolution");
+		int buckets = rows < framepos.h ? rows : framepos.h;
+		vector<Uint16> grid(buckets * cols, 0);
+		for (const heatCell_t& cell : heatmap.cells) {
+			int b = (int)((long long)cell.row * buckets / rows);
+			Uint16 q = 1 + (Uint16)(cell.value * 10.0f + 0.5f);
+			if (q > 1001) q = 1001;
+			Uint16& slot = grid[b * cols + cell.col];
+			if (q > slot) slot = q;
+		}
+
+		//Work out which bucket and column every pixel falls in ahead of time, so the
+		// raster loop below is nothing but table lookups
+		ABR_DEBUG(2, "  Rasterizing heatmap cells");
+		vector<int> colOfPx(framepos.w);
+		for (int px = 0; px < framepos.w; px++)
+			colOfPx[px] = (int)((long long)px * cols / framepos.w);
+
+		vector<Uint32> pixels(framepos.w * framepos.h);
+		for (int py = 0; py < framepos.h; py++) {
+			const Uint16* gridRow = &grid[((long long)py * buckets / framepos.h) * cols];
+			Uint32* pxRow = &pixels[py * framepos.w];
+			for (int px = 0; px < framepos.w; px++) pxRow[px] = lut[gridRow[colOfPx[px]]];
+		}
+
+		//Copy the finished cells into the frame in one go
+		ABR_DEBUG(2, "  Copying heatmap cells onto the texture");
+		SDL_Texture* cellTexture = SDL_CreateTexture(
+			renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING,
+			framepos.w, framepos.h
+		);
+		if (!cellTexture) throw "proc::renderHeatmap(): " + (string)SDL_GetError();
+		SDL_UpdateTexture(cellTexture, NULL, pixels.data(), framepos.w * sizeof(Uint32));
+		SDL_SetRenderTarget(renderer, texture);
+		int res = SDL_RenderCopy(renderer, cellTexture, NULL, &framepos);
+		SDL_SetRenderTarget(renderer, NULL);
+		SDL_DestroyTexture(cellTexture);
+		if (res != 0) throw "proc::renderHeatmap(): " + (string)SDL_GetError();
+
+		//Print the sample names down the left side when there is room for them
+		if (rowText) {
+			ABR_DEBUG(2, "  Printing row labels");
+			for (int y = 0; y < rows; y++) {
+				int rowTop = framepos.y + (int)((long long)y * framepos.h / rows);
+				int rowH = (int)((long long)(y + 1) * framepos.h / rows) + framepos.y - rowTop;
+				util::printText(
+					renderer, texture, heatmap.rowLabels[y], util::scaled(20),
+					rowTop + (rowH - labelSize) / 2, labelSize, 0,
+					util::ABR_GRAPH_COLOR1, font, nullptr
+				);
+			}
+		}
+
+		//Print the database names slanted above their columns when there is room
+		if (colText) {
+			ABR_DEBUG(2, "  Printing column labels");
+			for (int x = 0; x < cols; x++) {
+				int colLeft = framepos.x + (int)((long long)x * framepos.w / cols);
+				int colW = (int)((long long)(x + 1) * framepos.w / cols) + framepos.x - colLeft;
+				util::printText(
+					renderer, texture, heatmap.colLabels[x], colLeft + colW / 2 - util::scaled(5),
+					framepos.y - labelSize - util::scaled(4), labelSize, -40,
+					util::ABR_GRAPH_COLOR1, font, nullptr
+				);
+			}
+		}
+
+		//Outline the heatmap
+		ABR_DEBUG(2, "  Drawing heatmap border");
+		SDL_Point border[5] = {
+			{ framepos.x - 1, framepos.y - 1 },
+			{ framepos.x + framepos.w, framepos.y - 1 },
+			{ framepos.x + framepos.w, framepos.y + framepos.h },
+			{ framepos.x - 1, framepos.y + framepos.h },
+			{ framepos.x - 1, framepos.y - 1 }
+		};
+		util::drawPolygon(renderer, texture, { border, 5 }, util::ABR_GRAPH_COLOR1);
+
+		//Draw the color legend next to the title, from the lowest identity to the highest
+		ABR_DEBUG(2, "  Drawing color legend");
+		const int legendW = util::scaled(200), legendH = util::scaled(12);
+		int legendX = img_w - legendW - util::scaled(120), legendY = util::scaled(20);
+		for (int x = 0; x < legendW; x++) {
+			int q = (int)((lo + (hi - lo) * x / (legendW - 1)) * 10.0f + 0.5f);
+			Uint32 c = lut[q + 1];
+			util::color_t clr = {
+				(uint16_t)(c >> 24), (uint16_t)((c >> 16) & 0xFF), (uint16_t)((c >> 8) & 0xFF), 255
+			};
+			util::fillRect(renderer, texture, { legendX + x, legendY, 1, legendH }, clr);
+		}
+		string loLabel = std::to_string(lo), hiLabel = std::to_string(hi);
+		loLabel = loLabel.substr(0, loLabel.length() - 4) + "%";
+		hiLabel = hiLabel.substr(0, hiLabel.length() - 4) + "%";
+		util::printText(
+			renderer, texture, loLabel, legendX, legendY + legendH + util::scaled(4), labelSize, 0,
+			util::ABR_GRAPH_COLOR1, font, nullptr
+		);
+		util::printText(
+			renderer, texture, hiLabel, legendX + legendW - util::scaled(5 * (int)hiLabel.length()),
+			legendY + legendH + util::scaled(4), labelSize, 0, util::ABR_GRAPH_COLOR1, font, nullptr
+		);
+
+		//Render the heatmap onto the window
+		ABR_DEBUG(2, "  Rendering texture to visual surface");
+		util::renderTexture(renderer, texture);
+
+		ABR_DEBUG(2, "  Heatmap rendered, returning...");
 		return;
 	}
 
@@ -5,6 +5,45 @@
 #include <utility>
 #include <SDL_Image.h>
 #include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//zlib and libzstd are used whenever their headers are found, unless turned off with
+// ABR_NO_ZLIB or ABR_NO_ZSTD
+#if defined(__has_include) && !defined(ABR_HAVE_ZLIB) && !defined(ABR_NO_ZLIB)
+#if __has_include(<zlib.h>)
+#define ABR_HAVE_ZLIB
+#endif
+#endif
+#if defined(__has_include) && !defined(ABR_HAVE_ZSTD) && !defined(ABR_NO_ZSTD)
+#if __has_include(<zstd.h>)
+#define ABR_HAVE_ZSTD
+#endif
+#endif
+
+#ifdef ABR_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ABR_HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "../filectrl.h"
 #include "../utils.h"
@@ -13,31 +52,326 @@
 namespace filectrl {
 	using std::ifstream; using std::string; using std::ios;
 
-	/*Takes in a directory and filename, and opens an input stream to read data
-	*  from the file.
-	* 
+	/*Works out whether a file is compressed, and how, from its extension
+	*
+	* Param filename is the name of the file
+	* Returns COMPRESSION_GZIP for .gz, COMPRESSION_ZSTD for .zst and COMPRESSION_NONE OW
+	*/
+	static int compressionOf(const string& filename) {
+		size_t length = filename.length();
+		if (length > 3 && filename.compare(length - 3, 3, ".gz") == 0) return COMPRESSION_GZIP;
+		if (length > 4 && filename.compare(length - 4, 4, ".zst") == 0) return COMPRESSION_ZSTD;
+		return COMPRESSION_NONE;
+	}
+
+
+	/*Decompresses the next stretch of an inflater's file, reading more of the file
+	*  whenever the codec has used up what it was given. Gzip files made of several
+	*  members and zstd files made of several frames are read straight through
+	*
+	* Precondition: buf was opened by openInflate
+	*
+	* Param buf is the inflater being read from
+	* Param out is where the decompressed text is written
+	* Param capacity is the most bytes written to out
+	* Returns the number of bytes written, which is only 0 once the whole file is done
+	*/
+	static size_t inflateBlock(inflateBuf_t* buf, char* out, size_t capacity) {
+		size_t written = 0;
+		while (written < capacity) {
+			//Top up the compressed input once the codec has used all of it
+			if (buf->inputPos == buf->inputEnd && !buf->sourceDone) {
+				buf->inputPos = 0;
+				buf->inputEnd = (size_t)buf->src->sgetn(buf->input.data(), buf->input.size());
+				if (buf->inputEnd == 0) buf->sourceDone = true;
+			}
+
+			size_t before = written, beforePos = buf->inputPos;
+			if (buf->format == COMPRESSION_GZIP) {
+#ifdef ABR_HAVE_ZLIB
+				z_stream* zs = (z_stream*)buf->gzipState;
+				zs->next_in = (Bytef*)buf->input.data() + buf->inputPos;
+				zs->avail_in = (uInt)(buf->inputEnd - buf->inputPos);
+				zs->next_out = (Bytef*)out + written;
+				zs->avail_out = (uInt)(capacity - written);
+				int ret = inflate(zs, Z_NO_FLUSH);
+				buf->inputPos = buf->inputEnd - zs->avail_in;
+				written = capacity - zs->avail_out;
+
+				//Another member may follow the one that just ended
+				if (ret == Z_STREAM_END) {
+					inflateReset(zs);
+					buf->frameOpen = false;
+				}
+				else if (ret == Z_OK) buf->frameOpen = true;
+				else if (ret != Z_BUF_ERROR)
+					throw (string)"filectrl::loadFile(): Corrupt gzip data (" + (zs->msg ? zs->msg : "unknown error") + ")";
+#endif
+			}
+			else if (buf->format == COMPRESSION_ZSTD) {
+#ifdef ABR_HAVE_ZSTD
+				ZSTD_inBuffer in = { buf->input.data() + buf->inputPos, buf->inputEnd - buf->inputPos, 0 };
+				ZSTD_outBuffer outBuf = { out + written, capacity - written, 0 };
+				size_t ret = ZSTD_decompressStream((ZSTD_DStream*)buf->zstdState, &outBuf, &in);
+				if (ZSTD_isError(ret))
+					throw (string)"filectrl::loadFile(): Corrupt zstd data (" + ZSTD_getErrorName(ret) + ")";
+				buf->inputPos += in.pos;
+				written += outBuf.pos;
+				//With nothing to read, zstd asks for the next frame's header even at the end
+				if (in.pos > 0 || outBuf.pos > 0) buf->frameOpen = ret != 0;
+#endif
+			}
+
+			//Once the file is used up and the codec has nothing left, the text is done
+			if (written == before && buf->inputPos == beforePos) {
+				if (!buf->sourceDone)
+					throw (string)"filectrl::loadFile(): Compressed data stopped decoding partway";
+				if (buf->frameOpen)
+					throw (string)"filectrl::loadFile(): Compressed file ends partway through its data";
+				break;
+			}
+		}
+		return written;
+	}
+
+
+	/*Runs on an inflater's helper thread, decompressing blocks ahead of the parser
+	*  until the file is done, the parser is INFLATE_BLOCKS blocks behind, or the file
+	*  is closed. An error is kept for the parser to throw when it reaches it
+	*
+	* Param buf is the inflater being filled
+	*/
+	static void inflateAhead(inflateBuf_t* buf) {
+		string err = "";
+		try {
+			while (true) {
+				//Only blocks the parser has let go of are written over
+				size_t slot;
+				{
+					std::unique_lock<std::mutex> guard(buf->lock);
+					buf->changed.wait(guard, [&]() {
+						return buf->stopping || buf->produced - buf->consumed < INFLATE_BLOCKS;
+					});
+					if (buf->stopping) return;
+					slot = buf->produced % INFLATE_BLOCKS;
+				}
+
+				size_t size = inflateBlock(buf, buf->blocks[slot].data(), buf->blocks[slot].size());
+				{
+					std::lock_guard<std::mutex> guard(buf->lock);
+					if (size == 0) buf->finished = true;
+					else {
+						buf->blockSizes[slot] = size;
+						buf->produced++;
+					}
+				}
+				buf->changed.notify_all();
+				if (size == 0) return;
+			}
+		}
+		catch (const char* e) { err = e; }
+		catch (string e) { err = e; }
+		catch (...) { err = "filectrl::loadFile(): Unknown error decompressing file"; }
+
+		{
+			std::lock_guard<std::mutex> guard(buf->lock);
+			buf->error = err;
+			buf->finished = true;
+		}
+		buf->changed.notify_all();
+	}
+
+
+	/*Stops an inflater's helper thread, if it has one, and leaves it reading nothing
+	*
+	* Param buf is the inflater being closed
+	*/
+	static void closeInflate(inflateBuf_t* buf) {
+		if (buf->helper.joinable()) {
+			{
+				std::lock_guard<std::mutex> guard(buf->lock);
+				buf->stopping = true;
+			}
+			buf->changed.notify_all();
+			buf->helper.join();
+		}
+		buf->src = nullptr;
+		buf->discard();
+	}
+
+
+	/*Points an inflater at a compressed file, keeping its codecs and buffers from the
+	*  last file it read
+	*
+	* Precondition: src is open at the start of the compressed data
+	*
+	* Param buf is the inflater being opened
+	* Param src is the compressed file
+	* Param format is COMPRESSION_GZIP or COMPRESSION_ZSTD
+	* Param threaded is whether the file is decompressed on a helper thread
+	*/
+	static void openInflate(inflateBuf_t* buf, std::streambuf* src, int format, bool threaded) {
+		closeInflate(buf);
+
+		//Ready the codec, which is only made for the first file that needs it
+		if (format == COMPRESSION_GZIP) {
+#ifdef ABR_HAVE_ZLIB
+			if (buf->gzipState == nullptr) {
+				z_stream* zs = new z_stream();
+				//Adding 32 to the window bits has zlib take gzip and zlib headers alike
+				if (inflateInit2(zs, 15 + 32) != Z_OK) {
+					delete zs;
+					throw (string)"filectrl::loadFile(): Unable to start gzip decompression";
+				}
+				buf->gzipState = zs;
+			}
+			else inflateReset((z_stream*)buf->gzipState);
+#else
+			throw (string)"filectrl::loadFile(): AbrPrint was built without gzip support (zlib)";
+#endif
+		}
+		else if (format == COMPRESSION_ZSTD) {
+#ifdef ABR_HAVE_ZSTD
+			if (buf->zstdState == nullptr) {
+				buf->zstdState = ZSTD_createDStream();
+				if (buf->zstdState == nullptr)
+					throw (string)"filectrl::loadFile(): Unable to start zstd decompression";
+			}
+			ZSTD_initDStream((ZSTD_DStream*)buf->zstdState);
+#else
+			throw (string)"filectrl::loadFile(): AbrPrint was built without zstd support (libzstd)";
+#endif
+		}
+
+		buf->src = src;
+		buf->format = format;
+		buf->input.resize(INFLATE_BLOCK_SIZE);
+		buf->inputPos = buf->inputEnd = 0;
+		buf->sourceDone = buf->frameOpen = false;
+
+		buf->threaded = threaded;
+		for (size_t x = 0; x < (threaded ? INFLATE_BLOCKS : 1); x++)
+			buf->blocks[x].resize(INFLATE_BLOCK_SIZE);
+		buf->produced = buf->consumed = 0;
+		buf->holding = buf->finished = buf->stopping = false;
+		buf->error.clear();
+		if (threaded) buf->helper = std::thread(inflateAhead, buf);
+	}
+
+
+	/*Hands the parser the next block of decompressed text, waiting on the helper thread
+	*  for it when there is one
+	*
+	* Returns the first character of the block, or EOF once the file is done
+	*/
+	inflateBuf_t::int_type inflateBuf_t::underflow() {
+		if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+		if (src == nullptr) return traits_type::eof();
+
+		if (!threaded) {
+			size_t size = inflateBlock(this, blocks[0].data(), blocks[0].size());
+			if (size == 0) return traits_type::eof();
+			setg(blocks[0].data(), blocks[0].data(), blocks[0].data() + size);
+			return traits_type::to_int_type(*gptr());
+		}
+
+		//Give the block just read back to the helper thread, then wait for the next
+		std::unique_lock<std::mutex> guard(lock);
+		if (holding) {
+			consumed++;
+			holding = false;
+			changed.notify_all();
+		}
+		changed.wait(guard, [&]() { return produced > consumed || finished; });
+		if (produced == consumed) {
+			if (error != "") throw error;
+			return traits_type::eof();
+		}
+
+		size_t slot = consumed % INFLATE_BLOCKS;
+		holding = true;
+		setg(blocks[slot].data(), blocks[slot].data(), blocks[slot].data() + blockSizes[slot]);
+		return traits_type::to_int_type(*gptr());
+	}
+
+
+	inflateBuf_t::~inflateBuf_t() {
+		closeInflate(this);
+#ifdef ABR_HAVE_ZLIB
+		if (gzipState != nullptr) {
+			inflateEnd((z_stream*)gzipState);
+			delete (z_stream*)gzipState;
+		}
+#endif
+#ifdef ABR_HAVE_ZSTD
+		if (zstdState != nullptr) ZSTD_freeDStream((ZSTD_DStream*)zstdState);
+#endif
+	}
+
+
+	/*Opens a file for reading through a reader that is reused from file to file. The
+	*  reader keeps its path and read buffer between files, so reopening it doesn't
+	*  allocate once it has seen the longest path of a batch. Files ending in .gz or
+	*  .zst are decompressed as they're read, on a helper thread when they're large.
+	*  A file that turns out to be corrupt throws from the read that reaches the damage
+	*
+	* Precondition: reader != nullptr
+	* Postcondition: reader->in is open on the file, any file it had open is closed
+	*
 	* Param directory is the directory that the file is found in. Can be absolute
 	*  or relative to the executable
 	* Param filename is the name of the file within the directory to open
-	* 
-	* Return a filestream object that allows the system to read data from the file
+	* Param reader is the reader being pointed at the file
 	*/
-	ifstream filectrl::loadFile(string directory, string filename) {
-		util::debug(1, "loadFile():");
+	void loadFile(const string& directory, const string& filename, reader_t* reader) {
+		ABR_DEBUG(2, "loadFile():");
+		prof::scopedTimer_t timer("loadFile");
+
+		//Build the path in the reader's own string
+		ABR_DEBUG(2, "  Attempting to open file for reading");
+		reader->path.assign(directory).append(filename);
+
+		//Hand the file the reader's buffer before opening, otherwise it allocates a
+		// fresh one on every open. Compressed files are read as the bytes they hold
+		closeFile(reader);
+		if (reader->readBuffer.empty()) reader->readBuffer.resize(1 << 16);
+		reader->file.pubsetbuf(reader->readBuffer.data(), reader->readBuffer.size());
+		int format = compressionOf(filename);
+		reader->file.open(reader->path, format == COMPRESSION_NONE ? ios::in : ios::in | ios::binary);
 
-		//Gat the file path from the input data
-		util::debug(1, "  Attempting to open file for reading");
-		std::string fullPath = directory + filename;
-		//Attempt to open an input stream from the file
-		std::ifstream src;
-		src.open(fullPath);
+		//Ensure that the file was properly opened
+		if (!reader->file.is_open())
+			throw "filectr::loadFile(): Error opening file " + reader->path;
 
-		//Ensure that the input stream was properly opened
-		if (!src.is_open())
-			throw "filectr::loadFile(): Error opening file " + fullPath;
+		//Decoding errors are thrown from inside the stream, so let them through to the
+		// parser rather than having them look like the end of the file
+		if (format == COMPRESSION_NONE) reader->in.rdbuf(&reader->file);
+		else {
+			ABR_DEBUG(2, "  File is compressed, reading it through the inflater");
+			std::error_code err;
+			uintmax_t size = std::filesystem::file_size(reader->path, err);
+			bool threaded = !err && size >= INFLATE_THREAD_MIN_BYTES;
+			openInflate(&reader->inflater, &reader->file, format, threaded);
+			reader->in.rdbuf(&reader->inflater);
+		}
+		reader->in.exceptions(ios::badbit);
 
-		util::debug(1, "  File stream successfully opened, returning...");
-		return src;
+		ABR_DEBUG(2, "  File stream successfully opened, returning...");
+		return;
+	}
+
+
+	/*Closes the file a reader has open, stopping its helper thread if it has one
+	*
+	* Precondition: reader != nullptr
+	* Postcondition: reader has no file open
+	*
+	* Param reader is the reader being closed
+	*/
+	void closeFile(reader_t* reader) {
+		closeInflate(&reader->inflater);
+		if (reader->file.is_open()) reader->file.close();
+		reader->in.clear();
 	}
 
 
@@ -55,108 +389,789 @@ namespace filectrl {
 	* Returns a vector of strings containing the filenames present in the
 	*  provided location
 	*/
-	std::vector<std::string> gatherFilenames(std::string loc, std::string* directory) {
-		util::debug(1, "gatherFilenames():");
+	std::vector<std::string> gatherFilenames(const std::string& loc, std::string* directory) {
+		ABR_DEBUG(2, "gatherFilenames():");
 
 		//Create a vector to store the list of filenames
 		std::vector<std::string> filenames;
 
+		//If the input is being streamed in, there is only the one nameless file on STDIN
+		if (util::stream) {
+			ABR_DEBUG(2, "  Streaming input provided, reading from STDIN");
+			filenames.push_back("stdin");
+			*directory = "";
+		}
 		//If the input was specified as a raw batch generation, parse through the
 		// filenames here
-		if (util::raw && util::batch) {
-			util::debug(1, "  Raw path batch job provided");
+		else if (util::raw && util::batch) {
+			ABR_DEBUG(2, "  Raw path batch job provided");
 
 			//The absolute path was passed in, so set the path directly to it
 			std::string path = loc;
-			util::debug(1, "  Parsing through entries in " + path);
+			ABR_DEBUG(2, "  Parsing through entries in " + path);
 
 			//Iterate through each file in the path,
 			for (const auto& entry : std::filesystem::directory_iterator(path)) {
 				//Convert the path to a string
 				std::string currname = entry.path().string();
-				util::debug(1, "    Detected file " + currname + ", extracting filename");
+				ABR_DEBUG(3, "    Detected file " + currname + ", extracting filename");
 
 				//Move backward until the point where the name ends
 				int x; for (x = currname.size() - 1; x >= 0; x--)
 					if (currname[x] == '/') break;
 
+				//Caches and stores can sit beside the summaries, but aren't summaries themselves
+				if (isCacheFile(currname)) {
+					ABR_DEBUG(3, "    File is a summary cache or store, skipping");
+					continue;
+				}
+
 				//Push the parsed filename onto the list
-				util::debug(1, "    Filename found to be " + currname.substr(x + 1, currname.size()));
+				ABR_DEBUG(3, "    Filename found to be " + currname.substr(x + 1, currname.size()));
 				filenames.push_back(currname.substr(x + 1, currname.size()));
 			}
 
-			util::debug(1, "  Storing the directory path in the passed-in location");
+			ABR_DEBUG(2, "  Storing the directory path in the passed-in location");
 			*directory = path;
 
 		}
 		//If the input was a raw path, extract just the filename from it
 		else if (util::raw) {
-			util::debug(1, "  Single file raw path provided, extracting file name from path");
+			ABR_DEBUG(2, "  Single file raw path provided, extracting file name from path");
 
 			//Move backward until the point where the name ends
 			int x; for (x = loc.size() - 1; x >= 0; x--)
 				if (loc[x] == '/') break;
 			//Push the parsed filename onto the list
 			filenames.push_back(loc.substr(x + 1, loc.size()));
-			util::debug(1, "  Filename found to be " + loc.substr(x + 1, loc.size()));
+			ABR_DEBUG(2, "  Filename found to be " + loc.substr(x + 1, loc.size()));
 
-			util::debug(1, "  Storing the directory path in the passed-in location");
+			ABR_DEBUG(2, "  Storing the directory path in the passed-in location");
 			*directory = loc.substr(0, x+1);
 
 		}
 		//If the input was a batch path, extract the file names using the default path
 		else if (util::batch) {
-			util::debug(1, "  Batch job provided");
+			ABR_DEBUG(2, "  Batch job provided");
 
 			//Find the path with any potential extra directories
 			std::string path = util::ABR_INPUT_DIR + loc;
-			util::debug(1, "  Parsing through entries in " + path);
+			ABR_DEBUG(2, "  Parsing through entries in " + path);
 
 			//Iterate through each file in the path
 			for (const auto& entry : std::filesystem::directory_iterator(path)) {
 				//Convert the current path name into a string
 				std::string currname = entry.path().string();
-				util::debug(1, "    Detected file " + currname + ", extracting filename");
+				ABR_DEBUG(3, "    Detected file " + currname + ", extracting filename");
 
 				//Move backward until the point where the name ends
 				int x; for (x = currname.size() - 1; x >= 0; x--)
 					if (currname[x] == '/') break;
 
+				//Caches and stores can sit beside the summaries, but aren't summaries themselves
+				if (isCacheFile(currname)) {
+					ABR_DEBUG(3, "    File is a summary cache or store, skipping");
+					continue;
+				}
+
 				//Push the parsed filename onto the list
-				util::debug(1, "    Filename found to be " + currname.substr(x + 1, currname.size()));
+				ABR_DEBUG(3, "    Filename found to be " + currname.substr(x + 1, currname.size()));
 				filenames.push_back(currname.substr(x + 1, currname.size()));
 			}
 
-			util::debug(1, "  Storing the directory path in the passed-in location");
+			ABR_DEBUG(2, "  Storing the directory path in the passed-in location");
 			*directory = path;
 		}
 		else if (!util::flagsUsed) {
-			util::debug(1, "  Single file location provided");
+			ABR_DEBUG(2, "  Single file location provided");
 
 			std::string path = util::ABR_INPUT_DIR + loc;
-			util::debug(1, "  Extracting file from " + path);
+			ABR_DEBUG(2, "  Extracting file from " + path);
 
 			//Move backward until the point where the name ends
 			int x; for (x = path.size() - 1; x >= 0; x--)
 				if (path[x] == '/') break;
 			//Push the parsed filename onto the list
 			filenames.push_back(path.substr(x + 1, path.size()));
-			util::debug(1, "  Filename found to be " + path.substr(x + 1, loc.size()));
+			ABR_DEBUG(2, "  Filename found to be " + path.substr(x + 1, loc.size()));
 
-			util::debug(1, "  Storing the directory path in the passed-in location");
+			ABR_DEBUG(2, "  Storing the directory path in the passed-in location");
 			*directory = path.substr(0, x + 1);
 		}
 		else {
-			util::debug(1, "  Only configuration flags provided, returning...");
+			ABR_DEBUG(2, "  Only configuration flags provided, returning...");
 			throw "ABR_PLEASE_EXIT";
 		}
 
 		//Return the parsed list of filenames
-		util::debug(1, "  File names extracted, returning...");
+		ABR_DEBUG(2, "  File names extracted, returning...");
 		return filenames;
 	}
 
 
+	/*SDL_RWops write callback that appends the written bytes onto the byte vector
+	*  stored in the stream's first user data pointer
+	*/
+	static size_t bufferWrite(SDL_RWops* context, const void* ptr, size_t size, size_t num) {
+		std::vector<unsigned char>* buffer =
+			(std::vector<unsigned char>*)context->hidden.unknown.data1;
+		const unsigned char* bytes = (const unsigned char*)ptr;
+		buffer->insert(buffer->end(), bytes, bytes + size * num);
+		return num;
+	}
+
+
+	/*SDL_RWops seek callback for the byte vector stream. The encoders only ever ask
+	*  where the end of the written data is, so that is all this reports
+	*/
+	static Sint64 bufferSeek(SDL_RWops* context, Sint64 offset, int whence) {
+		std::vector<unsigned char>* buffer =
+			(std::vector<unsigned char>*)context->hidden.unknown.data1;
+		if (whence == RW_SEEK_SET && offset == (Sint64)buffer->size()) return offset;
+		if (offset != 0) return -1;
+		return (Sint64)buffer->size();
+	}
+
+
+	/*SDL_RWops size callback for the byte vector stream*/
+	static Sint64 bufferSize(SDL_RWops* context) {
+		return (Sint64)((std::vector<unsigned char>*)context->hidden.unknown.data1)->size();
+	}
+
+
+	/*SDL_RWops close callback for the byte vector stream, the vector itself is owned
+	*  by the caller so only the stream is released
+	*/
+	static int bufferClose(SDL_RWops* context) {
+		SDL_FreeRW(context);
+		return 0;
+	}
+
+
+	/*Maps a whole file into memory read-only, so it can be read in place without
+	*  copying it into a buffer first
+	*
+	* Precondition: map != nullptr AND map is not already mapped
+	* Postcondition: map->data points at the file's contents until unmapFile is called
+	*
+	* Param path is the path of the file being mapped
+	* Param map is populated with the location and size of the mapping
+	* Returns false if the file doesn't exist, can't be read or is empty, true OW
+	*/
+	bool mapFile(const std::string& path, mappedFile_t* map) {
+		ABR_DEBUG(2, "mapFile():");
+
+		//The mapping keeps the file open by itself, so the handles can be closed as soon
+		// as it is made
+#ifdef _WIN32
+		HANDLE file = CreateFileA(
+			path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL, NULL
+		);
+		if (file == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			CloseHandle(file);
+			return false;
+		}
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (mapping == NULL) return false;
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (data == NULL) return false;
+		map->size = (size_t)size.QuadPart;
+#else
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat info;
+		if (fstat(fd, &info) != 0 || info.st_size == 0) {
+			close(fd);
+			return false;
+		}
+		void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (data == MAP_FAILED) return false;
+		map->size = (size_t)info.st_size;
+#endif
+		map->data = (const unsigned char*)data;
+
+		ABR_DEBUG(2, "  Mapped " + std::to_string(map->size) + " bytes of " + path);
+		return true;
+	}
+
+
+	/*Releases a file mapped by mapFile
+	*
+	* Postcondition: map->data == nullptr AND map->size == 0
+	*
+	* Param map is the mapping being released
+	*/
+	void unmapFile(mappedFile_t* map) {
+		if (map->data == nullptr) return;
+#ifdef _WIN32
+		UnmapViewOfFile(map->data);
+#else
+		munmap((void*)map->data, map->size);
+#endif
+		map->data = nullptr;
+		map->size = 0;
+	}
+
+
+	/*Splits the name of a raw ABRicate output into the sample and the database it was
+	*  run against, from a name like SAMPLE_database_out.tab. Names without an _out or
+	*  .tab ending are split the same way at their last underscore
+	*
+	* Param filename is the name of the output, without its path
+	* Param sample is populated with the name of the sample
+	* Param database is populated with the name of the database
+	* Returns true IFF the name ends in _out.tab, like ABRicate outputs usually do
+	*/
+	bool splitOutputName(const string& filename, string* sample, string* database) {
+		auto endsWith = [&](size_t end, const char* suffix) {
+			size_t n = strlen(suffix);
+			return end >= n && filename.compare(end - n, n, suffix) == 0;
+		};
+
+		//Compressed outputs are named for what they hold once decompressed
+		size_t end = filename.length();
+		if (compressionOf(filename) == COMPRESSION_GZIP) end -= 3;
+		else if (compressionOf(filename) == COMPRESSION_ZSTD) end -= 4;
+		bool tab = endsWith(end, ".tab");
+		if (tab) end -= 4;
+		bool out = endsWith(end, "_out");
+		if (out) end -= 4;
+
+		//Whatever follows the last underscore is the database
+		size_t split = end > 0 ? filename.rfind('_', end - 1) : string::npos;
+		if (split == string::npos || split == 0 || split + 1 >= end) {
+			sample->assign(filename, 0, end);
+			database->assign(filename, 0, end);
+		}
+		else {
+			sample->assign(filename, 0, split);
+			database->assign(filename, split + 1, end - split - 1);
+		}
+
+		return tab && out;
+	}
+
+
+	/*Groups a list of raw ABRicate outputs by the sample each was run on, so all of a
+	*  sample's outputs can be read into one summary. Files not named like an output
+	*  (SAMPLE_database_out.tab) are left out
+	*
+	* Param filenames is the list of file names, without their paths
+	* Param groups is populated with each sample's outputs, replacing whatever it held
+	*/
+	void groupOutputs(const std::vector<string>& filenames, outputGroups_t* groups) {
+		ABR_DEBUG(2, "groupOutputs():");
+
+		groups->clear();
+		string sample, database;
+		for (const string& filename : filenames) {
+			if (!splitOutputName(filename, &sample, &database)) {
+				ABR_DEBUG(3, "    " + filename + " is not named like an ABRicate output, skipping");
+				continue;
+			}
+			(*groups)[sample].push_back(filename);
+		}
+
+		//abricate --summary lists its inputs in the order the shell globbed them
+		for (auto& group : *groups) std::sort(group.second.begin(), group.second.end());
+
+		ABR_DEBUG(2, "  Found " + std::to_string(groups->size()) + " samples, returning...");
+		return;
+	}
+
+
+	/*Checks whether a file is one of AbrPrint's parsed summary caches or cohort stores,
+	*  which can sit beside the summaries but are never graphed as summaries themselves
+	*
+	* Param filename is the name of the file
+	* Returns true IFF the file is a cache or store file, or a partly written one
+	*/
+	bool isCacheFile(const std::string& filename) {
+		auto endsWith = [&](const char* suffix) {
+			size_t n = strlen(suffix);
+			return filename.length() >= n && filename.compare(filename.length() - n, n, suffix) == 0;
+		};
+		return endsWith(".abrc") || endsWith(".abrc.tmp") ||
+			endsWith(".abrs") || endsWith(".abrs.tmp");
+	}
+
+
+	/*Encodes a surface as a QOI (Quite OK Image) file, following the format's spec. Each
+	*  pixel is written as a repeat of the last one, a match from a 64 entry table of
+	*  recent colors, a small difference from the last pixel, or the color in full. Flat
+	*  charts are mostly runs and table hits, so this is many times faster than PNG's
+	*  deflate while coming out close in size. The buffer is sized for the worst case up
+	*  front and trimmed afterwards, so nothing is appended byte by byte
+	*
+	* Precondition: surface is a 32 bit ARGB8888 surface
+	*
+	* Param surface is the surface being encoded
+	* Param encoded is the buffer receiving the complete QOI file
+	*/
+	static void encodeQOI(SDL_Surface* surface, std::vector<unsigned char>* encoded) {
+		const uint32_t width = (uint32_t)surface->w, height = (uint32_t)surface->h;
+		encoded->resize(14 + (size_t)width * height * 5 + 8);
+		unsigned char* out = encoded->data();
+
+		//The header holds the magic, the size (big-endian), RGBA channels and sRGB colors
+		const unsigned char header[14] = {
+			'q', 'o', 'i', 'f',
+			(unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+			(unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+			4, 0
+		};
+		memcpy(out, header, sizeof(header));
+		out += sizeof(header);
+
+		//Pixels are compared as ARGB words, and split into channels only when written out
+		Uint32 seen[64] = {};
+		Uint32 prev = 0xFF000000;
+		int run = 0;
+		for (uint32_t y = 0; y < height; y++) {
+			const Uint32* row = (const Uint32*)((const Uint8*)surface->pixels + (size_t)y * surface->pitch);
+			for (uint32_t x = 0; x < width; x++) {
+				Uint32 px = row[x];
+				if (px == prev) {
+					if (++run == 62) {
+						*out++ = (unsigned char)(0xC0 | (run - 1));
+						run = 0;
+					}
+					continue;
+				}
+				if (run > 0) {
+					*out++ = (unsigned char)(0xC0 | (run - 1));
+					run = 0;
+				}
+
+				int a = px >> 24, r = (px >> 16) & 0xFF, g = (px >> 8) & 0xFF, b = px & 0xFF;
+				int slot = (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+				if (seen[slot] == px) *out++ = (unsigned char)slot;
+				else {
+					seen[slot] = px;
+					if ((px >> 24) != (prev >> 24)) {
+						const unsigned char rgba[5] = {
+							0xFF, (unsigned char)r, (unsigned char)g, (unsigned char)b, (unsigned char)a
+						};
+						memcpy(out, rgba, 5);
+						out += 5;
+					}
+					else {
+						//Differences wrap around like the decoder's 8 bit channels do
+						int dr = (signed char)(r - ((prev >> 16) & 0xFF));
+						int dg = (signed char)(g - ((prev >> 8) & 0xFF));
+						int db = (signed char)(b - (prev & 0xFF));
+						int drg = dr - dg, dbg = db - dg;
+						if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+							*out++ = (unsigned char)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+						else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+							*out++ = (unsigned char)(0x80 | (dg + 32));
+							*out++ = (unsigned char)((drg + 8) << 4 | (dbg + 8));
+						}
+						else {
+							const unsigned char rgb[4] = { 0xFE, (unsigned char)r, (unsigned char)g, (unsigned char)b };
+							memcpy(out, rgb, 4);
+							out += 4;
+						}
+					}
+				}
+				prev = px;
+			}
+		}
+		if (run > 0) *out++ = (unsigned char)(0xC0 | (run - 1));
+
+		//The stream ends with seven zero bytes and a one
+		const unsigned char ending[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+		memcpy(out, ending, sizeof(ending));
+		out += sizeof(ending);
+		encoded->resize(out - encoded->data());
+	}
+
+
+	/*Encodes a surface into an in-memory image buffer
+	*
+	* Param surface is the SDL_Surface holding the finished image
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	*
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> encodeSurface(SDL_Surface* surface, const std::string& fileType) {
+		std::vector<unsigned char> buffer;
+		encodeSurface(surface, fileType, &buffer);
+		return buffer;
+	}
+
+
+	/*Encodes a surface into a caller-owned image buffer, replacing its contents but
+	*  keeping its capacity so a buffer reused across a batch stops allocating
+	*
+	* Param surface is the SDL_Surface holding the finished image
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param encoded is the buffer receiving the complete encoded image file
+	*/
+	void encodeSurface(
+		SDL_Surface* surface, const std::string& fileType, std::vector<unsigned char>* encoded
+		) {
+		encodeSurface(surface, fileType, DEFAULT_JPEG_QUALITY, encoded);
+	}
+
+
+	/*Encodes a surface into a caller-owned image buffer at a given JPEG quality
+	*
+	* Param surface is the SDL_Surface holding the finished image
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param quality is the JPEG quality from 1 to 100, which other formats ignore
+	* Param encoded is the buffer receiving the complete encoded image file
+	*/
+	void encodeSurface(
+		SDL_Surface* surface, const std::string& fileType, int quality,
+		std::vector<unsigned char>* encoded
+		) {
+		ABR_DEBUG(2, "encodeSurface():");
+		prof::scopedTimer_t timer("encodeSurface");
+
+		//Build a write-only stream that collects the encoder's output in memory
+		ABR_DEBUG(2, "  Creating in-memory output stream");
+		encoded->clear();
+		SDL_RWops* out = SDL_AllocRW();
+		if (!out) throw "encodeSurface(): " + (std::string)SDL_GetError();
+		out->size = bufferSize;
+		out->seek = bufferSeek;
+		out->read = NULL;
+		out->write = bufferWrite;
+		out->close = bufferClose;
+		out->hidden.unknown.data1 = encoded;
+
+		//Encode the surface in the requested format
+		ABR_DEBUG(2, "  Encoding surface");
+		int res = 0;
+		if (fileType == "PNG") {
+			ABR_DEBUG(3, "    Image extension is PNG, encoding as PNG");
+			res = IMG_SavePNG_RW(surface, out, 1);
+		}
+		else if (fileType == "JPEG") {
+			ABR_DEBUG(3, "    Image extension is JPEG, encoding as JPEG");
+			res = IMG_SaveJPG_RW(surface, out, 1, quality);
+		}
+		else if (fileType == "QOI") {
+			//QOI is written straight into the buffer, from ARGB8888 pixels
+			ABR_DEBUG(3, "    Image extension is QOI, encoding as QOI");
+			SDL_RWclose(out);
+			if (surface->format->format == SDL_PIXELFORMAT_ARGB8888) encodeQOI(surface, encoded);
+			else {
+				SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+				if (!converted) throw "encodeSurface(): " + (std::string)SDL_GetError();
+				encodeQOI(converted, encoded);
+				SDL_FreeSurface(converted);
+			}
+		}
+		else {
+			SDL_RWclose(out);
+			throw "encodeSurface(): Unrecognized file extension detected, failed to encode";
+		}
+
+		if (res < 0) throw "encodeSurface(): Failed to encode image as " + fileType;
+
+		ABR_DEBUG(2, "  Surface successfully encoded, returning...");
+		return;
+	}
+
+
+	/*Encodes a generated graph into an in-memory image buffer
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param graph is the graph texture being encoded
+	*
+	* Returns a byte vector holding the complete encoded image file
+	*/
+	std::vector<unsigned char> encodeGraph(
+		SDL_Renderer* renderer, const std::string& fileType, SDL_Texture* graph
+		) {
+		std::vector<unsigned char> encoded;
+		encodeGraph(renderer, fileType, graph, &encoded);
+		return encoded;
+	}
+
+
+	//This struct holds the surface a thread reads its graphs back into, freeing it when
+	// the thread finishes
+	struct readback_t {
+		SDL_Surface* surface = nullptr;
+		~readback_t() { if (surface) SDL_FreeSurface(surface); }
+	};
+
+
+	/*Reads a generated graph back into a surface kept by the calling thread, so only
+	*  the first graph of each size pays for creating it
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param graph is the graph texture being read
+	* Returns the surface holding the graph, which stays valid until the calling thread
+	*  reads another graph back or finishes
+	*/
+	SDL_Surface* readGraph(SDL_Renderer* renderer, SDL_Texture* graph) {
+		ABR_DEBUG(2, "readGraph():");
+
+		//Store encoding data about the passed-in graph texture
+		ABR_DEBUG(2, "  Gathering graph metadata");
+		Uint32 format; int width, height;
+		SDL_QueryTexture(graph, &format, NULL, &width, &height);
+
+		//Reuse the thread's readback surface, replacing it only when the graph's size or
+		// pixel format changes
+		ABR_DEBUG(2, "  Fetching render surface for the graph metadata");
+		static thread_local readback_t readback;
+		SDL_Surface*& surface = readback.surface;
+		if (!surface || surface->w != width || surface->h != height ||
+			surface->format->format != format) {
+			ABR_DEBUG(3, "    Creating new render surface");
+			if (surface) SDL_FreeSurface(surface);
+			surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, format);
+			if (!surface) throw "readGraph(): " + (std::string)SDL_GetError();
+		}
+
+		//Clone the texture onto the surface
+		ABR_DEBUG(2, "  Copying graph to render surface");
+		if (SDL_SetRenderTarget(renderer, graph) < 0)
+			throw "readGraph(): Failed to direct renderer to graph output texture";
+		if (SDL_RenderReadPixels(renderer, NULL, format, surface->pixels, surface->pitch) < 0)
+			throw "readGraph(): Failed to copy graph data to render surface";
+		SDL_SetRenderTarget(renderer, NULL);
+
+		ABR_DEBUG(2, "  Graph successfully read back, returning...");
+		return surface;
+	}
+
+
+	/*Encodes a generated graph into a caller-owned image buffer. The pixels are read
+	*  back into a surface kept by the calling thread, so only the first graph of each
+	*  size pays for creating it
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param graph is the graph texture being encoded
+	* Param encoded is the buffer receiving the complete encoded image file
+	*/
+	void encodeGraph(
+		SDL_Renderer* renderer, const std::string& fileType, SDL_Texture* graph,
+		std::vector<unsigned char>* encoded
+		) {
+		ABR_DEBUG(2, "encodeGraph():");
+		prof::scopedTimer_t timer("encodeGraph");
+
+		//Encode the copied pixels
+		encodeSurface(readGraph(renderer, graph), fileType, encoded);
+
+		ABR_DEBUG(2, "  Graph successfully encoded, returning...");
+		return;
+	}
+
+
+	/*Encodes one finished graph into every output target. Targets smaller than the
+	*  graph are shrunk from it first, and each target is shrunk and encoded on a worker
+	*  of its own, the calling thread included. The workers are the pool's, which stay
+	*  up from graph to graph, so no threads are started per graph. The first error raised by any of them is
+	*  rethrown once they have all stopped
+	*
+	* Precondition: frame is a 32 bit surface AND every target fits inside it
+	* Postcondition: encoded holds one encoded image per target, in the same order
+	*
+	* Param frame is the finished graph, which is only read
+	* Param targets is the list of images being made
+	* Param encoded is resized to one buffer per target, keeping their capacity
+	* Param workers is the worker pool the targets are encoded on
+	*/
+	void encodeTargets(
+		SDL_Surface* frame, const std::vector<util::outputTarget_t>& targets,
+		std::vector<std::vector<unsigned char>>* encoded, util::workerPool_t* workers
+		) {
+		ABR_DEBUG(2, "encodeTargets():");
+		prof::scopedTimer_t timer("encodeTargets");
+
+		//SDL_image loads its codecs the first time they're used, which isn't safe to do
+		// from several threads at once
+		static std::once_flag codecsLoaded;
+		std::call_once(codecsLoaded, []() { IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG); });
+
+		//The shrunk copies are kept by the calling thread, one for each target. A deque
+		// never moves its entries as it grows, so none of them is freed twice. The workers
+		// reach them through a reference, since naming the thread_local on a worker would
+		// find that worker's own, empty copy
+		static thread_local std::deque<readback_t> callerShrunk;
+		std::deque<readback_t>& shrunk = callerShrunk;
+		if (shrunk.size() < targets.size()) shrunk.resize(targets.size());
+		encoded->resize(targets.size());
+
+		std::atomic<size_t> nextTarget(0);
+		std::mutex errLock;
+		string firstErr = "";
+		auto worker = [&](size_t) {
+			for (size_t t = nextTarget++; t < targets.size(); t = nextTarget++) {
+				const util::outputTarget_t& target = targets[t];
+				try {
+					SDL_Surface* image = frame;
+					if (target.width > 0 && (target.width != frame->w || target.height != frame->h)) {
+						SDL_Surface*& surface = shrunk[t].surface;
+						if (!surface || surface->w != target.width || surface->h != target.height ||
+							surface->format->format != frame->format->format) {
+							if (surface) SDL_FreeSurface(surface);
+							surface = SDL_CreateRGBSurfaceWithFormat(
+								0, target.width, target.height, 32, frame->format->format
+							);
+							if (!surface) throw "encodeTargets(): " + (std::string)SDL_GetError();
+						}
+						util::downscaleSurface(frame, surface);
+						image = surface;
+					}
+					encodeSurface(image, target.type, target.quality, &(*encoded)[t]);
+				}
+				catch (const char* err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = err;
+				}
+				catch (string err) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = err;
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> guard(errLock);
+					if (firstErr == "") firstErr = "encodeTargets(): Unknown error encoding " + target.type;
+				}
+			}
+		};
+
+		util::runPool(workers, targets.size(), worker);
+		if (firstErr != "") throw firstErr;
+
+		ABR_DEBUG(2, "  Targets successfully encoded, returning...");
+		return;
+	}
+
+
+	/*Builds the graph type an output target is named with, which gains the target's
+	*  size when it's shrunk from the graph
+	*
+	* Param target is the output target
+	* Param graphType is the kind of graph being made
+	* Returns the graph type to name the target's image with, e.g. bargraph_300x200
+	*/
+	std::string targetGraphType(const util::outputTarget_t& target, const std::string& graphType) {
+		if (target.width == 0) return graphType;
+		return graphType + "_" + std::to_string(target.width) + "x" + std::to_string(target.height);
+	}
+
+
+	/*Appends the name of an output image onto a string, without building any
+	*  temporary strings along the way
+	*
+	* Param out is the string the name is appended to
+	* Param sourceName is the name of the file that produced the graph
+	* Param fileType is the extension of the file
+	* Param graphType is the kind of graph being made
+	*/
+	static void appendGraphFileName(
+		std::string* out, const std::string& sourceName, const std::string& fileType,
+		const std::string& graphType
+		) {
+		//Exclude the original extension from the file name
+		size_t x; for (x = 0; x < sourceName.length(); x++)
+			if (sourceName[x] == '.') break;
+		out->append(sourceName, 0, x);
+
+		//Add the graph type and file extension to the end of the filename
+		out->append("_").append(graphType).append(".");
+		for (char c : fileType) *out += std::tolower(c);
+	}
+
+
+	/*Builds the name of an output image from the file that produced it
+	*
+	* Param sourceName is the name of the file that produced the graph
+	* Param fileType is the extension of the file
+	* Param graphType is the kind of graph being made
+	*
+	* Returns the output name, e.g. test123_bargraph.png for test123.tab
+	*/
+	std::string graphFileName(
+		const std::string& sourceName, const std::string& fileType, const std::string& graphType
+		) {
+		ABR_DEBUG(2, "graphFileName():");
+
+		//Trim the original extension and append the graph type and file extension
+		ABR_DEBUG(2, "  Building file name from the source name");
+		std::string filename;
+		appendGraphFileName(&filename, sourceName, fileType, graphType);
+		ABR_DEBUG(3, "    Resulting name: " + filename);
+
+		return filename;
+	}
+
+
+	/*Writes an already encoded image into the output directory, naming it after
+	*  the file that produced it
+	*
+	* Param encoded is the encoded image file being written
+	* Param sourceName is the name of the file that produced the image
+	* Param fileType is the extension of the file
+	* Param directory is the directory that the file is being written to
+	* Param graphType is the kind of graph being made
+	*/
+	void saveEncodedToFile(
+		const std::vector<unsigned char>& encoded, const std::string& sourceName,
+		const std::string& fileType, const std::string& directory, const std::string& graphType
+		) {
+		ABR_DEBUG(2, "saveEncodedToFile():");
+		prof::scopedTimer_t timer("saveEncodedToFile");
+
+		//The path, the last directory checked and the stream buffer are kept per thread
+		// so that saving a batch doesn't allocate for every graph
+		static thread_local std::string fullpath;
+		static thread_local std::string checkedDirectory;
+		static thread_local char writeBuffer[1 << 13];
+
+		//Create the full path to the file using the directory and name
+		ABR_DEBUG(2, "  Appending filename to the output directory");
+		fullpath.assign(directory);
+		appendGraphFileName(&fullpath, sourceName, fileType, graphType);
+		ABR_DEBUG(3, "    Resulting path: " + fullpath);
+
+		//Check whether the directory being saved to exists, once per directory
+		if (directory != checkedDirectory) {
+			ABR_DEBUG(2, "  Checking whether output path exists");
+			std::filesystem::path outdir = directory;
+			bool exists = std::filesystem::is_directory(outdir);
+
+			//If the output directory does not already exist, attempt to instantiate it
+			if (!exists) {
+				ABR_DEBUG(3, "    Output path does not exist, instantiating output path");
+				if (!std::filesystem::create_directory(outdir))
+					throw "filectrl::saveEncodedToFile(): Failed to create output directory";
+			}
+			checkedDirectory.assign(directory);
+		}
+
+		//Write the encoded image out to the file
+		ABR_DEBUG(2, "  Beginning to save image to file");
+		std::ofstream out;
+		out.rdbuf()->pubsetbuf(writeBuffer, sizeof(writeBuffer));
+		out.open(fullpath, ios::out | ios::binary);
+		if (!out.is_open())
+			throw "saveEncodedToFile(): Failed to save image as " + fullpath;
+		out.write((const char*)encoded.data(), encoded.size());
+		if (!out) throw "saveEncodedToFile(): Failed to save image as " + fullpath;
+		out.close();
+
+		ABR_DEBUG(2, "  Image successfully saved to file, returning...");
+		return;
+	}
+
+
 	/*Saves a generated graph to a file
 	* 
 	* Param renderer is the SDL_Renderer that will render the graph onto it
@@ -168,74 +1183,218 @@ namespace filectrl {
 	* Param graph is the actual graph being written to the file
 	*/
 	void saveGraphToFile(
-		SDL_Renderer* renderer, std::string sourceName, std::string fileType,
-		std::string directory, std::string graphType, SDL_Texture* graph
+		SDL_Renderer* renderer, const std::string& sourceName, const std::string& fileType,
+		const std::string& directory, const std::string& graphType, SDL_Texture* graph
 		) {
-		util::debug(1, "saveGraphToFile():");
+		ABR_DEBUG(2, "saveGraphToFile():");
 
-		//Exclude the original extension from the file name
-		util::debug(1, "  Trimming the original extension from the source name");
-		int x; for (x = 0; x < sourceName.length(); x++)
-			if (sourceName[x] == '.') break;
-		std::string filename = sourceName.substr(0, x);
-		util::debug(1, "    Resulting name: " + filename);
-
-		//Add the graph type to the end of the filename
-		util::debug(1, "  Appending graph type and file extension to filename");
-		filename += "_" + graphType + ".";
-		//Add the file extension to the end of the filename
-		for (char c : util::ABR_OUTPUT_EXT) filename += std::tolower(c);
-		util::debug(1, "    Resulting name: " + filename);
-		
-		//Create the full path to the file using the directory and name
-		util::debug(1, "  Appending filename to the output directory");
-		std::string fullpath = util::ABR_OUTPUT_DIR + filename;
-		util::debug(1, "    Resulting path: " + fullpath);
-		
-		//Check whether the directory being saved to exists
-		util::debug(1, "  Checking whether output path exists");
-		std::filesystem::path outdir = util::ABR_OUTPUT_DIR;
-		bool exists = std::filesystem::is_directory(outdir);
-
-		//If the output directory does not already exist, attempt to instantiate it
-		if (!exists) {
-			util::debug(1, "    Output path does not exist, instantiating output path");
-			if (!std::filesystem::create_directory(outdir))
-				throw "filectrl::saveGraphToFile(): Failed to create output directory";
-		}
+		//Encode the graph into the thread's buffer, then hand it off to be written
+		ABR_DEBUG(2, "  Encoding graph for output");
+		static thread_local std::vector<unsigned char> encoded;
+		encodeGraph(renderer, fileType, graph, &encoded);
+		saveEncodedToFile(encoded, sourceName, fileType, directory, graphType);
 
-		//Store encoding data about the passed-in graph texture
-		util::debug(1, "  Gathering graph metadata");
-		Uint32 format; int width, height;
-		SDL_QueryTexture(graph, &format, NULL, &width, &height);
+		ABR_DEBUG(2, "  Grpah successfully saved to file, returning...");
+		return;
+	}
 
-		//Create an SDL Surface to store the data
-		util::debug(1, "  Creating render surface from graph metadata");
-		SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, format);
 
-		//Clone the texture onto the surface
-		util::debug(1, "  Copying graph to render surface");
-		if (SDL_SetRenderTarget(renderer, graph) < 0)
-			throw "saveGraphToFile(): Failed to direct renderer to graph output texture";
-		if (SDL_RenderReadPixels(renderer, NULL, format, surface->pixels, surface->pitch) < 0)
-			throw "saveGraphToFile(): Failed to copy graph data to render surface";
+	/*Writes a generated graph to STDOUT as an encoded image, for use at the end
+	*  of a shell pipeline
+	*
+	* Param renderer is the SDL_Renderer that the graph texture is attached to
+	* Param fileType is the image format to encode (one of util::supportedTypes)
+	* Param graph is the graph texture being written
+	*/
+	void writeGraphToStdout(
+		SDL_Renderer* renderer, const std::string& fileType, SDL_Texture* graph
+		) {
+		ABR_DEBUG(2, "writeGraphToStdout():");
+		prof::scopedTimer_t timer("writeGraphToStdout");
 
-		//Write the surface to the proper file type
-		util::debug(1, "  Beginning to save graph to file");
-		if (util::ABR_OUTPUT_EXT == "PNG") {
-			util::debug(1, "    Image extension is PNG, saving as PNG");
-			if (IMG_SavePNG(surface, fullpath.c_str()) < 0)
-				throw "saveGraphToFile(): Failed to save image as " + fullpath;
-		}
-		else if (util::ABR_OUTPUT_EXT == "JPEG") {
-			util::debug(1, "    Image extension is JPEG, saving as JPEG");
-			if (IMG_SaveJPG(surface, fullpath.c_str(), 50) < 0)
-				throw "saveGraphToFile(): Failed to save image as " + fullpath;
-		}
-		else
-			throw "saveGraphToFile(): Unrecognized file extension detected, failed to save";
+		//Encode the graph in memory
+		ABR_DEBUG(2, "  Encoding graph for output");
+		std::vector<unsigned char> encoded = encodeGraph(renderer, fileType, graph);
+
+		writeEncodedToStdout(encoded);
+		return;
+	}
+
+
+	/*Writes an already encoded image to STDOUT, for use at the end of a shell pipeline
+	*
+	* Param encoded is the encoded image file being written
+	*/
+	void writeEncodedToStdout(const std::vector<unsigned char>& encoded) {
+		ABR_DEBUG(2, "writeEncodedToStdout():");
+
+		//Windows would otherwise translate newline bytes in the image data
+#ifdef _WIN32
+		ABR_DEBUG(2, "  Switching STDOUT to binary mode");
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+		//Write through C stdio, std::cout is redirected to STDERR while streaming
+		ABR_DEBUG(2, "  Writing encoded graph to STDOUT");
+		if (fwrite(encoded.data(), 1, encoded.size(), stdout) != encoded.size())
+			throw "writeEncodedToStdout(): Failed to write graph to STDOUT";
+		fflush(stdout);
+
+		ABR_DEBUG(2, "  Graph successfully written, returning...");
+		return;
+	}
+
+
+	/*Writes a single 512 byte ustar header for a regular file member
+	*
+	* Param out is the stream the header is written to
+	* Param name is the name of the member
+	* Param size is the size of the member's data in bytes
+	*/
+	static void writeTarHeader(std::ofstream& out, const std::string& name, uint64_t size) {
+		char header[512];
+		memset(header, 0, sizeof(header));
+
+		//Fill in the fields, numbers are zero-padded octal strings
+		memcpy(header, name.c_str(), name.length());
+		snprintf(header + 100, 8, "%07o", 0644);
+		snprintf(header + 108, 8, "%07o", 0);
+		snprintf(header + 116, 8, "%07o", 0);
+		snprintf(header + 124, 12, "%011llo", (unsigned long long)size);
+		snprintf(header + 136, 12, "%011llo", (unsigned long long)time(NULL));
+		header[156] = '0';
+		memcpy(header + 257, "ustar", 6);
+		memcpy(header + 263, "00", 2);
+
+		//The checksum is taken with its own field filled with spaces
+		memset(header + 148, ' ', 8);
+		unsigned int checksum = 0;
+		for (int x = 0; x < 512; x++) checksum += (unsigned char)header[x];
+		snprintf(header + 148, 8, "%06o", checksum);
+		header[155] = ' ';
+
+		out.write(header, sizeof(header));
+	}
+
+
+	/*Pads the archive out to the next 512 byte tar block boundary
+	*
+	* Param out is the stream being padded
+	* Param size is the size of the data that was just written
+	* Returns the number of padding bytes written
+	*/
+	static uint64_t padTarBlock(std::ofstream& out, uint64_t size) {
+		static const char zeros[512] = { 0 };
+		uint64_t padding = (512 - size % 512) % 512;
+		out.write(zeros, padding);
+		return padding;
+	}
+
+
+	/*Opens a tar archive that a batch of encoded graphs will be streamed into
+	*
+	* Precondition: archive != nullptr
+	* Postcondition: archive is open for appending, with an empty index
+	*
+	* Param archive is the archive being opened
+	* Param path is the location of the archive file, which will be overwritten
+	*/
+	void openArchive(archive_t* archive, const std::string& path) {
+		ABR_DEBUG(2, "openArchive():");
+
+		//Give the stream a large buffer so graphs go out in big sequential writes
+		ABR_DEBUG(2, "  Opening archive file " + path);
+		archive->writeBuffer.resize(1 << 20);
+		archive->out.rdbuf()->pubsetbuf(archive->writeBuffer.data(), archive->writeBuffer.size());
+		archive->out.open(path, ios::out | ios::binary | ios::trunc);
+		if (!archive->out.is_open())
+			throw "filectrl::openArchive(): Error opening archive " + path;
+
+		archive->path = path;
+		archive->offset = 0;
+		archive->index.clear();
+
+		ABR_DEBUG(2, "  Archive opened, returning...");
+		return;
+	}
+
+
+	/*Appends an encoded graph to an open archive as a new tar member, and notes
+	*  where its data landed in the archive's index
+	*
+	* Precondition: archive was opened by openArchive AND name is under 100 characters
+	*
+	* Param archive is the archive being written to
+	* Param name is the name of the member inside the archive
+	* Param data is the encoded image being stored
+	*/
+	void appendToArchive(
+		archive_t* archive, const std::string& name, const std::vector<unsigned char>& data
+		) {
+		ABR_DEBUG(2, "appendToArchive():");
+		prof::scopedTimer_t timer("appendToArchive");
+
+		if (name.length() >= 100)
+			throw "filectrl::appendToArchive(): Name too long for archive member " + name;
+
+		//Write the member header, then the data right behind it
+		ABR_DEBUG(2, "  Writing " + name + " to the archive");
+		writeTarHeader(archive->out, name, data.size());
+		archive->offset += 512;
+		archive->index.push_back({ name, archive->offset, (uint64_t)data.size() });
+
+		archive->out.write((const char*)data.data(), data.size());
+		archive->offset += data.size();
+		archive->offset += padTarBlock(archive->out, data.size());
+
+		if (!archive->out)
+			throw "filectrl::appendToArchive(): Error writing to archive " + archive->path;
+
+		ABR_DEBUG(2, "  Member written, returning...");
+		return;
+	}
+
+
+	/*Finishes an archive. The offset table is written both as a final index.tsv member
+	*  of the tar and as a sidecar file (the archive's path with .idx appended) so
+	*  readers can seek straight to any graph without walking the tar headers
+	*
+	* Precondition: archive was opened by openArchive
+	* Postcondition: archive is closed and both copies of the index are written
+	*
+	* Param archive is the archive being closed
+	*/
+	void closeArchive(archive_t* archive) {
+		ABR_DEBUG(2, "closeArchive():");
+
+		//Lay the index out as name, data offset and size, one member per line
+		ABR_DEBUG(2, "  Compiling archive index");
+		std::string index = "#NAME\tOFFSET\tSIZE\n";
+		for (const archiveEntry_t& entry : archive->index)
+			index += entry.name + "\t" + std::to_string(entry.offset) + "\t" +
+				std::to_string(entry.size) + "\n";
+
+		//Store the index as the last member, then close the tar with two empty blocks
+		ABR_DEBUG(2, "  Writing index member and end of archive marker");
+		writeTarHeader(archive->out, "index.tsv", index.size());
+		archive->out.write(index.c_str(), index.size());
+		padTarBlock(archive->out, index.size());
+		static const char zeros[1024] = { 0 };
+		archive->out.write(zeros, sizeof(zeros));
+
+		archive->out.close();
+		if (!archive->out)
+			throw "filectrl::closeArchive(): Error finishing archive " + archive->path;
+
+		//Write the same index next to the archive
+		ABR_DEBUG(2, "  Writing sidecar index");
+		std::ofstream sidecar(archive->path + ".idx", ios::out | ios::binary | ios::trunc);
+		if (!sidecar.is_open())
+			throw "filectrl::closeArchive(): Error writing index " + archive->path + ".idx";
+		sidecar << index;
+		sidecar.close();
 
-		util::debug(1, "  Grpah successfully saved to file, returning...");
+		ABR_DEBUG(2, "  Archive closed, returning...");
 		return;
 	}
 
@@ -0,0 +1,365 @@
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../profiler.h"
+
+
+namespace prof {
+	bool enabled = false;
+	bool memory = false;
+	bool tracing = false;
+	thread_local uint64_t threadAllocs = 0;
+	thread_local uint64_t threadBytes = 0;
+
+	//This struct holds everything recorded against a single stage
+	struct stageStats_t {
+		std::vector<double> samples;
+		uint64_t allocs, bytes;
+	};
+
+	//This struct holds everything recorded against a single input file
+	struct fileStats_t {
+		std::string file;
+		double ms;
+		uint64_t allocs, bytes;
+	};
+
+	//This struct holds a single complete span for the trace export
+	struct traceEvent_t {
+		std::string name;
+		const char* category;
+		double start, duration;
+		int thread;
+	};
+
+	//Samples for each stage, kept in the order the stages were first seen
+	static std::vector<std::string> stageNames;
+	static std::vector<stageStats_t> stageStats;
+	static std::vector<fileStats_t> fileStats;
+	static std::vector<traceEvent_t> traceEvents;
+	static std::mutex stageLock;
+
+	//Span times are measured from when the program started
+	static const std::chrono::steady_clock::time_point traceEpoch =
+		std::chrono::steady_clock::now();
+
+	//Threads are numbered in the order they first record a span, the main thread first
+	static std::atomic<int> threadCount(0);
+	static thread_local int threadId = -1;
+
+
+	//This struct keeps the profiler's own bookkeeping out of the allocation totals. It
+	// notes the thread's counts when made and puts them back when it goes out of scope,
+	// so whatever is pushed or copied in between isn't charged to an enclosing scope
+	struct uncounted_t {
+		uint64_t allocs = threadAllocs, bytes = threadBytes;
+		~uncounted_t() { threadAllocs = allocs; threadBytes = bytes; }
+	};
+
+
+	//The trace category of each timed stage. Anything not listed is its own category
+	static const char* stageCategories[][2] = {
+		{ "loadFile", "parse" }, { "makeLabels", "parse" }, { "makeTable", "parse" },
+		{ "getDataRange", "layout" }, { "generateBars", "layout" }, { "focusShortBars", "layout" },
+		{ "printGraphFrame", "frame" }, { "renderTexture", "frame" },
+		{ "printKeys", "text" }, { "printText", "text" },
+		{ "printBars", "bars" },
+		{ "encodeSurface", "encode" }, { "encodeGraph", "encode" },
+		{ "saveEncodedToFile", "write" }, { "saveGraphToFile", "write" },
+		{ "appendToArchive", "write" }, { "writeGraphToStdout", "write" }
+	};
+
+
+	/*Finds the trace category of a stage
+	*
+	* Param stage is the name of the stage
+	* Returns the category the stage belongs to
+	*/
+	static const char* categoryOf(const char* stage) {
+		for (const auto& entry : stageCategories)
+			if (std::strcmp(entry[0], stage) == 0) return entry[1];
+		return stage;
+	}
+
+
+	/*Keeps a finished scope as a span for the trace export
+	*
+	* Param name is the name of the span
+	* Param category is the category the span is grouped under
+	* Param start is when the scope began
+	* Param end is when the scope finished
+	*/
+	static void traceSpan(
+		const std::string& name, const char* category,
+		std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end
+		) {
+		uncounted_t uncounted;
+		if (threadId < 0) threadId = threadCount++;
+		std::chrono::duration<double, std::micro> offset = start - traceEpoch;
+		std::chrono::duration<double, std::micro> duration = end - start;
+
+		std::lock_guard<std::mutex> guard(stageLock);
+		traceEvents.push_back({ name, category, offset.count(), duration.count(), threadId });
+	}
+
+
+	/*Escapes a string for use inside a JSON string literal. Control characters are
+	*  dropped, since they have no business in a file or stage name
+	*
+	* Param text is the string being escaped
+	* Returns the escaped string
+	*/
+	static std::string escapeJson(const std::string& text) {
+		std::string escaped;
+		for (char c : text) {
+			if (c == '"' || c == '\\') escaped += '\\';
+			if ((unsigned char)c >= 0x20) escaped += c;
+		}
+		return escaped;
+	}
+
+
+	scopedTimer_t::scopedTimer_t(const char* stageName) : stage(stageName) {
+		if (!enabled) return;
+		startAllocs = threadAllocs;
+		startBytes = threadBytes;
+		start = std::chrono::steady_clock::now();
+	}
+
+
+	scopedTimer_t::~scopedTimer_t() {
+		if (!enabled) return;
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		std::chrono::duration<double, std::milli> elapsed = end - start;
+		record(stage, elapsed.count(), threadAllocs - startAllocs, threadBytes - startBytes);
+		if (tracing) traceSpan(stage, categoryOf(stage), start, end);
+	}
+
+
+	fileScope_t::fileScope_t(const std::string& fileName) {
+		if (!enabled) return;
+		{
+			uncounted_t uncounted;
+			file = fileName;
+		}
+		startAllocs = threadAllocs;
+		startBytes = threadBytes;
+		start = std::chrono::steady_clock::now();
+	}
+
+
+	fileScope_t::~fileScope_t() {
+		if (!enabled) return;
+		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+		std::chrono::duration<double, std::milli> elapsed = end - start;
+		uint64_t allocs = threadAllocs - startAllocs, bytes = threadBytes - startBytes;
+
+		if (tracing) traceSpan(file, "file", start, end);
+		uncounted_t uncounted;
+		std::lock_guard<std::mutex> guard(stageLock);
+		fileStats.push_back({ file, elapsed.count(), allocs, bytes });
+	}
+
+
+	/*Reads the running totals of heap allocations made by the calling thread. Every
+	*  call to the global operator new is counted, whether or not profiling is enabled
+	*
+	* Param allocs is populated with the number of allocations made
+	* Param bytes is populated with the number of bytes requested
+	*/
+	void threadAllocations(uint64_t* allocs, uint64_t* bytes) {
+		*allocs = threadAllocs;
+		*bytes = threadBytes;
+	}
+
+
+	/*Reads the peak resident set size of the process
+	*
+	* Returns the peak resident set size in bytes, 0 if the platform can't report it
+	*/
+	uint64_t peakRss() {
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return counters.PeakWorkingSetSize;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+		//macOS reports the peak in bytes, everything else in kilobytes
+		return (uint64_t)usage.ru_maxrss;
+#else
+		return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+	}
+
+
+	/*Records a single timing sample against a stage
+	*
+	* Param stage is the name of the stage that was timed
+	* Param ms is the time the stage took, in milliseconds
+	* Param allocs is the number of heap allocations the stage made
+	* Param bytes is the number of bytes the stage allocated
+	*/
+	void record(const char* stage, double ms, uint64_t allocs, uint64_t bytes) {
+		uncounted_t uncounted;
+		std::lock_guard<std::mutex> guard(stageLock);
+
+		//There are only a handful of stages, so a linear search beats hashing
+		size_t x;
+		for (x = 0; x < stageNames.size(); x++)
+			if (stageNames[x] == stage) break;
+		if (x == stageNames.size()) {
+			stageNames.push_back(stage);
+			stageStats.push_back({ std::vector<double>(), 0, 0 });
+		}
+
+		stageStats[x].samples.push_back(ms);
+		stageStats[x].allocs += allocs;
+		stageStats[x].bytes += bytes;
+	}
+
+
+	/*Picks a percentile out of a sorted list of samples using the nearest-rank method
+	*
+	* Param sorted is the list of samples in ascending order, not empty
+	* Param pct is the percentile to pick, between 0 and 100
+	* Returns the sample at that percentile
+	*/
+	static double percentile(const std::vector<double>& sorted, double pct) {
+		size_t rank = (size_t)(pct / 100.0 * sorted.size() + 0.999999);
+		if (rank < 1) rank = 1;
+		if (rank > sorted.size()) rank = sorted.size();
+		return sorted[rank - 1];
+	}
+
+
+	/*Writes the aggregated timings of every stage to a JSON file. Each stage reports
+	*  its count, total, min, max, p50 and p99 in milliseconds, in the order the stages
+	*  first ran. Each file reports the time spent on it. When memory is set, stages and
+	*  files also report their allocation counts and bytes, and the process its peak RSS
+	*
+	* Param path is the location of the JSON report, which will be overwritten
+	*/
+	void writeReport(std::string path) {
+		std::lock_guard<std::mutex> guard(stageLock);
+
+		std::ofstream out(path, std::ios::out | std::ios::trunc);
+		if (!out.is_open()) throw "prof::writeReport(): Error opening stats file " + path;
+
+		char line[512];
+		out << "{\n  \"unit\": \"ms\",\n";
+		if (memory) {
+			snprintf(line, sizeof(line), "  \"peakRssBytes\": %llu,\n",
+				(unsigned long long)peakRss());
+			out << line;
+		}
+
+		out << "  \"stages\": [\n";
+		for (size_t x = 0; x < stageNames.size(); x++) {
+			std::vector<double> sorted = stageStats[x].samples;
+			std::sort(sorted.begin(), sorted.end());
+			double total = 0;
+			for (double ms : sorted) total += ms;
+
+			snprintf(line, sizeof(line),
+				"    {\"stage\": \"%s\", \"count\": %zu, \"total\": %.6f, \"min\": %.6f, "
+				"\"max\": %.6f, \"p50\": %.6f, \"p99\": %.6f",
+				stageNames[x].c_str(), sorted.size(), total, sorted.front(), sorted.back(),
+				percentile(sorted, 50), percentile(sorted, 99)
+			);
+			out << line;
+			if (memory) {
+				snprintf(line, sizeof(line), ", \"allocs\": %llu, \"bytes\": %llu",
+					(unsigned long long)stageStats[x].allocs,
+					(unsigned long long)stageStats[x].bytes
+				);
+				out << line;
+			}
+			out << "}" << (x + 1 < stageNames.size() ? "," : "") << "\n";
+		}
+		out << "  ],\n";
+
+		//File names come from the file system, so escape anything JSON can't hold raw
+		out << "  \"files\": [\n";
+		for (size_t x = 0; x < fileStats.size(); x++) {
+			snprintf(line, sizeof(line), "    {\"file\": \"%s\", \"ms\": %.6f",
+				escapeJson(fileStats[x].file).c_str(), fileStats[x].ms);
+			out << line;
+			if (memory) {
+				snprintf(line, sizeof(line), ", \"allocs\": %llu, \"bytes\": %llu",
+					(unsigned long long)fileStats[x].allocs,
+					(unsigned long long)fileStats[x].bytes
+				);
+				out << line;
+			}
+			out << "}" << (x + 1 < fileStats.size() ? "," : "") << "\n";
+		}
+		out << "  ]\n}\n";
+
+		out.close();
+		if (!out) throw "prof::writeReport(): Error writing stats file " + path;
+	}
+
+
+
+	/*Writes every recorded span to a JSON file in the Chrome Trace Event format, for
+	*  viewing in Perfetto or chrome://tracing. Stages are grouped into the categories
+	*  parse, layout, frame, text, bars, encode and write, each file gets a span of its
+	*  own, and every thread gets its own track
+	*
+	* Param path is the location of the trace file, which will be overwritten
+	*/
+	void writeTrace(std::string path) {
+		std::lock_guard<std::mutex> guard(stageLock);
+
+		std::ofstream out(path, std::ios::out | std::ios::trunc);
+		if (!out.is_open()) throw "prof::writeTrace(): Error opening trace file " + path;
+
+		char line[256];
+		out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+
+		//Name each thread's track so the main thread is easy to pick out
+		int threads = threadCount;
+		for (int x = 0; x < threads; x++) {
+			std::string name = x == 0 ? "main" : "worker " + std::to_string(x);
+			snprintf(line, sizeof(line),
+				"{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+				"\"args\": {\"name\": \"%s\"}},\n",
+				x, name.c_str()
+			);
+			out << line;
+		}
+
+		for (size_t x = 0; x < traceEvents.size(); x++) {
+			const traceEvent_t& event = traceEvents[x];
+			snprintf(line, sizeof(line),
+				"\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+				"\"pid\": 1, \"tid\": %d}%s\n",
+				event.category, event.start, event.duration, event.thread,
+				x + 1 < traceEvents.size() ? "," : ""
+			);
+			out << "{\"name\": \"" << escapeJson(event.name) << line;
+		}
+		out << "]}\n";
+
+		out.close();
+		if (!out) throw "prof::writeTrace(): Error writing trace file " + path;
+	}
+
+}
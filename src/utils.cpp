@@ -0,0 +1,620 @@
+#include <string>
+#include <string_view>
+#include <cmath>
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <mutex>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ABR_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "../utils.h"
+
+
+namespace util {
+
+	thread_local displayList_t* recording = nullptr;
+
+
+	//This struct is the batch-wide string table. The strings live in a deque so they
+	// never move, which lets the index key on views of them and lets a lookup hash the
+	// caller's string without copying it
+	struct internTable_t {
+		std::shared_mutex lock;
+		std::deque<std::string> texts;
+		std::unordered_map<std::string_view, textId_t> ids;
+	};
+
+	//The table is built on first use so interning is safe from other static initializers
+	static internTable_t& internTable() {
+		static internTable_t table;
+		return table;
+	}
+
+
+	/*Finds the ID of a string in the batch-wide string table, adding it if it hasn't
+	*  been seen before. The same text always gets the same ID for the rest of the run,
+	*  so labels, file names and other repeated text can be compared and hashed as
+	*  integers. Safe to call from any thread
+	*
+	* Param text is the string being interned
+	* Returns the ID of the string
+	*/
+	textId_t intern(const std::string& text) {
+		internTable_t& table = internTable();
+
+		//Almost every lookup is for a string that's already there, so look first under
+		// a shared lock
+		{
+			std::shared_lock<std::shared_mutex> guard(table.lock);
+			auto found = table.ids.find(std::string_view(text));
+			if (found != table.ids.end()) return found->second;
+		}
+
+		//Another thread may have added it between the locks, so check again
+		std::unique_lock<std::shared_mutex> guard(table.lock);
+		auto found = table.ids.find(std::string_view(text));
+		if (found != table.ids.end()) return found->second;
+
+		textId_t id = (textId_t)table.texts.size();
+		table.texts.push_back(text);
+		table.ids.emplace(std::string_view(table.texts.back()), id);
+		return id;
+	}
+
+
+	/*Looks up the string behind an interned ID
+	*
+	* Precondition: id was returned by intern
+	*
+	* Param id is the ID of the string
+	* Returns the interned string, which stays valid for the rest of the run
+	*/
+	const std::string& internedText(textId_t id) {
+		internTable_t& table = internTable();
+		std::shared_lock<std::shared_mutex> guard(table.lock);
+		return table.texts[id];
+	}
+
+
+	//This struct identifies a rendered text by everything that changes how it looks
+	struct textKey_t {
+		SDL_Renderer* renderer;
+		TTF_Font* font;
+		uint32_t rgb;
+		textId_t text;
+		int size, angle;
+
+		bool operator==(const textKey_t& other) const {
+			return renderer == other.renderer && font == other.font &&
+				rgb == other.rgb && text == other.text &&
+				size == other.size && angle == other.angle;
+		}
+	};
+
+	//Hashes a text key by mixing its fields together
+	struct textKeyHash_t {
+		size_t operator()(const textKey_t& key) const {
+			size_t hash = std::hash<const void*>()(key.renderer);
+			hash = hash * 31 + std::hash<const void*>()(key.font);
+			hash = hash * 31 + key.rgb;
+			hash = hash * 31 + key.text;
+			return (hash * 31 + key.size) * 31 + key.angle;
+		}
+	};
+
+	//This struct holds a piece of text that has already been rendered to a texture.
+	// Rotated text also keeps where its pivot sits, from the texture's top-left corner
+	struct cachedText_t {
+		SDL_Texture* texture;
+		int w, h;
+		SDL_Point pivot;
+	};
+
+	//A batch draws the same axis marks, keys and names over and over, so most lookups
+	// hit and skip rendering the glyphs and creating a texture. Entries belong to the
+	// renderer that drew them, so they're only reused while that renderer lives: banded
+	// drawing keeps one renderer per worker for the whole batch for this reason
+	static thread_local std::unordered_map<textKey_t, cachedText_t, textKeyHash_t> textCache;
+
+	//Past this many texts the cache is emptied, to bound the memory held by textures
+	static const size_t TEXT_CACHE_LIMIT = 1024;
+
+
+	/*Destroys every texture held by this thread's cache and empties it*/
+	static void clearTextCache() {
+		for (auto& entry : textCache) SDL_DestroyTexture(entry.second.texture);
+		textCache.clear();
+	}
+
+
+	/*Finds the texture for a piece of text, rendering it and keeping it for later if it
+	*  hasn't been drawn before. Each thread keeps its own cache, since a renderer and
+	*  its textures may only be used on one thread
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer != nullptr AND
+	*		font != nullptr
+	* Postcondition: The texture stays valid until releaseTextCache is called for renderer
+	*
+	* Param renderer is the SDL_Renderer the texture will be drawn with
+	* Param font is the TTF_Font the text is rendered in
+	* Param text is the interned ID of the text being rendered
+	* Param color is the color of the text (the alpha value is ignored)
+	* Param w is populated with the width of the rendered text in pixels
+	* Param h is populated with the height of the rendered text in pixels
+	* Returns the texture holding the rendered text, owned by the cache
+	*/
+	SDL_Texture* cachedText(
+		SDL_Renderer* renderer, TTF_Font* font, textId_t text, color_t color, int* w, int* h
+		) {
+		textKey_t key = {
+			renderer, font,
+			(uint32_t)((color.r & 0xFF) << 16 | (color.g & 0xFF) << 8 | (color.b & 0xFF)),
+			text, 0, 0
+		};
+		auto found = textCache.find(key);
+		if (found != textCache.end()) {
+			*w = found->second.w;
+			*h = found->second.h;
+			return found->second.texture;
+		}
+
+		//Render the text and turn it into a texture for this renderer
+		SDL_Color clr = { (Uint8)color.r, (Uint8)color.g, (Uint8)color.b, 255 };
+		SDL_Surface* textSurface = TTF_RenderText_Blended(font, internedText(text).c_str(), clr);
+		if (!textSurface) throw "util::cachedText(): " + (std::string)TTF_GetError();
+		SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
+		cachedText_t entry = { textTexture, textSurface->w, textSurface->h, { 0, 0 } };
+		SDL_FreeSurface(textSurface);
+		if (!textTexture) throw "util::cachedText(): " + (std::string)SDL_GetError();
+
+		if (textCache.size() >= TEXT_CACHE_LIMIT) clearTextCache();
+		textCache.emplace(key, entry);
+
+		*w = entry.w;
+		*h = entry.h;
+		return textTexture;
+	}
+
+
+	/*Finds the box that a w x h rectangle covers once it's turned about its top-left
+	*  corner, the same box cachedRotatedText draws rotated text into
+	*
+	* Param w is the width of the rectangle
+	* Param h is the height of the rectangle
+	* Param angle is the angle (in degrees) the rectangle is turned clockwise
+	* Param box is populated with the covered box, relative to the top-left corner
+	*/
+	void rotatedBox(int w, int h, int angle, SDL_Rect* box) {
+		double rad = angle * 3.14159265358979323846 / 180.0, cosA = std::cos(rad), sinA = std::sin(rad);
+		double minX = 0, minY = 0, maxX = 0, maxY = 0;
+		const double corners[3][2] = { { (double)w, 0 }, { 0, (double)h }, { (double)w, (double)h } };
+		for (const auto& corner : corners) {
+			double cx = corner[0] * cosA - corner[1] * sinA;
+			double cy = corner[0] * sinA + corner[1] * cosA;
+			minX = std::min(minX, cx); maxX = std::max(maxX, cx);
+			minY = std::min(minY, cy); maxY = std::max(maxY, cy);
+		}
+
+		//Rounding error would otherwise add an empty row or column at right angles
+		const double slack = 1e-9;
+		box->x = (int)std::floor(minX + slack);
+		box->y = (int)std::floor(minY + slack);
+		box->w = (int)std::ceil(maxX - slack) - box->x;
+		box->h = (int)std::ceil(maxY - slack) - box->y;
+	}
+
+
+	/*Scales and rotates a surface into a new one, the way SDL_RenderCopyEx would draw it
+	*  about its top-left corner. Each pixel of the result is sampled from the four source
+	*  pixels around it, weighted by their alpha so the edges of glyphs don't darken
+	*
+	* Precondition: src is a 32 bit ARGB8888 surface AND w > 0 AND h > 0
+	*
+	* Param src is the surface being rotated
+	* Param w is the width src is stretched to before it's rotated
+	* Param h is the height src is stretched to before it's rotated
+	* Param angle is the angle (in degrees) the surface is turned clockwise
+	* Param pivot is populated with where src's top-left corner lands in the result
+	* Returns a newly allocated ARGB8888 surface, to be freed by the caller
+	*/
+	static SDL_Surface* rotateSurface(
+		SDL_Surface* src, int w, int h, int angle, SDL_Point* pivot
+		) {
+		//Find the box the stretched surface's corners land in once turned
+		double rad = angle * 3.14159265358979323846 / 180.0, cosA = std::cos(rad), sinA = std::sin(rad);
+		SDL_Rect box;
+		rotatedBox(w, h, angle, &box);
+		int left = box.x, top = box.y, outW = box.w, outH = box.h;
+
+		SDL_Surface* out = SDL_CreateRGBSurfaceWithFormat(0, outW, outH, 32, SDL_PIXELFORMAT_ARGB8888);
+		if (!out) throw "util::rotateSurface(): " + (std::string)SDL_GetError();
+		*pivot = { -left, -top };
+
+		//Map each pixel of the result back onto the source, turning it the other way
+		// and undoing the stretch. Anything outside the source is transparent
+		double stepX = (double)src->w / w, stepY = (double)src->h / h;
+		auto texel = [&](int sx, int sy) {
+			if (sx < 0 || sy < 0 || sx >= src->w || sy >= src->h) return (Uint32)0;
+			return ((const Uint32*)((const Uint8*)src->pixels + sy * src->pitch))[sx];
+		};
+		for (int v = 0; v < outH; v++) {
+			Uint32* row = (Uint32*)((Uint8*)out->pixels + v * out->pitch);
+			for (int u = 0; u < outW; u++) {
+				double qx = u + left + 0.5, qy = v + top + 0.5;
+				double sx = (qx * cosA + qy * sinA) * stepX - 0.5;
+				double sy = (qy * cosA - qx * sinA) * stepY - 0.5;
+				int x0 = (int)std::floor(sx), y0 = (int)std::floor(sy);
+				double fx = sx - x0, fy = sy - y0;
+
+				double a = 0, r = 0, g = 0, b = 0;
+				const double weights[4] = { (1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy };
+				const Uint32 samples[4] = {
+					texel(x0, y0), texel(x0 + 1, y0), texel(x0, y0 + 1), texel(x0 + 1, y0 + 1)
+				};
+				for (int i = 0; i < 4; i++) {
+					double alpha = weights[i] * (samples[i] >> 24);
+					a += alpha;
+					r += alpha * ((samples[i] >> 16) & 0xFF);
+					g += alpha * ((samples[i] >> 8) & 0xFF);
+					b += alpha * (samples[i] & 0xFF);
+				}
+
+				if (a < 0.5) row[u] = 0;
+				else row[u] = (Uint32)(a + 0.5) << 24 | (Uint32)(r / a + 0.5) << 16 |
+					(Uint32)(g / a + 0.5) << 8 | (Uint32)(b / a + 0.5);
+			}
+		}
+
+		return out;
+	}
+
+
+	/*Finds the texture for a piece of text already scaled to its size and turned to its
+	*  angle, rendering and rotating it once and keeping it for later if it hasn't been
+	*  drawn before. Drawing it afterwards is a plain copy with no per-pixel rotation
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer != nullptr AND
+	*		font != nullptr AND size > 0
+	* Postcondition: The texture stays valid until releaseTextCache is called for renderer
+	*
+	* Param renderer is the SDL_Renderer the texture will be drawn with
+	* Param font is the TTF_Font the text is rendered in
+	* Param text is the interned ID of the text being rendered
+	* Param color is the color of the text (the alpha value is ignored)
+	* Param size is the height of the text before it's turned
+	* Param angle is the angle (in degrees) that the text is turned clockwise
+	* Param w is populated with the width of the texture in pixels
+	* Param h is populated with the height of the texture in pixels
+	* Param pivot is populated with where the text's top-left corner lies in the texture
+	* Returns the texture holding the rotated text, owned by the cache
+	*/
+	SDL_Texture* cachedRotatedText(
+		SDL_Renderer* renderer, TTF_Font* font, textId_t text, color_t color, int size,
+		int angle, int* w, int* h, SDL_Point* pivot
+		) {
+		textKey_t key = {
+			renderer, font,
+			(uint32_t)((color.r & 0xFF) << 16 | (color.g & 0xFF) << 8 | (color.b & 0xFF)),
+			text, size, angle
+		};
+		auto found = textCache.find(key);
+		if (found != textCache.end()) {
+			*w = found->second.w;
+			*h = found->second.h;
+			*pivot = found->second.pivot;
+			return found->second.texture;
+		}
+
+		//Render the text, then stretch and turn it exactly as it will be drawn
+		SDL_Color clr = { (Uint8)color.r, (Uint8)color.g, (Uint8)color.b, 255 };
+		SDL_Surface* textSurface = TTF_RenderText_Blended(font, internedText(text).c_str(), clr);
+		if (!textSurface) throw "util::cachedRotatedText(): " + (std::string)TTF_GetError();
+		if (textSurface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+			SDL_Surface* converted = SDL_ConvertSurfaceFormat(textSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+			SDL_FreeSurface(textSurface);
+			if (!converted) throw "util::cachedRotatedText(): " + (std::string)SDL_GetError();
+			textSurface = converted;
+		}
+
+		cachedText_t entry;
+		int destW = (int)((double)size / textSurface->h * textSurface->w);
+		if (destW <= 0) destW = 1;
+		SDL_Surface* rotated;
+		try {
+			rotated = rotateSurface(textSurface, destW, size, angle, &entry.pivot);
+		}
+		catch (std::string err) {
+			SDL_FreeSurface(textSurface);
+			throw err;
+		}
+		SDL_FreeSurface(textSurface);
+
+		entry.texture = SDL_CreateTextureFromSurface(renderer, rotated);
+		entry.w = rotated->w;
+		entry.h = rotated->h;
+		SDL_FreeSurface(rotated);
+		if (!entry.texture) throw "util::cachedRotatedText(): " + (std::string)SDL_GetError();
+
+		if (textCache.size() >= TEXT_CACHE_LIMIT) clearTextCache();
+		textCache.emplace(key, entry);
+
+		*w = entry.w;
+		*h = entry.h;
+		*pivot = entry.pivot;
+		return entry.texture;
+	}
+
+
+	/*Destroys every cached text texture belonging to a renderer. This must be called on
+	*  the thread that drew with the renderer, before it or any of its fonts are destroyed
+	*
+	* Param renderer is the SDL_Renderer whose cached text is being released
+	*/
+	void releaseTextCache(SDL_Renderer* renderer) {
+		for (auto entry = textCache.begin(); entry != textCache.end();) {
+			if (entry->first.renderer == renderer) {
+				SDL_DestroyTexture(entry->second.texture);
+				entry = textCache.erase(entry);
+			}
+			else entry++;
+		}
+	}
+
+
+
+	workerPool_t::~workerPool_t() {
+		stopPool(this);
+	}
+
+
+	/*Waits for jobs on one of a pool's threads and runs them until the pool is stopped
+	*
+	* Param pool is the pool the thread belongs to
+	* Param worker is the index of the thread's worker, from 1 up
+	*/
+	static void poolThread(workerPool_t* pool, size_t worker) {
+		uint64_t seen = 0;
+		std::unique_lock<std::mutex> guard(pool->lock);
+		while (true) {
+			pool->changed.wait(guard, [&]() { return pool->stopping || pool->generation != seen; });
+			if (pool->stopping) return;
+			seen = pool->generation;
+			if (worker >= pool->workers) continue;
+
+			void (*job)(void*, size_t) = pool->job;
+			void* context = pool->context;
+			guard.unlock();
+			job(context, worker);
+			guard.lock();
+			if (--pool->running == 0) pool->changed.notify_all();
+		}
+	}
+
+
+	/*Starts the threads of a worker pool
+	*
+	* Precondition: pool != nullptr AND pool has no threads running AND workers > 0
+	* Postcondition: pool has workers - 1 threads waiting for a job
+	*
+	* Param pool is the pool being started
+	* Param workers is the number of workers, the thread running each job included
+	*/
+	void startPool(workerPool_t* pool, size_t workers) {
+		ABR_DEBUG(2, "startPool():");
+		pool->stopping = false;
+		for (size_t x = 1; x < workers; x++) pool->threads.push_back(std::thread(poolThread, pool, x));
+	}
+
+
+	/*Runs a job on the first few workers of a pool and waits for all of them to finish
+	*  it. The calling thread runs it as worker 0. The job must catch its own errors,
+	*  since nothing is left to catch them on the pool's threads. Handing out a job
+	*  doesn't allocate
+	*
+	* Precondition: pool != nullptr AND job != nullptr
+	*
+	* Param pool is the pool running the job
+	* Param workers is the number of workers that run the job, capped at the pool's size
+	* Param job is called once on each worker with the context and the worker's index
+	* Param context is passed through to the job untouched
+	*/
+	void runPool(workerPool_t* pool, size_t workers, void (*job)(void*, size_t), void* context) {
+		workers = std::max((size_t)1, std::min(workers, pool->threads.size() + 1));
+		if (workers > 1) {
+			std::lock_guard<std::mutex> guard(pool->lock);
+			pool->job = job;
+			pool->context = context;
+			pool->workers = workers;
+			pool->running = workers - 1;
+			pool->generation++;
+			pool->changed.notify_all();
+		}
+
+		job(context, 0);
+
+		if (workers > 1) {
+			std::unique_lock<std::mutex> guard(pool->lock);
+			pool->changed.wait(guard, [&]() { return pool->running == 0; });
+		}
+	}
+
+
+	/*Stops and joins the threads of a worker pool. Stopping a pool that isn't running
+	*  does nothing
+	*
+	* Param pool is the pool being stopped
+	*/
+	void stopPool(workerPool_t* pool) {
+		if (pool->threads.empty()) return;
+		ABR_DEBUG(2, "stopPool():");
+		{
+			std::lock_guard<std::mutex> guard(pool->lock);
+			pool->stopping = true;
+			pool->changed.notify_all();
+		}
+		for (std::thread& th : pool->threads) th.join();
+		pool->threads.clear();
+		pool->stopping = false;
+	}
+
+
+	/*Draws the calls in a display list that touch one horizontal band of the image
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer != nullptr AND
+	*		font != nullptr AND renderer draws onto the band with its top row at y = 0
+	* Postcondition: The band holds its part of the image, list = #list
+	*
+	* Param renderer is the SDL_Renderer drawing onto the band
+	* Param list is the display list being drawn
+	* Param top is the row of the full image at the top of the band
+	* Param height is the number of rows in the band
+	* Param font is the TTF_Font that text is printed in
+	*/
+	void replayBand(
+		SDL_Renderer* renderer, const displayList_t& list, int top, int height, TTF_Font* font
+		) {
+		ABR_DEBUG(2, "replayBand():");
+
+		//Anything drawn above or below the band is clipped away by the band's renderer, so
+		// only the calls whose bounds overlap it need to be drawn at all
+		for (const drawOp_t& op : list.ops) {
+			if (op.bounds.y >= top + height || (long long)op.bounds.y + op.bounds.h <= top)
+				continue;
+
+			if (op.kind == drawOp_t::FILL)
+				fill(renderer, NULL, op.color);
+			else if (op.kind == drawOp_t::LINE)
+				drawLine(
+					renderer, NULL, { op.p0.x, op.p0.y - top }, { op.p1.x, op.p1.y - top }, op.color
+				);
+			else if (op.kind == drawOp_t::RECT)
+				fillRect(
+					renderer, NULL,
+					{ op.bounds.x, op.bounds.y - top, op.bounds.w, op.bounds.h }, op.color
+				);
+			else
+				printText(
+					renderer, NULL, internedText(op.text), op.p0.x, op.p0.y - top, op.size,
+					op.angle, op.color, font, nullptr
+				);
+		}
+	}
+
+
+	//This struct lists the source pixels that make up each pixel along one axis of a
+	// shrunk image. Output pixel i covers source pixels first[i] up to first[i + 1],
+	// each weighted by how much of it falls inside the output pixel
+	struct areaTaps_t {
+		std::vector<int> first;
+		std::vector<int> index;
+		std::vector<float> weight;
+	};
+
+
+	/*Works out which source pixels each output pixel covers along one axis, when srcLen
+	*  pixels are shrunk into dstLen. The weights of each output pixel add up to 1
+	*
+	* Precondition: 0 < dstLen <= srcLen AND taps != nullptr
+	*
+	* Param srcLen is the length of the axis in the source
+	* Param dstLen is the length of the axis in the result
+	* Param taps is populated with each output pixel's source pixels and weights
+	*/
+	static void areaTaps(int srcLen, int dstLen, areaTaps_t* taps) {
+		taps->first.clear();
+		taps->index.clear();
+		taps->weight.clear();
+		double span = (double)srcLen / dstLen;
+		for (int i = 0; i < dstLen; i++) {
+			taps->first.push_back((int)taps->index.size());
+			double start = i * span, end = (i + 1) * span;
+			for (int s = (int)start; s < srcLen && s < end; s++) {
+				double covered = std::min(end, s + 1.0) - std::max(start, (double)s);
+				if (covered <= 0) continue;
+				taps->index.push_back(s);
+				taps->weight.push_back((float)(covered / span));
+			}
+		}
+		taps->first.push_back((int)taps->index.size());
+	}
+
+
+	/*Shrinks a surface onto a smaller one with an area filter, so each output pixel is
+	*  the average of the source pixels it covers. Each of the four channels is averaged
+	*  on its own, so any 32 bit format works as long as both surfaces share it. The
+	*  source rows for an output row are summed into a single row of totals first, which
+	*  is then reduced across, and on SSE2 a pixel's four channels are summed at once
+	*
+	* Precondition: src and dst are 32 bit surfaces of the same format AND
+	*		0 < dst->w <= src->w AND 0 < dst->h <= src->h
+	* Postcondition: dst holds src shrunk to its size, src = #src
+	*
+	* Param src is the surface being shrunk
+	* Param dst is the surface receiving the shrunk image
+	*/
+	void downscaleSurface(SDL_Surface* src, SDL_Surface* dst) {
+		prof::scopedTimer_t timer("downscaleSurface");
+
+		//The taps and the row of totals are kept by each thread for its next image
+		static thread_local areaTaps_t across, down;
+		static thread_local std::vector<float> totals;
+		areaTaps(src->w, dst->w, &across);
+		areaTaps(src->h, dst->h, &down);
+		totals.resize((size_t)src->w * 4);
+
+		for (int y = 0; y < dst->h; y++) {
+			//Add up the rows this output row covers, by their share of it
+			std::fill(totals.begin(), totals.end(), 0.0f);
+			for (int t = down.first[y]; t < down.first[y + 1]; t++) {
+				const Uint32* row = (const Uint32*)((const Uint8*)src->pixels + (size_t)down.index[t] * src->pitch);
+				float weight = down.weight[t];
+#ifdef ABR_HAVE_SSE2
+				const __m128i zero = _mm_setzero_si128();
+				__m128 w = _mm_set1_ps(weight);
+				for (int x = 0; x < src->w; x++) {
+					__m128i pixel = _mm_cvtsi32_si128((int)row[x]);
+					pixel = _mm_unpacklo_epi16(_mm_unpacklo_epi8(pixel, zero), zero);
+					__m128 sum = _mm_loadu_ps(&totals[(size_t)x * 4]);
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_cvtepi32_ps(pixel), w));
+					_mm_storeu_ps(&totals[(size_t)x * 4], sum);
+				}
+#else
+				for (int x = 0; x < src->w; x++) {
+					Uint32 pixel = row[x];
+					for (int c = 0; c < 4; c++)
+						totals[(size_t)x * 4 + c] += ((pixel >> (c * 8)) & 0xFF) * weight;
+				}
+#endif
+			}
+
+			//Then add up the columns each output pixel covers along the row of totals
+			Uint32* out = (Uint32*)((Uint8*)dst->pixels + (size_t)y * dst->pitch);
+			for (int x = 0; x < dst->w; x++) {
+#ifdef ABR_HAVE_SSE2
+				__m128 sum = _mm_setzero_ps();
+				for (int t = across.first[x]; t < across.first[x + 1]; t++)
+					sum = _mm_add_ps(sum, _mm_mul_ps(
+						_mm_loadu_ps(&totals[(size_t)across.index[t] * 4]), _mm_set1_ps(across.weight[t])
+					));
+				__m128i channels = _mm_cvtps_epi32(sum);
+				channels = _mm_packs_epi32(channels, channels);
+				out[x] = (Uint32)_mm_cvtsi128_si32(_mm_packus_epi16(channels, channels));
+#else
+				float sum[4] = { 0, 0, 0, 0 };
+				for (int t = across.first[x]; t < across.first[x + 1]; t++)
+					for (int c = 0; c < 4; c++)
+						sum[c] += totals[(size_t)across.index[t] * 4 + c] * across.weight[t];
+				Uint32 pixel = 0;
+				for (int c = 0; c < 4; c++)
+					pixel |= (Uint32)std::min(255L, std::max(0L, std::lround(sum[c]))) << (c * 8);
+				out[x] = pixel;
+#endif
+			}
+		}
+	}
+
+}
@@ -7,8 +7,38 @@
 #include <SDL_ttf.h>
 #include <vector>
 #include <string>
+#include <stdint.h>
+#include <cstdlib>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "./configuration.h"
+#include "./profiler.h"
+
+
+//The highest debug verbosity compiled into the program. Release builds compile every
+// debug statement out, debug builds keep all of them. Define this to override
+#ifndef ABR_MAX_VERBOSITY
+#ifdef NDEBUG
+#define ABR_MAX_VERBOSITY 0
+#else
+#define ABR_MAX_VERBOSITY 3
+#endif
+#endif
+
+//Prints a debug message when the requested verbosity is enabled. The message is only
+// built when it will actually be printed, and a statement above ABR_MAX_VERBOSITY
+// compiles to nothing
+//  1 - Progress through the main program
+//  2 - Steps within each function
+//  3 - Per-item detail inside loops
+#define ABR_DEBUG(level, msg) \
+	do { \
+		if ((level) <= ABR_MAX_VERBOSITY && util::ABR_RUN_DEBUG >= (level)) \
+			util::debug((level), (msg)); \
+	} while (0)
 
 
 namespace util {
@@ -20,16 +50,57 @@ namespace util {
 	};
 
 
-	/*Prints out a debug message to the console
+	//Interned strings are referred to by a small integer ID
+	typedef uint32_t textId_t;
+
+
+	//This struct is one drawing call saved to a display list. The bounds are the box of
+	// pixels the call can touch, so a part of the image can skip the calls outside it
+	struct drawOp_t {
+		enum kind_t { FILL, LINE, RECT, TEXT } kind;
+		SDL_Rect bounds;
+		SDL_Point p0, p1;
+		color_t color;
+		textId_t text;
+		int size, angle;
+	};
+
+	//This struct holds drawing calls in the order they were made, to be drawn later
+	struct displayList_t {
+		std::vector<drawOp_t> ops;
+	};
+
+	//While this is set, the drawing helpers on this thread add their calls to the list
+	// rather than drawing them
+	extern thread_local displayList_t* recording;
+
+
+	//This struct holds worker threads that stay alive from one job to the next, so
+	// whatever each of them keeps per thread, such as its text cache, outlives the job.
+	// The thread that runs a job is always worker 0, and the pool's threads are the rest
+	struct workerPool_t {
+		std::vector<std::thread> threads;
+		std::mutex lock;
+		std::condition_variable changed;
+		void (*job)(void* context, size_t worker) = nullptr;
+		void* context = nullptr;
+		size_t workers = 0, running = 0;
+		uint64_t generation = 0;
+		bool stopping = false;
+
+		~workerPool_t();
+	};
+
+
+	/*Prints out a debug message to the console. Call this through ABR_DEBUG so that
+	*  the message is never built when it won't be printed
 	* 
 	* Param verbosity is the verbosity level required to print this statement
-	* Param msg is the debug message being printed
-	*
 	* Param msg is the debug message being printed. This is written to the console
-	*  only if the system is in debug mode
+	*  only if the system is running at or above the given verbosity
 	*/
-	static void debug(int verbosity, std::string msg) {
-		if (ABR_RUN_DEBUG) std::cout << msg << std::endl;
+	static void debug(int verbosity, const std::string& msg) {
+		if (ABR_RUN_DEBUG >= verbosity) std::cout << msg << std::endl;
 		return;
 	}
 
@@ -43,7 +114,7 @@ namespace util {
 	*/
 	static SDL_Window* generateWindow() {
 		//Generate the SDL Window
-		debug(1, "GenerateWindow():");
+		ABR_DEBUG(2, "GenerateWindow():");
 		SDL_Window* window = SDL_CreateWindow(
 			"AbrPrint",
 			SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
@@ -56,7 +127,7 @@ namespace util {
 
 		//Raise the window and return
 		//SDL_RaiseWindow(window);
-		debug(1, "  Window properly generated, returning...");
+		ABR_DEBUG(2, "  Window properly generated, returning...");
 		return window;
 	}
 
@@ -65,52 +136,65 @@ namespace util {
 	*
 	* Precondition: SDL2 must already be initialized AND window != nullptr
 	*
-	* Param window is a pointer to the SDL2 window that the renderer will render to
+	* Param surface is a pointer that will be populated with the renderer's target surface
+	* Param width is the width of the target surface in pixels
+	* Param height is the height of the target surface in pixels
 	* Returns a pointer to the new SDL2 Renderer
 	*/
-	static SDL_Renderer* generateRenderer(SDL_Surface** surface) {
-		debug(1, "generateRenderer():");
+	static SDL_Renderer* generateRenderer(SDL_Surface** surface, int width, int height) {
+		ABR_DEBUG(2, "generateRenderer():");
 
 		//Generate the SDL Renderer
 		Uint32 RMASK, GMASK, BMASK, AMASK;
 
-		debug(1, "  Determining RGBA Masks based on system byte order");
+		ABR_DEBUG(2, "  Determining RGBA Masks based on system byte order");
 		if (SDL_BYTEORDER == SDL_LIL_ENDIAN) {
-			debug(1, "    System is Little Endian");
+			ABR_DEBUG(3, "    System is Little Endian");
 			RMASK = 0x000000FF;
 			GMASK = 0x0000FF00;
 			BMASK = 0x00FF0000;
 			AMASK = 0xFF000000;
 		}
 		else if (SDL_BYTEORDER == SDL_BIG_ENDIAN) {
-			debug(1, "    System is Big Endian");
+			ABR_DEBUG(3, "    System is Big Endian");
 			RMASK = 0xFF000000;
 			GMASK = 0x00FF0000;
 			BMASK = 0x0000FF00;
 			AMASK = 0x000000FF;
 		}
 		else {
-			debug(1, "    How is your system neither big nor little endian? mom come pick me up im scared");
+			ABR_DEBUG(3, "    How is your system neither big nor little endian? mom come pick me up im scared");
 			throw "How is your computer neither big or little endian";
 		}
 
-		debug(1, "  Generating SDL Surface for renderer");
+		ABR_DEBUG(2, "  Generating SDL Surface for renderer");
 		SDL_Surface* surf = SDL_CreateRGBSurface(
-			0, util::IMG_W, util::IMG_H, 32, RMASK, GMASK, BMASK, AMASK
+			0, width, height, 32, RMASK, GMASK, BMASK, AMASK
 		);
+		if (!surf) throw "util::generateRenderer(): " + (std::string)SDL_GetError();
 
-		debug(1, "  Instantiating software renderer");
+		ABR_DEBUG(2, "  Instantiating software renderer");
 		SDL_Renderer* renderer = SDL_CreateSoftwareRenderer(surf);
 
 		//Ensure the renderer was successfully created
 		if (!renderer) throw "util::generateRenderer(): " + (std::string)SDL_GetError();
 
-		debug(1, "  Renderer successfully created, storing surface and returning...");
+		ABR_DEBUG(2, "  Renderer successfully created, storing surface and returning...");
 		*surface = surf;
 		return renderer;
 	}
 
 
+	/*Constructs an SDL_Renderer pointer sized to the configured image dimensions
+	*
+	* Param surface is a pointer that will be populated with the renderer's target surface
+	* Returns a pointer to the new SDL2 Renderer
+	*/
+	static SDL_Renderer* generateRenderer(SDL_Surface** surface) {
+		return generateRenderer(surface, IMG_W, IMG_H);
+	}
+
+
 	/*Constructs an SDL_Testure pointer that will have all data printed onto it for
 	* the duration of the program
 	*
@@ -118,29 +202,41 @@ namespace util {
 	* Postcondition: renderer will be retargeted to render to the window
 	*
 	* Param renderer is the renderer that the texture will link to
+	* Param width is the width of the texture in pixels
+	* Param height is the height of the texture in pixels
 	* Returns a pointer to a texture created, attached to the renderer
 	*/
-	static SDL_Texture* generateTexture(SDL_Renderer* renderer) {
-		debug(1, "generateTexture():");
+	static SDL_Texture* generateTexture(SDL_Renderer* renderer, int width, int height) {
+		ABR_DEBUG(2, "generateTexture():");
 
 		//Generate the SDL Texture
-		debug(1, "  Instantiating SDL_Texture");
+		ABR_DEBUG(2, "  Instantiating SDL_Texture");
 		SDL_Texture* texture =
 			SDL_CreateTexture(
 				renderer,
 				SDL_PIXELFORMAT_RGBA8888,
 				SDL_TEXTUREACCESS_TARGET,
-				IMG_W, IMG_H
+				width, height
 			);
 
 		//Ensure that the texture was created successfully
 		if (!texture) throw "util::generateTexture(): " + (std::string)SDL_GetError();
 
-		debug(1, "  Texture properly generated, returning...");
+		ABR_DEBUG(2, "  Texture properly generated, returning...");
 		return texture;
 	}
 
 
+	/*Constructs an SDL_Texture pointer sized to the configured image dimensions
+	*
+	* Param renderer is the renderer that the texture will link to
+	* Returns a pointer to a texture created, attached to the renderer
+	*/
+	static SDL_Texture* generateTexture(SDL_Renderer* renderer) {
+		return generateTexture(renderer, IMG_W, IMG_H);
+	}
+
+
 	/*Renders a provided texture to the window's surface
 	*
 	* Precondition: SDL2 is already initialized AND renderer != nullptr AND texture != nullptr
@@ -149,15 +245,19 @@ namespace util {
 	* Param texture is the texture being rendered onto the display window0
 	*/
 	static void renderTexture(SDL_Renderer* renderer, SDL_Texture* texture) {
-		debug(1, "renderTexture():");
+		ABR_DEBUG(2, "renderTexture():");
+		prof::scopedTimer_t timer("renderTexture");
+
+		//A recorded graph isn't on any texture yet
+		if (recording) return;
 
 		//Store the texture's dimensions
-		debug(1, "  Creating an SDL_Rect to store dimensional data for the graph");
+		ABR_DEBUG(2, "  Creating an SDL_Rect to store dimensional data for the graph");
 		SDL_Rect rect;
 		rect.x = 0; rect.y = 0;
-		rect.w = IMG_W; rect.h = IMG_H;
+		SDL_QueryTexture(texture, NULL, NULL, &rect.w, &rect.h);
 
-		debug(1, "  Rendering the texture's data to the rect");
+		ABR_DEBUG(2, "  Rendering the texture's data to the rect");
 		try {
 			SDL_RenderClear(renderer);
 			SDL_RenderCopy(renderer, texture, NULL, &rect);
@@ -167,7 +267,7 @@ namespace util {
 			throw "util::renderTexture(): " + (std::string)SDL_GetError();
 		}
 
-		debug(1, "  Texture properly rendered, returning...");
+		ABR_DEBUG(2, "  Texture properly rendered, returning...");
 		return;
 	}
 
@@ -187,20 +287,29 @@ namespace util {
 		SDL_Renderer* renderer, SDL_Texture* texture, SDL_Point p0,
 		SDL_Point p1, color_t color
 		) {
-		debug(1, "drawLine()");
+		ABR_DEBUG(2, "drawLine()");
+
+		if (recording) {
+			SDL_Rect bounds = {
+				std::min(p0.x, p1.x), std::min(p0.y, p1.y),
+				std::abs(p1.x - p0.x) + 1, std::abs(p1.y - p0.y) + 1
+			};
+			recording->ops.push_back({ drawOp_t::LINE, bounds, p0, p1, color, 0, 0, 0 });
+			return;
+		}
 
 		//Set the render target to the texture and set the render color
-		debug(1, "  Directing renderer to texture and providing a draw color");
+		ABR_DEBUG(2, "  Directing renderer to texture and providing a draw color");
 		SDL_SetRenderTarget(renderer, texture);
 		SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 
 		//Draw the line to the surface, exiting if this fails
-		debug(1, "  Attmepting to draw the line to the texture");
+		ABR_DEBUG(2, "  Attmepting to draw the line to the texture");
 		if (SDL_RenderDrawLine(renderer, p0.x, p0.y, p1.x, p1.y) != 0)
 			throw "util::renderTest(): " + (std::string)SDL_GetError();
 
 		//Reset the render target to the provided window, exiting if this fails
-		debug(1, "  Directing renderer away from the texture and returning...");
+		ABR_DEBUG(2, "  Directing renderer away from the texture and returning...");
 		if (SDL_SetRenderTarget(renderer, NULL) != 0)
 			throw "util::renderTest(): " + (std::string)SDL_GetError();
 
@@ -223,19 +332,19 @@ namespace util {
 	static void drawPolygon(
 		SDL_Renderer* renderer, SDL_Texture* texture, polygon_t polygon, color_t color
 		) {
-		debug(1, "drawPolygon():");
+		ABR_DEBUG(2, "drawPolygon():");
 
 		//Draw each line in the polygon
-		debug(1, "  Iterating through lines in the polygon");
+		ABR_DEBUG(2, "  Iterating through lines in the polygon");
 		for (int x = 0; x < polygon.numPoints - 1; x++) {
-			debug(1, "    Drawing line from (" + std::to_string(polygon.pointArr[x].x) + ", " +
+			ABR_DEBUG(3, "    Drawing line from (" + std::to_string(polygon.pointArr[x].x) + ", " +
 				std::to_string(polygon.pointArr[x].y) + ") to (" + std::to_string(polygon.pointArr[x + 1].x) +
 				", " + std::to_string(polygon.pointArr[x + 1].y) + ")");
 
 			drawLine(renderer, texture, polygon.pointArr[x], polygon.pointArr[x + 1], color);
 		}
 
-		debug(1, "  Polygon properly drawn, returning...");
+		ABR_DEBUG(2, "  Polygon properly drawn, returning...");
 		return;
 	}
 
@@ -255,18 +364,23 @@ namespace util {
 	static void fillRect(
 		SDL_Renderer* renderer, SDL_Texture* texture, SDL_Rect rect, const color_t color
 		) {
-		debug(1, "fillRect():");
+		ABR_DEBUG(2, "fillRect():");
+
+		if (recording) {
+			recording->ops.push_back({ drawOp_t::RECT, rect, {}, {}, color, 0, 0, 0 });
+			return;
+		}
 
 		//Set the render target to the texture and set the render color
-		debug(1, "  Assignment render target and providing draw color");
+		ABR_DEBUG(2, "  Assignment render target and providing draw color");
 		SDL_SetRenderTarget(renderer, texture);
 		SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 
-		debug(1, "  Filling provided rect onto the texture");
+		ABR_DEBUG(2, "  Filling provided rect onto the texture");
 		if (SDL_RenderFillRect(renderer, &rect) != 0)
 			throw "util::fillRect(): " + (std::string)SDL_GetError();
 
-		debug(1, "  Directing renderer away from the texture and returning...");
+		ABR_DEBUG(2, "  Directing renderer away from the texture and returning...");
 		if (SDL_SetRenderTarget(renderer, NULL) != 0)
 			throw "util::fillRect(): " + (std::string)SDL_GetError();
 
@@ -285,19 +399,25 @@ namespace util {
 	* Param color is the color filling the surface
 	*/
 	static void fill(SDL_Renderer* renderer, SDL_Texture* texture, color_t color) {
-		debug(1, "fill():");
+		ABR_DEBUG(2, "fill():");
+
+		if (recording) {
+			SDL_Rect everything = { 0, 0, INT32_MAX, INT32_MAX };
+			recording->ops.push_back({ drawOp_t::FILL, everything, {}, {}, color, 0, 0, 0 });
+			return;
+		}
 
 		//Set the render target to the texture and set the render color
-		debug(1, "  Directing renderer to the texture and giving it a render color");
+		ABR_DEBUG(2, "  Directing renderer to the texture and giving it a render color");
 		SDL_SetRenderTarget(renderer, texture);
 		SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 
 		//Fill the texture with the color
-		debug(1, "  Filling the texture with a single color");
+		ABR_DEBUG(2, "  Filling the texture with a single color");
 		if (SDL_RenderFillRect(renderer, NULL) != 0)
 			throw "util::fill(): " + (std::string)SDL_GetError();
 
-		debug(1, "  Directing the renderer away from the texture and returning...");
+		ABR_DEBUG(2, "  Directing the renderer away from the texture and returning...");
 		if (SDL_SetRenderTarget(renderer, NULL) != 0)
 			throw "util::fill(): " + (std::string)SDL_GetError();
 
@@ -314,20 +434,182 @@ namespace util {
 	* Param size is the size of the font being loaded
 	* Returns a pointer to the TTF_Font that contains the loaded typeface information
 	*/
-	static TTF_Font* getFont(std::string fontName, int size) {
-		debug(1, "getFont():");
+	static TTF_Font* getFont(const std::string& fontName, int size) {
+		ABR_DEBUG(2, "getFont():");
 
 		//Create the font pointer
-		debug(1, "  Attempting to open the font file");
-		TTF_Font* font = TTF_OpenFont((ABR_TYPEFACE_DIR + fontName + ".ttf").c_str(), 24);
+		ABR_DEBUG(2, "  Attempting to open the font file");
+		TTF_Font* font = TTF_OpenFont((ABR_TYPEFACE_DIR + fontName + ".ttf").c_str(), size);
 		if (!font) throw "util::getFont(): " + (std::string)TTF_GetError();
 
 		//Return the font
-		debug(1, "  Font successfully loaded, returning...");
+		ABR_DEBUG(2, "  Font successfully loaded, returning...");
 		return font;
 	}
 
 
+	/*Finds the ID of a string in the batch-wide string table, adding it if it hasn't
+	*  been seen before. The same text always gets the same ID for the rest of the run,
+	*  so labels, file names and other repeated text can be compared and hashed as
+	*  integers. Safe to call from any thread
+	*
+	* Param text is the string being interned
+	* Returns the ID of the string
+	*/
+	textId_t intern(const std::string& text);
+
+
+	/*Looks up the string behind an interned ID
+	*
+	* Precondition: id was returned by intern
+	*
+	* Param id is the ID of the string
+	* Returns the interned string, which stays valid for the rest of the run
+	*/
+	const std::string& internedText(textId_t id);
+
+
+	/*Finds the texture for a piece of text, rendering it and keeping it for later if it
+	*  hasn't been drawn before. Each thread keeps its own cache, since a renderer and
+	*  its textures may only be used on one thread
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer != nullptr AND
+	*		font != nullptr
+	* Postcondition: The texture stays valid until releaseTextCache is called for renderer
+	*
+	* Param renderer is the SDL_Renderer the texture will be drawn with
+	* Param font is the TTF_Font the text is rendered in
+	* Param text is the interned ID of the text being rendered
+	* Param color is the color of the text (the alpha value is ignored)
+	* Param w is populated with the width of the rendered text in pixels
+	* Param h is populated with the height of the rendered text in pixels
+	* Returns the texture holding the rendered text, owned by the cache
+	*/
+	SDL_Texture* cachedText(
+		SDL_Renderer* renderer, TTF_Font* font, textId_t text, color_t color, int* w, int* h
+	);
+
+
+	/*Finds the texture for a piece of text already scaled to its size and turned to its
+	*  angle, rendering and rotating it once and keeping it for later if it hasn't been
+	*  drawn before. Drawing it afterwards is a plain copy with no per-pixel rotation
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer != nullptr AND
+	*		font != nullptr AND size > 0
+	* Postcondition: The texture stays valid until releaseTextCache is called for renderer
+	*
+	* Param renderer is the SDL_Renderer the texture will be drawn with
+	* Param font is the TTF_Font the text is rendered in
+	* Param text is the interned ID of the text being rendered
+	* Param color is the color of the text (the alpha value is ignored)
+	* Param size is the height of the text before it's turned
+	* Param angle is the angle (in degrees) that the text is turned clockwise
+	* Param w is populated with the width of the texture in pixels
+	* Param h is populated with the height of the texture in pixels
+	* Param pivot is populated with where the text's top-left corner lies in the texture
+	* Returns the texture holding the rotated text, owned by the cache
+	*/
+	SDL_Texture* cachedRotatedText(
+		SDL_Renderer* renderer, TTF_Font* font, textId_t text, color_t color, int size,
+		int angle, int* w, int* h, SDL_Point* pivot
+	);
+
+
+	/*Destroys every cached text texture belonging to a renderer. This must be called on
+	*  the thread that drew with the renderer, before it or any of its fonts are destroyed
+	*
+	* Param renderer is the SDL_Renderer whose cached text is being released
+	*/
+	void releaseTextCache(SDL_Renderer* renderer);
+
+
+	/*Draws the calls in a display list that touch one horizontal band of the image
+	*
+	* Precondition: SDL2 and SDL_TTF are initialized AND renderer != nullptr AND
+	*		font != nullptr AND renderer draws onto the band with its top row at y = 0
+	* Postcondition: The band holds its part of the image, list = #list
+	*
+	* Param renderer is the SDL_Renderer drawing onto the band
+	* Param list is the display list being drawn
+	* Param top is the row of the full image at the top of the band
+	* Param height is the number of rows in the band
+	* Param font is the TTF_Font that text is printed in
+	*/
+	void replayBand(
+		SDL_Renderer* renderer, const displayList_t& list, int top, int height, TTF_Font* font
+	);
+
+
+	/*Starts the threads of a worker pool
+	*
+	* Precondition: pool != nullptr AND pool has no threads running AND workers > 0
+	* Postcondition: pool has workers - 1 threads waiting for a job
+	*
+	* Param pool is the pool being started
+	* Param workers is the number of workers, the thread running each job included
+	*/
+	void startPool(workerPool_t* pool, size_t workers);
+
+
+	/*Runs a job on the first few workers of a pool and waits for all of them to finish
+	*  it. The calling thread runs it as worker 0. The job must catch its own errors,
+	*  since nothing is left to catch them on the pool's threads. Handing out a job
+	*  doesn't allocate
+	*
+	* Precondition: pool != nullptr AND job != nullptr
+	*
+	* Param pool is the pool running the job
+	* Param workers is the number of workers that run the job, capped at the pool's size
+	* Param job is called once on each worker with the context and the worker's index
+	* Param context is passed through to the job untouched
+	*/
+	void runPool(workerPool_t* pool, size_t workers, void (*job)(void*, size_t), void* context);
+
+
+	/*Runs a callable job on the first few workers of a pool (see above)
+	*
+	* Param pool is the pool running the job
+	* Param workers is the number of workers that run the job, capped at the pool's size
+	* Param job is called once on each worker with the worker's index
+	*/
+	template <typename job_t>
+	static void runPool(workerPool_t* pool, size_t workers, job_t& job) {
+		runPool(pool, workers, [](void* context, size_t worker) { (*(job_t*)context)(worker); }, &job);
+	}
+
+
+	/*Stops and joins the threads of a worker pool. Stopping a pool that isn't running
+	*  does nothing
+	*
+	* Param pool is the pool being stopped
+	*/
+	void stopPool(workerPool_t* pool);
+
+
+	/*Finds the box that a w x h rectangle covers once it's turned about its top-left
+	*  corner, the same box cachedRotatedText draws rotated text into
+	*
+	* Param w is the width of the rectangle
+	* Param h is the height of the rectangle
+	* Param angle is the angle (in degrees) the rectangle is turned clockwise
+	* Param box is populated with the covered box, relative to the top-left corner
+	*/
+	void rotatedBox(int w, int h, int angle, SDL_Rect* box);
+
+
+	/*Shrinks a surface onto a smaller one with an area filter, so each output pixel is
+	*  the average of the source pixels it covers
+	*
+	* Precondition: src and dst are 32 bit surfaces of the same format AND
+	*		0 < dst->w <= src->w AND 0 < dst->h <= src->h
+	* Postcondition: dst holds src shrunk to its size, src = #src
+	*
+	* Param src is the surface being shrunk
+	* Param dst is the surface receiving the shrunk image
+	*/
+	void downscaleSurface(SDL_Surface* src, SDL_Surface* dst);
+
+
 	/*Prints input text onto a surface
 	*
 	* Precondition: SDL2 must already be initialized AND SDL_TTF must already be initialized AND
@@ -349,49 +631,85 @@ namespace util {
 	*		text's destination (will not work for rotated text)
 	*/
 	static void printText(
-		SDL_Renderer* renderer, SDL_Texture* texture, std::string text,
+		SDL_Renderer* renderer, SDL_Texture* texture, const std::string& text,
 		int x, int y, int size, int angle, color_t color, TTF_Font* font,
 		SDL_Rect* resBlock
 		) {
-		debug(1, "printText():");
+		ABR_DEBUG(2, "printText():");
+		prof::scopedTimer_t timer("printText");
+
+		//Recording only needs the text's size, which can be measured without drawing it
+		if (recording) {
+			int textW, textH;
+			if (TTF_SizeText(font, text.c_str(), &textW, &textH) != 0)
+				throw "util::printText(): " + (std::string)TTF_GetError();
+			SDL_Rect destRect = { x, y, (int)((double)size / textH * textW), size };
+			if (resBlock != nullptr) *resBlock = destRect;
+
+			//Rotated text turns about its top-left corner, and covers exactly the box
+			// cachedRotatedText will draw it into
+			SDL_Rect bounds = destRect;
+			if (angle != 0) {
+				rotatedBox(std::max(destRect.w, 1), size, angle, &bounds);
+				bounds.x += x;
+				bounds.y += y;
+			}
+			recording->ops.push_back({
+				drawOp_t::TEXT, bounds, { x, y }, {}, color, intern(text), size, angle
+			});
+			return;
+		}
 
 		//Set the render target to the texture and set the render color
-		debug(1, "  Directing the renderer to the provided texture");
+		ABR_DEBUG(2, "  Directing the renderer to the provided texture");
 		SDL_SetRenderTarget(renderer, texture);
 
-		//Convert the input color_t value to an SDL_Color object
-		debug(1, "  Compiling the text render color");
-		SDL_Color clr = { color.r, color.g, color.b };
+		//Rotated text is turned once when it's first drawn and cached at its final size
+		// and angle, so from then on it's copied straight onto the texture like any other
+		if (angle != 0) {
+			ABR_DEBUG(2, "  Fetching the rotated text texture");
+			int rotW, rotH;
+			SDL_Point pivot;
+			SDL_Texture* rotTexture = cachedRotatedText(
+				renderer, font, intern(text), color, size, angle, &rotW, &rotH, &pivot
+			);
+
+			if (resBlock != nullptr) {
+				int textW, textH;
+				if (TTF_SizeText(font, text.c_str(), &textW, &textH) != 0)
+					throw "util::printText(): " + (std::string)TTF_GetError();
+				*resBlock = { x, y, (int)((double)size / textH * textW), size };
+			}
+
+			ABR_DEBUG(2, "  Place the text onto its proper place in the destination texture");
+			SDL_Rect destRect = { x - pivot.x, y - pivot.y, rotW, rotH };
+			if (SDL_RenderCopy(renderer, rotTexture, NULL, &destRect) != 0)
+				throw "util::printText(): " + (std::string)SDL_GetError();
 
-		//Create a texture with the text rendered onto it
-		debug(1, "  Create a text surface to render onto the texture");
-		SDL_Surface* finSurface = TTF_RenderText_Blended(font, text.c_str(), clr);
-		if (!finSurface) throw "util::printText(): " + (std::string)TTF_GetError();
-		SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, finSurface);
-		if (!textTexture) throw "util::printText(): " + (std::string)SDL_GetError();
+			SDL_SetRenderTarget(renderer, NULL);
+			return;
+		}
+
+		//Fetch the text already rendered as a texture, rendering it if this is the first use
+		ABR_DEBUG(2, "  Fetching the rendered text texture");
+		int textW, textH;
+		SDL_Texture* textTexture = cachedText(renderer, font, intern(text), color, &textW, &textH);
 
 		//Print the text onto the input texture
-		debug(1, "  Processing the transformation from text source to destination");
-		double ratio = (double)size / finSurface->h;
-		SDL_Rect srcRect = { 0, 0, finSurface->w, finSurface->h };
-		SDL_Rect destRect = { x, y, (int)(ratio * finSurface->w), size };
-		SDL_Point rotPoint = { 0, 0 };
+		ABR_DEBUG(2, "  Processing the transformation from text source to destination");
+		double ratio = (double)size / textH;
+		SDL_Rect srcRect = { 0, 0, textW, textH };
+		SDL_Rect destRect = { x, y, (int)(ratio * textW), size };
 
-		debug(1, "  Placing the text's destination rect in the passed-in argument");
+		ABR_DEBUG(2, "  Placing the text's destination rect in the passed-in argument");
 		if (resBlock != nullptr) *resBlock = destRect;
 
-		debug(1, "  Place the text onto its proper place in the destination texture");
-		if (SDL_RenderCopyEx(
-			renderer, textTexture, &srcRect, &destRect, (double)angle, &rotPoint, SDL_FLIP_NONE
-		) != 0) throw "util::printText(): " + (std::string)SDL_GetError();
-
-		//Cleanup the surfaces
-		debug(1, "  Cleaning up dynamically allocated graphics objects");
-		SDL_DestroyTexture(textTexture);
-		SDL_FreeSurface(finSurface);
+		ABR_DEBUG(2, "  Place the text onto its proper place in the destination texture");
+		if (SDL_RenderCopy(renderer, textTexture, &srcRect, &destRect) != 0)
+			throw "util::printText(): " + (std::string)SDL_GetError();
 
 		//Redirect the renderer to the window
-		debug(1, "  Directing the render target away from the provided surface and returning...");
+		ABR_DEBUG(2, "  Directing the render target away from the provided surface and returning...");
 		SDL_SetRenderTarget(renderer, NULL);
 		return;
 	}
@@ -406,15 +724,15 @@ namespace util {
 	*/
 	template <typename T>
 	static bool contains(const T* container, T item, size_t n) {
-		debug(1, "contains():");
+		ABR_DEBUG(2, "contains():");
 
 		for (size_t x = 0; x < n; x++)
 			if (container[x] == item) {
-				debug(1, "  Item found in container");
+				ABR_DEBUG(2, "  Item found in container");
 				return true;
 			}
 
-		debug(1, "  Item not found in container");
+		ABR_DEBUG(2, "  Item not found in container");
 		return false;
 	}
 
@@ -424,8 +742,8 @@ namespace util {
 	* Param container is the vector that is being printed
 	*/
 	template <typename T>
-	static void printVec(std::vector<T> container) {
-		for (T item : container) std::cout << item << ", ";
+	static void printVec(const std::vector<T>& container) {
+		for (const T& item : container) std::cout << item << ", ";
 		std::cout << std::endl;
 		return;
 	}